@@ -2,71 +2,372 @@
 #include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include <algorithm>
+
+#include "gol/arena.hpp"
 #include "gol/grid.hpp"
+#include "gol/grid_batch.hpp"
+#include "gol/hashlife.hpp"
+#include "gol/macrocell.hpp"
+#include "gol/mapped_grid.hpp"
+#include "gol/plane.hpp"
+#include "gol/recorder.hpp"
+#include "gol/render.hpp"
 #include "gol/rle.hpp"
+#include "gol/runner.hpp"
+#include "gol/snapshot.hpp"
 #include "gol/text_pattern.hpp"
 
 namespace py = pybind11;
 
+namespace {
+
+// Text dumps shared by Grid and Plane; both are drawn over their
+// width x height view.
+template <class Board>
+std::string to_ascii(const Board& g) {
+    std::string result;
+    result.reserve(g.height() * (g.width() + 1));
+    for (size_t y = 0; y < g.height(); ++y) {
+        for (size_t x = 0; x < g.width(); ++x) {
+            result += g.get_cell(x, y) ? '#' : '.';
+        }
+        if (y < g.height() - 1) result += '\n';
+    }
+    return result;
+}
+
+using Snapshot = gol::SimulationRunner::Snapshot;
+
+const gol::Grid& held(const Snapshot& s) {
+    if (!s) throw py::value_error("snapshot was released");
+    return s.grid();
+}
+
+template <class Board>
+std::string to_ascii_region(const Board& g, size_t rx, size_t ry, size_t rw, size_t rh) {
+    std::string result;
+    for (size_t y = ry; y < ry + rh && y < g.height(); ++y) {
+        for (size_t x = rx; x < rx + rw && x < g.width(); ++x) {
+            result += g.get_cell(x, y) ? '#' : '.';
+        }
+        if (y < ry + rh - 1) result += '\n';
+    }
+    return result;
+}
+
+} // namespace
+
 PYBIND11_MODULE(gol_engine, m) {
     m.doc() = "Game of Life C++ engine";
 
+    py::class_<gol::Grid::Stability>(m, "Stability")
+        .def_readonly("settled", &gol::Grid::Stability::settled)
+        .def_readonly("period", &gol::Grid::Stability::period)
+        .def_readonly("start", &gol::Grid::Stability::start);
+
+    py::enum_<gol::BlitMode>(m, "BlitMode")
+        .value("OR", gol::BlitMode::kOr)
+        .value("AND", gol::BlitMode::kAnd)
+        .value("XOR", gol::BlitMode::kXor)
+        .value("COPY", gol::BlitMode::kCopy);
+
+    py::enum_<gol::Symmetry>(m, "Symmetry")
+        .value("NONE", gol::Symmetry::kNone)
+        .value("C2", gol::Symmetry::kC2)
+        .value("C4", gol::Symmetry::kC4)
+        .value("D8", gol::Symmetry::kD8);
+
     py::class_<gol::Grid>(m, "Grid")
         .def(py::init<size_t, size_t>(), py::arg("width"), py::arg("height"))
         .def_property_readonly("width", &gol::Grid::width)
         .def_property_readonly("height", &gol::Grid::height)
-        .def_property_readonly("generation", &gol::Grid::generation)
+        .def_property("generation", &gol::Grid::generation, &gol::Grid::set_generation)
         .def_property_readonly("population", &gol::Grid::population)
+        .def_property_readonly("words_per_row", &gol::Grid::words_per_row)
+        // In-place stepping, about half the memory; see grid.hpp
+        .def_property("low_memory", &gol::Grid::low_memory, &gol::Grid::set_low_memory)
+        .def_property("rule",
+            [](const gol::Grid& g) { return g.rule().to_string(); },
+            [](gol::Grid& g, const std::string& rule) { g.set_rule(gol::Rule::parse(rule)); })
         .def("set_cell", &gol::Grid::set_cell)
         .def("get_cell", &gol::Grid::get_cell)
         .def("step", &gol::Grid::step, py::call_guard<py::gil_scoped_release>())
         .def("step_n", &gol::Grid::step_n, py::arg("n"),
              py::call_guard<py::gil_scoped_release>())
         .def("clear", &gol::Grid::clear)
+        .def("state_hash", &gol::Grid::state_hash)
+        .def("set_checkpoint", &gol::Grid::set_checkpoint,
+             py::arg("path"), py::arg("every"), py::arg("sparse") = true)
+        .def("set_recorder", [](gol::Grid& g, gol::Recorder* recorder) {
+            g.set_recorder(recorder);
+        }, py::arg("recorder").none(true), py::keep_alive<1, 2>())
+        .def("run_until_stable", &gol::Grid::run_until_stable,
+             py::arg("max_generations"), py::arg("max_period") = 1024,
+             py::call_guard<py::gil_scoped_release>())
         .def("randomize", &gol::Grid::randomize,
              py::arg("density") = 0.1, py::arg("seed") = 0,
+             py::arg("symmetry") = gol::Symmetry::kNone,
              py::call_guard<py::gil_scoped_release>())
-        .def("paste", &gol::Grid::paste, py::arg("pattern"), py::arg("x"), py::arg("y"))
+        .def("paste", &gol::Grid::paste, py::arg("pattern"), py::arg("x"), py::arg("y"),
+             py::arg("mode") = gol::BlitMode::kOr, py::call_guard<py::gil_scoped_release>())
         .def("extract", &gol::Grid::extract,
              py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"))
         .def("to_numpy", [](const gol::Grid& g) {
             auto arr = py::array_t<uint8_t>({g.height(), g.width()});
-            auto buf = arr.mutable_unchecked<2>();
-            for (size_t y = 0; y < g.height(); ++y) {
-                for (size_t x = 0; x < g.width(); ++x) {
-                    buf(y, x) = g.get_cell(x, y) ? 1 : 0;
-                }
+            uint8_t* out = arr.mutable_data();
+            {
+                py::gil_scoped_release release;
+                g.unpack(out, g.width());
             }
             return arr;
         })
+        // Any 2D array, nonzero meaning alive. One-byte arrays (bool, uint8,
+        // int8) with contiguous rows are packed in place; others go through
+        // `cells != 0` first.
+        .def_static("from_numpy", [](py::array cells) {
+            if (cells.ndim() != 2) throw py::value_error("from_numpy expects a 2D array");
+            if (cells.itemsize() != 1 || cells.strides(1) != 1 || cells.strides(0) < 0)
+                cells = py::array::ensure(cells.attr("__ne__")(0), py::array::c_style);
+            gol::Grid g(size_t(cells.shape(1)), size_t(cells.shape(0)));
+            const uint8_t* in = static_cast<const uint8_t*>(cells.data());
+            {
+                py::gil_scoped_release release;
+                g.pack(in, size_t(cells.strides(0)));
+            }
+            return g;
+        }, py::arg("cells"))
+        .def("touch", &gol::Grid::touch)
+        // change_count, then changed_since(count) -> [(x, y, w, h)] covering
+        // every cell changed after it
+        .def_property_readonly("change_count", &gol::Grid::change_count)
+        .def("changed_since", [](const gol::Grid& g, uint64_t count) {
+            py::list rects;
+            for (const gol::Grid::Rect& r : g.changed_since(count))
+                rects.append(py::make_tuple(r.x, r.y, r.width, r.height));
+            return rects;
+        }, py::arg("count"))
+        // Packed words are copied both ways: step() moves the cells between
+        // two buffers, so a view of them would not last. Rows are
+        // words_per_row long, padding and bits past the width ignored.
         .def("to_numpy_packed", [](const gol::Grid& g) {
-            return py::array_t<uint64_t>(
-                {g.data_size()},
-                {sizeof(uint64_t)},
-                g.data(),
-                py::cast(g)  // keep grid alive
-            );
+            py::array_t<uint64_t> arr(g.data_size());
+            std::copy(g.data(), g.data() + g.data_size(), arr.mutable_data());
+            return arr;
         })
-        .def("to_ascii", [](const gol::Grid& g) {
-            std::string result;
-            result.reserve(g.height() * (g.width() + 1));
+        .def("load_packed", [](gol::Grid& g,
+                               py::array_t<uint64_t, py::array::c_style | py::array::forcecast> words) {
+            if (size_t(words.size()) != g.data_size())
+                throw py::value_error("load_packed expects height * words_per_row words");
+            const uint64_t* in = words.data();
+            py::gil_scoped_release release;
+            const size_t stride = g.words_per_row();
+            const size_t full = g.width() / 64, rem = g.width() % 64;
             for (size_t y = 0; y < g.height(); ++y) {
-                for (size_t x = 0; x < g.width(); ++x) {
-                    result += g.get_cell(x, y) ? '#' : '.';
-                }
-                if (y < g.height() - 1) result += '\n';
+                const uint64_t* src = in + y * stride;
+                uint64_t* dst = g.mutable_data() + y * stride;
+                std::copy(src, src + full, dst);
+                std::fill(dst + full, dst + stride, 0);
+                if (rem) dst[full] = src[full] & ((uint64_t(1) << rem) - 1);
             }
-            return result;
+            g.touch();
+        }, py::arg("words"))
+        .def_static("kernel_name", &gol::Grid::kernel_name)
+        .def_static("available_kernels", &gol::Grid::available_kernels)
+        .def_static("set_kernel", &gol::Grid::set_kernel, py::arg("name"))
+        .def_static("num_threads", &gol::Grid::num_threads)
+        .def_static("set_num_threads", &gol::Grid::set_num_threads, py::arg("threads"))
+        .def_static("set_cpu_affinity", &gol::Grid::set_cpu_affinity, py::arg("cpus"))
+        .def("to_ascii", &to_ascii<gol::Grid>)
+        .def("to_ascii_region", &to_ascii_region<gol::Grid>)
+        // Half-block terminal lines; see render.hpp
+        .def("render_halfblock", &gol::render_halfblock,
+             py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"), py::arg("zoom") = 1);
+
+    // SimulationRunner: steps a copy of the grid on its own thread. Snapshots
+    // are read-only views of a published copy; release them (or use `with`)
+    // once done so their slot can be reused.
+    py::class_<Snapshot>(m, "Snapshot")
+        .def_property_readonly("width", [](const Snapshot& s) { return held(s).width(); })
+        .def_property_readonly("height", [](const Snapshot& s) { return held(s).height(); })
+        .def_property_readonly("generation", [](const Snapshot& s) { return held(s).generation(); })
+        .def_property_readonly("population", [](const Snapshot& s) { return held(s).population(); })
+        .def_property_readonly("change_count",
+                               [](const Snapshot& s) { return held(s).change_count(); })
+        .def("get_cell", [](const Snapshot& s, size_t x, size_t y) { return held(s).get_cell(x, y); })
+        .def("state_hash", [](const Snapshot& s) { return held(s).state_hash(); })
+        .def("changed_since", [](const Snapshot& s, uint64_t count) {
+            py::list rects;
+            for (const gol::Grid::Rect& r : held(s).changed_since(count))
+                rects.append(py::make_tuple(r.x, r.y, r.width, r.height));
+            return rects;
+        }, py::arg("count"))
+        .def("render_halfblock", [](const Snapshot& s, size_t x, size_t y, size_t w, size_t h,
+                                    size_t zoom) {
+            return gol::render_halfblock(held(s), x, y, w, h, zoom);
+        }, py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"), py::arg("zoom") = 1)
+        .def("to_ascii", [](const Snapshot& s) { return to_ascii(held(s)); })
+        .def("to_ascii_region", [](const Snapshot& s, size_t x, size_t y, size_t w, size_t h) {
+            return to_ascii_region(held(s), x, y, w, h);
+        })
+        .def("to_numpy_packed", [](const Snapshot& s) {
+            const gol::Grid& g = held(s);
+            return py::array_t<uint64_t>({g.data_size()}, {sizeof(uint64_t)}, g.data());
+        })
+        .def("to_grid", [](const Snapshot& s) { return gol::Grid(held(s)); })
+        .def("release", &Snapshot::release)
+        .def("__enter__", [](py::object self) { return self; })
+        .def("__exit__", [](Snapshot& s, py::args) { s.release(); });
+
+    py::class_<gol::SimulationRunner>(m, "SimulationRunner")
+        .def(py::init<gol::Grid, double, bool>(),
+             py::arg("grid"), py::arg("rate") = 0, py::arg("paused") = false)
+        .def("pause", &gol::SimulationRunner::pause)
+        .def("resume", &gol::SimulationRunner::resume)
+        .def_property_readonly("paused", &gol::SimulationRunner::paused)
+        .def("step", &gol::SimulationRunner::step, py::arg("n") = 1)
+        .def_property("rate", &gol::SimulationRunner::rate, &gol::SimulationRunner::set_rate)
+        .def_property_readonly("generations_per_second",
+                               &gol::SimulationRunner::generations_per_second)
+        .def_property_readonly("generation", &gol::SimulationRunner::generation)
+        .def("snapshot", &gol::SimulationRunner::snapshot, py::keep_alive<0, 1>())
+        .def("wait_for", &gol::SimulationRunner::wait_for, py::arg("generation"),
+             py::keep_alive<0, 1>(), py::call_guard<py::gil_scoped_release>())
+        // fn(grid) runs on the stepping thread; don't keep the grid past it
+        .def("edit", [](gol::SimulationRunner& r, py::function fn) {
+            py::gil_scoped_release release;
+            r.edit([&](gol::Grid& g) {
+                py::gil_scoped_acquire acquire;
+                fn(py::cast(&g, py::return_value_policy::reference));
+            });
+        }, py::arg("fn"))
+        // Swaps in another board between steps; see Grid::replace
+        .def("replace", [](gol::SimulationRunner& r, const gol::Grid& grid) {
+            r.edit([&](gol::Grid& g) { g.replace(grid); });
+        }, py::arg("grid"), py::call_guard<py::gil_scoped_release>())
+        .def("stop", &gol::SimulationRunner::stop, py::call_guard<py::gil_scoped_release>());
+
+    // Plane: unbounded, same surface as Grid over its nominal view
+    py::class_<gol::Plane>(m, "Plane")
+        .def(py::init<size_t, size_t>(), py::arg("width") = 0, py::arg("height") = 0)
+        .def_property_readonly("width", &gol::Plane::width)
+        .def_property_readonly("height", &gol::Plane::height)
+        .def_property_readonly("generation", &gol::Plane::generation)
+        .def_property_readonly("population", &gol::Plane::population)
+        .def_property_readonly("tile_count", &gol::Plane::tile_count)
+        .def_property_readonly("memory_usage", &gol::Plane::memory_usage)
+        .def_property("rule",
+            [](const gol::Plane& p) { return p.rule().to_string(); },
+            [](gol::Plane& p, const std::string& rule) { p.set_rule(gol::Rule::parse(rule)); })
+        .def("set_cell", &gol::Plane::set_cell)
+        .def("get_cell", &gol::Plane::get_cell)
+        .def("step", &gol::Plane::step, py::call_guard<py::gil_scoped_release>())
+        .def("step_n", &gol::Plane::step_n, py::arg("n"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("clear", &gol::Plane::clear)
+        .def("randomize", &gol::Plane::randomize,
+             py::arg("density") = 0.1, py::arg("seed") = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("paste", &gol::Plane::paste, py::arg("pattern"), py::arg("x"), py::arg("y"))
+        .def("extract", &gol::Plane::extract,
+             py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"))
+        .def("bounding_box", [](const gol::Plane& p) {
+            auto box = p.bounding_box();
+            return py::make_tuple(box.x, box.y, box.width, box.height);
         })
-        .def("to_ascii_region", [](const gol::Grid& g, size_t rx, size_t ry, size_t rw, size_t rh) {
-            std::string result;
-            for (size_t y = ry; y < ry + rh && y < g.height(); ++y) {
-                for (size_t x = rx; x < rx + rw && x < g.width(); ++x) {
-                    result += g.get_cell(x, y) ? '#' : '.';
-                }
-                if (y < ry + rh - 1) result += '\n';
+        .def("to_numpy_packed", [](const gol::Plane& p) {
+            gol::Grid view = p.extract(0, 0, p.width(), p.height());
+            return py::array_t<uint64_t>({view.data_size()}, {sizeof(uint64_t)}, view.data());
+        })
+        .def("to_ascii", &to_ascii<gol::Plane>)
+        .def("to_ascii_region", &to_ascii_region<gol::Plane>);
+
+    // MappedGrid: a board in a snapshot file, stepped in place in bands
+    py::class_<gol::MappedGrid>(m, "MappedGrid")
+        .def(py::init<const std::string&, size_t, size_t>(),
+             py::arg("path"), py::arg("width"), py::arg("height"))
+        .def(py::init<const std::string&>(), py::arg("path"),
+             py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("width", &gol::MappedGrid::width)
+        .def_property_readonly("height", &gol::MappedGrid::height)
+        .def_property("generation", &gol::MappedGrid::generation,
+                      &gol::MappedGrid::set_generation)
+        .def_property_readonly("population", &gol::MappedGrid::population,
+                               py::call_guard<py::gil_scoped_release>())
+        .def_property("resident_limit", &gol::MappedGrid::resident_limit,
+                      &gol::MappedGrid::set_resident_limit)
+        .def_property("rule",
+            [](const gol::MappedGrid& g) { return g.rule().to_string(); },
+            [](gol::MappedGrid& g, const std::string& rule) { g.set_rule(gol::Rule::parse(rule)); })
+        .def("set_cell", &gol::MappedGrid::set_cell)
+        .def("get_cell", &gol::MappedGrid::get_cell)
+        .def("step", &gol::MappedGrid::step, py::call_guard<py::gil_scoped_release>())
+        .def("step_n", &gol::MappedGrid::step_n, py::arg("n"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("clear", &gol::MappedGrid::clear)
+        .def("randomize", &gol::MappedGrid::randomize,
+             py::arg("density") = 0.1, py::arg("seed") = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("paste", &gol::MappedGrid::paste, py::arg("pattern"), py::arg("x"), py::arg("y"),
+             py::arg("mode") = gol::BlitMode::kOr, py::call_guard<py::gil_scoped_release>())
+        .def("extract", &gol::MappedGrid::extract,
+             py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("sync", &gol::MappedGrid::sync, py::call_guard<py::gil_scoped_release>());
+
+    // GridBatch: many small grids stepped together; the cells stay in one
+    // interleaved buffer that numpy can view directly
+    py::class_<gol::GridBatch>(m, "GridBatch")
+        .def(py::init<size_t, size_t, size_t>(),
+             py::arg("count"), py::arg("width"), py::arg("height"))
+        .def("__len__", &gol::GridBatch::size)
+        .def_property_readonly("width", &gol::GridBatch::width)
+        .def_property_readonly("height", &gol::GridBatch::height)
+        .def_property_readonly("generation", &gol::GridBatch::generation)
+        .def_property("rule",
+            [](const gol::GridBatch& b) { return b.rule().to_string(); },
+            [](gol::GridBatch& b, const std::string& rule) { b.set_rule(gol::Rule::parse(rule)); })
+        .def("set_cell", &gol::GridBatch::set_cell,
+             py::arg("index"), py::arg("x"), py::arg("y"), py::arg("alive"))
+        .def("get_cell", &gol::GridBatch::get_cell, py::arg("index"), py::arg("x"), py::arg("y"))
+        .def("grid", &gol::GridBatch::grid, py::arg("index"))
+        .def("set_grid", &gol::GridBatch::set_grid, py::arg("index"), py::arg("grid"))
+        .def("step", &gol::GridBatch::step, py::call_guard<py::gil_scoped_release>())
+        .def("step_n", &gol::GridBatch::step_n, py::arg("n"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("clear", &gol::GridBatch::clear)
+        .def("randomize", [](gol::GridBatch& b, double density,
+                             py::array_t<uint64_t, py::array::c_style | py::array::forcecast> seeds) {
+            std::vector<uint64_t> list(seeds.data(), seeds.data() + seeds.size());
+            py::gil_scoped_release release;
+            b.randomize(density, list);
+        }, py::arg("density"), py::arg("seeds"))
+        .def("populations", [](const gol::GridBatch& b) {
+            auto counts = b.populations();
+            py::array_t<uint64_t> arr(counts.size());
+            std::copy(counts.begin(), counts.end(), arr.mutable_data());
+            return arr;
+        })
+        .def("stable", [](const gol::GridBatch& b) {
+            py::array_t<bool> arr(b.size());
+            std::copy(b.stable().begin(), b.stable().end(), arr.mutable_data());
+            return arr;
+        })
+        .def("to_numpy", [](const gol::GridBatch& b) {
+            auto arr = py::array_t<uint8_t>({b.size(), b.height(), b.width()});
+            uint8_t* out = arr.mutable_data();
+            {
+                py::gil_scoped_release release;
+                b.unpack(out);
             }
-            return result;
+            return arr;
+        })
+        // A copy of the interleaved words, indexed [y, word, grid]; like
+        // Grid's, since step_n moves the cells between two buffers
+        .def("to_numpy_packed", [](const gol::GridBatch& b) {
+            py::array_t<uint64_t> arr({b.height(), b.words_per_row(), b.stride()});
+            std::copy(b.data(), b.data() + b.data_size(), arr.mutable_data());
+            return arr;
         });
 
     // RLE functions
@@ -74,13 +375,143 @@ PYBIND11_MODULE(gol_engine, m) {
         .def_readonly("name", &gol::RLEPattern::name)
         .def_readonly("width", &gol::RLEPattern::width)
         .def_readonly("height", &gol::RLEPattern::height)
+        .def_readonly("rule", &gol::RLEPattern::rule)
         .def_readonly("alive_cells", &gol::RLEPattern::alive_cells);
 
+    // RLEError subclasses ValueError; its message carries line and column
+    py::register_exception<gol::RLEError>(m, "RLEError", PyExc_ValueError);
     m.def("parse_rle", &gol::parse_rle, py::arg("rle"));
-    m.def("to_rle", &gol::to_rle, py::arg("grid"));
-    m.def("load_rle", &gol::load_rle,
+    m.def("to_rle", py::overload_cast<const gol::Grid&>(&gol::to_rle), py::arg("grid"));
+    m.def("to_rle", py::overload_cast<const gol::MappedGrid&>(&gol::to_rle), py::arg("grid"),
+          py::call_guard<py::gil_scoped_release>());
+    m.def("save_rle_file", py::overload_cast<const gol::Grid&, const std::string&>(&gol::save_rle_file),
+          py::arg("grid"), py::arg("path"), py::call_guard<py::gil_scoped_release>());
+    m.def("save_rle_file",
+          py::overload_cast<const gol::MappedGrid&, const std::string&>(&gol::save_rle_file),
+          py::arg("grid"), py::arg("path"), py::call_guard<py::gil_scoped_release>());
+    m.def("write_rle", &gol::write_rle, py::arg("grid"), py::arg("fd"),
+          py::call_guard<py::gil_scoped_release>());
+    m.def("load_rle", py::overload_cast<gol::Grid&, const std::string&, size_t, size_t>(&gol::load_rle),
+          py::arg("grid"), py::arg("rle"),
+          py::arg("offset_x") = 0, py::arg("offset_y") = 0);
+    m.def("load_rle",
+          py::overload_cast<gol::Plane&, const std::string&, int64_t, int64_t>(&gol::load_rle),
           py::arg("grid"), py::arg("rle"),
           py::arg("offset_x") = 0, py::arg("offset_y") = 0);
+    m.def("load_rle_file", &gol::load_rle_file,
+          py::arg("grid"), py::arg("path"),
+          py::arg("offset_x") = 0, py::arg("offset_y") = 0,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("read_rle_file", &gol::read_rle_file, py::arg("path"),
+          py::call_guard<py::gil_scoped_release>());
     m.def("text_to_pattern", &gol::text_to_pattern,
           py::arg("text"), py::arg("char_spacing") = 1);
+
+    // Binary snapshots: raw grid words behind a one-page header
+    m.def("save_snapshot", &gol::save_snapshot,
+          py::arg("grid"), py::arg("path"), py::arg("sparse") = false,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("load_snapshot", &gol::load_snapshot, py::arg("path"),
+          py::call_guard<py::gil_scoped_release>());
+
+    // Recordings: keyframes plus per-generation XOR deltas
+    py::class_<gol::Recorder>(m, "Recorder")
+        .def(py::init<const std::string&, const gol::Grid&, size_t>(),
+             py::arg("path"), py::arg("grid"), py::arg("keyframe_interval") = 1024,
+             py::keep_alive<1, 3>())
+        .def("record", &gol::Recorder::record, py::arg("grid"))
+        .def("close", &gol::Recorder::close)
+        .def_property_readonly("bytes_written", &gol::Recorder::bytes_written);
+
+    py::class_<gol::Player>(m, "Player")
+        .def(py::init<const std::string&>(), py::arg("path"))
+        .def_property_readonly("first_generation", &gol::Player::first_generation)
+        .def_property_readonly("last_generation", &gol::Player::last_generation)
+        .def_property_readonly("keyframes", &gol::Player::keyframes)
+        .def("seek", [](gol::Player& p, uint64_t generation) { return gol::Grid(p.seek(generation)); },
+             py::arg("generation"), py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("grid", [](const gol::Player& p) { return gol::Grid(p.grid()); });
+
+    // Macrocell: quadtree files, repeated subtrees stored once
+    py::class_<gol::Macrocell>(m, "Macrocell")
+        .def_readonly("rule", &gol::Macrocell::rule)
+        .def_readonly("generation", &gol::Macrocell::generation)
+        .def_property_readonly("level", &gol::Macrocell::level)
+        .def("__len__", [](const gol::Macrocell& mc) { return mc.nodes.size(); });
+
+    py::register_exception<gol::MacrocellError>(m, "MacrocellError", PyExc_ValueError);
+    m.def("parse_macrocell", &gol::parse_macrocell, py::arg("text"),
+          py::call_guard<py::gil_scoped_release>());
+    m.def("to_macrocell", py::overload_cast<const gol::Macrocell&>(&gol::to_macrocell),
+          py::arg("macrocell"));
+    m.def("to_macrocell", [](const gol::HashLife& life) {
+        return gol::to_macrocell(life.to_macrocell());
+    }, py::arg("life"));
+    m.def("to_macrocell", [](const gol::Grid& grid) {
+        gol::HashLife life;
+        life.load(grid);
+        gol::Macrocell mc = life.to_macrocell();
+        mc.rule = grid.rule().to_string();
+        mc.generation = grid.generation();
+        return gol::to_macrocell(mc);
+    }, py::arg("grid"), py::call_guard<py::gil_scoped_release>());
+    m.def("load_macrocell", &gol::load_macrocell,
+          py::arg("plane"), py::arg("macrocell"), py::arg("x") = 0, py::arg("y") = 0);
+
+    // HashLife: unbounded plane, jumps of 2^k generations
+    py::class_<gol::HashLife>(m, "HashLife")
+        .def(py::init<size_t>(), py::arg("memory_limit") = gol::HashLife::kDefaultMemoryLimit)
+        .def_property_readonly("generation", &gol::HashLife::generation)
+        .def_property_readonly("population", &gol::HashLife::population)
+        .def_property_readonly("node_count", &gol::HashLife::node_count)
+        .def_property_readonly("memory_usage", &gol::HashLife::memory_usage)
+        .def_property("memory_limit", &gol::HashLife::memory_limit,
+                      &gol::HashLife::set_memory_limit)
+        .def("set_cell", &gol::HashLife::set_cell, py::arg("x"), py::arg("y"), py::arg("alive"))
+        .def("get_cell", &gol::HashLife::get_cell, py::arg("x"), py::arg("y"))
+        .def("clear", &gol::HashLife::clear)
+        .def("step", &gol::HashLife::step, py::arg("n") = 1,
+             py::call_guard<py::gil_scoped_release>())
+        .def("step_superspeed", &gol::HashLife::step_superspeed,
+             py::call_guard<py::gil_scoped_release>())
+        .def("collect_garbage", &gol::HashLife::collect_garbage)
+        .def("load_grid", py::overload_cast<const gol::Grid&, int64_t, int64_t>(&gol::HashLife::load),
+             py::arg("grid"), py::arg("x") = 0, py::arg("y") = 0)
+        .def("load_pattern",
+             py::overload_cast<const gol::RLEPattern&, int64_t, int64_t>(&gol::HashLife::load),
+             py::arg("pattern"), py::arg("x") = 0, py::arg("y") = 0)
+        .def("to_grid", py::overload_cast<int64_t, int64_t, size_t, size_t>(
+                            &gol::HashLife::to_grid, py::const_),
+             py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"))
+        .def("to_grid", py::overload_cast<>(&gol::HashLife::to_grid, py::const_))
+        .def("to_pattern", &gol::HashLife::to_pattern)
+        .def("load_macrocell", py::overload_cast<const gol::Macrocell&>(&gol::HashLife::load),
+             py::arg("macrocell"))
+        .def("to_macrocell", &gol::HashLife::to_macrocell)
+        .def("bounding_box", [](const gol::HashLife& life) {
+            auto box = life.bounding_box();
+            return py::make_tuple(box.x, box.y, box.width, box.height);
+        });
+
+    // Arena: grid storage, huge pages and pooled reuse
+    py::enum_<gol::HugePages>(m, "HugePages")
+        .value("OFF", gol::HugePages::kOff)
+        .value("ADVISE", gol::HugePages::kAdvise)
+        .value("RESERVE", gol::HugePages::kReserve);
+
+    py::class_<gol::Arena::Stats>(m, "ArenaStats")
+        .def_readonly("mapped", &gol::Arena::Stats::mapped)
+        .def_readonly("pooled", &gol::Arena::Stats::pooled)
+        .def_readonly("huge", &gol::Arena::Stats::huge)
+        .def_readonly("heap", &gol::Arena::Stats::heap)
+        .def_readonly("reused", &gol::Arena::Stats::reused);
+
+    m.def("arena_stats", [] { return gol::Arena::instance().stats(); });
+    m.def("huge_pages", [] { return gol::Arena::instance().huge_pages(); });
+    m.def("set_huge_pages", [](gol::HugePages mode) { gol::Arena::instance().set_huge_pages(mode); },
+          py::arg("mode"));
+    m.def("pool_limit", [] { return gol::Arena::instance().pool_limit(); });
+    m.def("set_pool_limit", [](size_t bytes) { gol::Arena::instance().set_pool_limit(bytes); },
+          py::arg("bytes"));
+    m.def("trim_arena", [] { gol::Arena::instance().trim(); });
 }
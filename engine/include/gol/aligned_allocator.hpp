@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "gol/arena.hpp"
+
+namespace gol {
+
+// Minimal allocator returning `Alignment`-byte aligned storage, so packed
+// rows can start on cache-line / vector boundaries. resize() leaves new
+// elements default-initialized (uninitialized words), so the threads that
+// will use a buffer can be the first to touch it. Storage comes from the
+// Arena, which maps large buffers on huge pages and pools them for reuse.
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(Arena::instance().allocate(n * sizeof(T), Alignment));
+    }
+    void deallocate(T* p, size_t n) {
+        Arena::instance().deallocate(p, n * sizeof(T), Alignment);
+    }
+
+    template <typename U>
+    void construct(U* p) { ::new (static_cast<void*>(p)) U; }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+} // namespace gol
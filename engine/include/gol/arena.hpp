@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace gol {
+
+enum class HugePages : uint8_t {
+    kOff,      // ordinary pages
+    kAdvise,   // 2 MB aligned and advised for transparent huge pages
+    kReserve,  // MAP_HUGETLB from the reserved pool, else as kAdvise
+};
+
+// Storage for grid cells, through AlignedAllocator. Blocks of kMapMin
+// bytes or more are mapped from the OS page-aligned; with huge pages on,
+// those of kHugePage or more are rounded up to and aligned on 2 MB so the
+// kernel can back them with huge pages, cutting TLB misses on big boards.
+// Freed blocks are kept, up to the pool limit, and handed out again for
+// requests of about the same size, so grids rebuilt at one size reuse
+// their memory. Smaller blocks come from aligned operator new.
+//
+// GOL_HUGE_PAGES=off|advise|reserve in the environment sets the starting
+// mode; the default is advise.
+class Arena {
+public:
+    static constexpr size_t kMapMin = size_t(1) << 20;
+    static constexpr size_t kHugePage = size_t(2) << 20;
+    static constexpr size_t kDefaultPoolLimit = size_t(256) << 20;
+
+    struct Stats {
+        size_t mapped = 0;  // bytes mapped from the OS, in use or pooled
+        size_t pooled = 0;  // of those, free and kept for reuse
+        size_t huge = 0;    // of those, on huge pages as far as the kernel reports
+        size_t heap = 0;    // bytes in use from operator new
+        size_t reused = 0;  // allocations served from the pool so far
+    };
+
+    static Arena& instance();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Throws std::bad_alloc when the OS has no more to give.
+    void* allocate(size_t bytes, size_t alignment);
+    void deallocate(void* p, size_t bytes, size_t alignment);
+
+    // Applies to blocks mapped from then on.
+    void set_huge_pages(HugePages mode);
+    HugePages huge_pages() const;
+    // Bytes of freed blocks kept for reuse; lowering it unmaps the excess.
+    void set_pool_limit(size_t bytes);
+    size_t pool_limit() const;
+    // Unmaps every pooled block.
+    void trim();
+
+    Stats stats() const;
+
+private:
+    struct Block {
+        size_t size;
+        bool hugetlb;
+    };
+
+    Arena();
+    void unmap(uintptr_t address, const Block& block);
+    void trim_to(size_t limit);
+
+    mutable std::mutex mutex_;
+    HugePages mode_;
+    size_t pool_limit_ = kDefaultPoolLimit;
+    std::map<uintptr_t, Block> blocks_;        // every mapped block by address
+    std::multimap<size_t, uintptr_t> free_;    // pooled blocks by size
+    size_t mapped_ = 0;
+    size_t pooled_ = 0;
+    size_t heap_ = 0;
+    size_t reused_ = 0;
+};
+
+} // namespace gol
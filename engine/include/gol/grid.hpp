@@ -2,10 +2,28 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
 #include <vector>
 
+#include "gol/aligned_allocator.hpp"
+#include "gol/rule.hpp"
+
 namespace gol {
 
+class Recorder;
+
+// How paste() combines a pattern with the cells under it.
+enum class BlitMode : uint8_t {
+    kOr,    // live pattern cells are set, the rest left alone
+    kAnd,   // cells stay alive only where the pattern is
+    kXor,   // live pattern cells are toggled
+    kCopy,  // cells under the pattern become the pattern
+};
+
+// Symmetry of a random soup about the centre of the board: C2 is a half
+// turn, C4 a quarter turn, D8 every rotation and reflection of the square.
+enum class Symmetry : uint8_t { kNone, kC2, kC4, kD8 };
+
 class Grid {
 public:
     Grid(size_t width, size_t height);
@@ -15,30 +33,200 @@ public:
 
     void set_cell(size_t x, size_t y, bool alive);
     bool get_cell(size_t x, size_t y) const;
+    // Sets `length` cells from (x, y) rightwards, whole words at a time.
+    // Cells past the right edge are ignored rather than wrapped.
+    void set_span(size_t x, size_t y, size_t length, bool alive);
 
     void step();
     void step_n(size_t n);
     void clear();
-    void randomize(double density = 0.1, uint64_t seed = 0);
+    // Each cell alive with probability `density` (to 16 binary digits),
+    // filled in parallel a word at a time. A seed gives the same board
+    // whatever the thread count; 0 picks one at random. C4 and D8 soups
+    // need a square board (std::invalid_argument otherwise).
+    void randomize(double density = 0.1, uint64_t seed = 0,
+                   Symmetry symmetry = Symmetry::kNone);
 
-    void paste(const Grid& pattern, size_t x, size_t y);
+    // Both wrap around the board and move whole words at a time, the
+    // pattern split into at most four rectangles that do not wrap (more if
+    // it is larger than the board, in which case later rows and columns
+    // land on top of earlier ones).
+    void paste(const Grid& pattern, size_t x, size_t y, BlitMode mode = BlitMode::kOr);
     Grid extract(size_t x, size_t y, size_t w, size_t h) const;
 
+    // Packed cells, row-major. Each row is padded to a whole number of
+    // 64-byte lines, so data() + y * words_per_row() is cache-line aligned.
     const uint64_t* data() const { return data_.data(); }
     size_t data_size() const { return data_.size(); }
+    size_t words_per_row() const { return words_per_row_; }
+    // Writable cells for bulk loaders. Keep the bits past the width zero,
+    // and call touch() afterwards so cached tile state is rebuilt.
+    uint64_t* mutable_data() { return data_.data(); }
+    void touch();
     void to_flat_bool(uint8_t* out, size_t len) const;
+    // All cells as one byte each, 1 if alive, row y starting at
+    // out + y * stride.
+    void unpack(uint8_t* out, size_t stride) const;
+    // The reverse: row y read from in + y * stride, nonzero bytes alive.
+    void pack(const uint8_t* in, size_t stride);
 
     size_t population() const;
 
     size_t generation() const { return generation_; }
+    // For restoring a saved run.
+    void set_generation(size_t generation) { generation_ = generation; }
+
+    // With a checkpoint set, step_n saves a snapshot (see snapshot.hpp) to
+    // `path` whenever the generation reaches a multiple of `every`, so a
+    // run that dies can resume from load_snapshot. 0 turns it off.
+    void set_checkpoint(const std::string& path, size_t every, bool sparse = true);
+
+    // Hash of the cells, kept per tile like the population, so only tiles
+    // that changed are rehashed. Equal boards of one size hash equal.
+    uint64_t state_hash() const;
+
+    struct Stability {
+        bool settled = false;  // false if max_generations ran out first
+        size_t period = 0;     // 1 for still lifes and the empty board
+        size_t start = 0;      // first generation of the cycle seen by the call
+    };
+    // Steps until the board repeats one of its last max_period states or
+    // max_generations steps have run. Repeats are found through
+    // state_hash(), which step() then updates as it writes each tile, and
+    // confirmed by stepping one more period and comparing every cell, so a
+    // settled board ends one period past the repeat.
+    Stability run_until_stable(size_t max_generations, size_t max_period = 1024);
+
+    // Any B/S rule; Life, HighLife, Seeds and Day & Night have kernels of
+    // their own, other rules run through a slower table-driven one.
+    void set_rule(const Rule& rule);
+    const Rule& rule() const { return rule_; }
+
+    // The board is tracked in tiles of kTileRows rows by kTileWords words.
+    // step() only recomputes tiles that changed in the last generation or
+    // border one that did; the rest already hold their next state.
+    static constexpr size_t kTileRows = 64;
+    static constexpr size_t kTileWords = 8;
+    size_t tiles_x() const { return tiles_x_; }
+    size_t tiles_y() const { return tiles_y_; }
+    size_t changed_tiles() const;
+    // Steps and edits stamp the tiles and rows they change with a count
+    // that only goes up, so any number of observers can each ask what
+    // changed since the count they last saw.
+    uint64_t change_count() const { return change_count_; }
+    bool tile_changed_since(size_t tile, uint64_t count) const {
+        return tile_stamp_[tile] > count;
+    }
+    bool row_changed_since(size_t y, uint64_t count) const { return row_stamp_[y] > count; }
+
+    struct Rect {
+        size_t x, y, width, height;
+    };
+    // Every cell changed since `count` falls in one of these: per tile row,
+    // each run of changed tiles across the changed rows of that tile row.
+    std::vector<Rect> changed_since(uint64_t count) const;
+
+    // Takes the cells, size, rule and generation of `other` but keeps this
+    // grid's checkpoint and recorder, and carries change_count() on past
+    // its old value with every cell changed, so observers of the board it
+    // replaces see all of the new one.
+    void replace(const Grid& other);
+    // Copies everything a reader sees: cells, rule, generation, settings,
+    // populations, hashes and change stamps. It leaves out the scratch board
+    // step() writes into and reuses this grid's storage where it can, so it
+    // moves about half what assignment does. The first step afterwards
+    // allocates the scratch and recomputes every tile.
+    void copy_state_from(const Grid& other);
+
+    // Hands every generation to recorder->record(*this); step_n then steps
+    // one generation at a time. The grid does not own the recorder, and
+    // nullptr detaches it. Copies are not recorded, and assigning to a
+    // grid detaches its recorder.
+    void set_recorder(Recorder* recorder) { recorder_.ptr = recorder; }
+
+    // On busy boards too big for the cache, step_n advances bands of rows
+    // `depth` generations at a time through a per-thread scratch, each band
+    // recomputing a halo that shrinks by one row per generation, so the
+    // board streams through memory once per `depth` generations. 0 (the
+    // default) picks the depth from the board size; 1 turns blocking off.
+    // The result is always that of calling step() n times.
+    void set_temporal_depth(size_t depth) { temporal_depth_ = depth; }
+    size_t temporal_depth() const { return temporal_depth_; }
+
+    // Low-memory mode drops the second board that step() writes into and
+    // steps each tile row in place instead, holding back one row of output
+    // until the row below it is done. Tile rows still run in parallel,
+    // reading their neighbors' edge rows from copies taken first. The grid
+    // then takes about 1x its cells plus a few percent; stepping gives the
+    // same results, a little slower, and temporal blocking is off.
+    void set_low_memory(bool on);
+    bool low_memory() const { return low_memory_; }
+
+    // Step kernel picked from CPUID at startup: "scalar", "sse2", "avx2" or
+    // "avx512". Setting GOL_KERNEL in the environment overrides the choice.
+    static const char* kernel_name();
+    static std::vector<std::string> available_kernels();
+    // Switches every grid to the named kernel; false if this CPU lacks it.
+    static bool set_kernel(const std::string& name);
+
+    // Grids step on an engine-wide pool of worker threads. Each worker owns
+    // an even share of the tile rows, first-touches their memory when a grid
+    // is created (so it lands on the worker's NUMA node), and steals rows
+    // from the others once its own are done. 0 threads picks GOL_THREADS
+    // from the environment, else one per CPU.
+    static void set_num_threads(size_t threads);
+    static size_t num_threads();
+    // Pins worker i to cpus[i % cpus.size()]; an empty list unpins them.
+    // Set it before creating grids for placement to follow.
+    static void set_cpu_affinity(const std::vector<int>& cpus);
 
 private:
+    using Words = std::vector<uint64_t, AlignedAllocator<uint64_t, 64>>;
+
+    // Left behind by copies, so only the grid it was attached to records.
+    struct RecorderRef {
+        Recorder* ptr = nullptr;
+        RecorderRef() = default;
+        RecorderRef(const RecorderRef&) {}
+        RecorderRef& operator=(const RecorderRef&) {
+            ptr = nullptr;
+            return *this;
+        }
+    };
+
+    static constexpr uint32_t kPopStale = ~uint32_t(0);
+    static constexpr uint64_t kHashStale = ~uint64_t(0);
+
     size_t width_;
     size_t height_;
-    size_t words_per_row_;
+    size_t row_words_;      // words holding live cells
+    size_t words_per_row_;  // row stride, row_words_ padded to 8 words
     size_t generation_ = 0;
-    std::vector<uint64_t> data_;
-    std::vector<uint64_t> buffer_;
+    size_t temporal_depth_ = 0;
+    std::string checkpoint_path_;
+    size_t checkpoint_every_ = 0;
+    bool checkpoint_sparse_ = true;
+    RecorderRef recorder_;
+    uint64_t change_count_ = 0;
+    bool hash_in_step_ = false;  // step() rehashes the tiles it changes
+    bool low_memory_ = false;
+    Rule rule_;
+    Words data_;
+    // Previous generation, exact for every unchanged tile; empty in
+    // low-memory mode and after copy_state_from().
+    Words buffer_;
+    Words edges_;   // low-memory mode: first and last row of each tile row, before a step
+
+    size_t tiles_x_;
+    size_t tiles_y_;
+    std::vector<uint8_t> tile_changed_;      // changed in the last generation
+    std::vector<uint8_t> tile_active_;       // scratch for step()
+    std::vector<uint64_t> tile_diff_;        // scratch for step()
+    std::vector<uint64_t> row_diff_;         // the same, for one row at a time
+    mutable std::vector<uint32_t> tile_pop_; // kPopStale until recounted
+    mutable std::vector<uint64_t> tile_hash_; // kHashStale until rehashed
+    std::vector<uint64_t> tile_stamp_;       // change_count_ when last changed
+    std::vector<uint64_t> row_stamp_;
 
     size_t word_index(size_t x, size_t y) const {
         return y * words_per_row_ + x / 64;
@@ -46,7 +234,19 @@ private:
     uint64_t bit_mask(size_t x) const {
         return uint64_t(1) << (x % 64);
     }
-    int count_neighbors(size_t x, size_t y) const;
+    size_t tile_index(size_t x, size_t y) const {
+        return (y / kTileRows) * tiles_x_ + x / (64 * kTileWords);
+    }
+    void touch_all();
+    void ensure_scratch();
+    void symmetrize(Symmetry symmetry);
+    template <class Op>
+    void blit(const Grid& src, size_t sx, size_t sy, size_t w, size_t h, size_t dx, size_t dy,
+              Op op);
+    void count_tile(size_t tile) const;
+    uint64_t hash_tile(const Words& cells, size_t tile) const;
+    size_t auto_temporal_depth() const;
+    void step_blocked(size_t generations);
 };
 
 } // namespace gol
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gol/aligned_allocator.hpp"
+#include "gol/rule.hpp"
+
+namespace gol {
+
+class Grid;
+
+// Many same-sized grids stepped together, for soup searches. The grids are
+// stored interleaved: word j of row y of every grid sits side by side, so
+// each SIMD lane of the step kernel advances a different grid with no
+// shuffles. Every grid is a torus, like Grid.
+class GridBatch {
+public:
+    GridBatch(size_t count, size_t width, size_t height);
+
+    size_t size() const { return count_; }
+    size_t width() const { return width_; }
+    size_t height() const { return height_; }
+    size_t generation() const { return generation_; }
+
+    void set_rule(const Rule& rule) { rule_ = rule; }
+    const Rule& rule() const { return rule_; }
+
+    // Out-of-range cells are ignored, as in Grid.
+    void set_cell(size_t index, size_t x, size_t y, bool alive);
+    bool get_cell(size_t index, size_t x, size_t y) const;
+
+    // Copies grid `index` out as a Grid, or a Grid's top-left corner in.
+    // Throw std::out_of_range for a bad index.
+    Grid grid(size_t index) const;
+    void set_grid(size_t index, const Grid& grid);
+
+    void step();
+    void step_n(size_t n);
+    void clear();
+    // Grid i gets the cells Grid::randomize(density, seeds[i]) gives a grid
+    // of this size. Throws std::invalid_argument unless there is one seed
+    // per grid.
+    void randomize(double density, const std::vector<uint64_t>& seeds);
+
+    // All grids as one byte per cell, 1 if alive: row y of grid i starts at
+    // out + (i * height() + y) * width().
+    void unpack(uint8_t* out) const;
+
+    std::vector<size_t> populations() const;
+    // 1 for each grid whose latest generation repeats one of the two before
+    // it (still lifes and period-2 oscillators), so it will never change.
+    const std::vector<uint8_t>& stable() const { return stable_; }
+
+    // Packed cells: word j of row y of grid i is
+    // data()[(y * words_per_row() + j) * stride() + i]. stride() is size()
+    // padded to whole cache lines; the padding grids stay empty.
+    const uint64_t* data() const { return data_.data(); }
+    size_t data_size() const { return data_.size(); }
+    size_t words_per_row() const { return row_words_; }
+    size_t stride() const { return stride_; }
+
+private:
+    using Words = std::vector<uint64_t, AlignedAllocator<uint64_t, 64>>;
+
+    size_t count_;
+    size_t width_;
+    size_t height_;
+    size_t row_words_;
+    size_t stride_;
+    size_t block_;  // grids per parallel task
+    size_t generation_ = 0;
+    Rule rule_;
+    Words data_;
+    Words buffer_;    // the generation before data_ (or a copy of it after edits)
+    Words changed_;   // scratch for step_n(): per-grid diffs against
+    Words changed2_;  // the last and the second-to-last generation
+    std::vector<uint8_t> stable_;
+
+    size_t word_index(size_t index, size_t x, size_t y) const {
+        return (y * row_words_ + x / 64) * stride_ + index;
+    }
+};
+
+} // namespace gol
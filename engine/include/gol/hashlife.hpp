@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gol {
+
+class Grid;
+struct Macrocell;
+struct RLEPattern;
+
+// Life on the unbounded plane as a hash-consed quadtree (Gosper's HashLife).
+// Identical subtrees are stored once and every node remembers its own
+// future, so regular patterns jump 2^k generations in time that grows with
+// k rather than 2^k.
+//
+// Unlike Grid the plane does not wrap: coordinates are signed, the pattern
+// sits around the origin, and cells never seen stay dead.
+class HashLife {
+public:
+    static constexpr size_t kDefaultMemoryLimit = size_t(1) << 30;
+
+    struct Rect {
+        int64_t x = 0;
+        int64_t y = 0;
+        uint64_t width = 0;
+        uint64_t height = 0;
+    };
+
+    // memory_limit caps the node store in bytes (0 for no cap). When the
+    // store fills up, nodes no longer reachable from the pattern are
+    // collected; if that does not free enough, stepping throws
+    // std::runtime_error and leaves the pattern at its last generation.
+    explicit HashLife(size_t memory_limit = kDefaultMemoryLimit);
+    ~HashLife();
+
+    HashLife(const HashLife&) = delete;
+    HashLife& operator=(const HashLife&) = delete;
+
+    void set_cell(int64_t x, int64_t y, bool alive);
+    bool get_cell(int64_t x, int64_t y) const;
+    void clear();
+
+    // ORs the live cells of a grid or pattern in, with its top-left corner
+    // at (x, y).
+    void load(const Grid& grid, int64_t x = 0, int64_t y = 0);
+    void load(const RLEPattern& pattern, int64_t x = 0, int64_t y = 0);
+    // ORs a Macrocell tree in node for node, never expanding it to cells.
+    // Grids, patterns and trees with a rule other than B3/S23 throw
+    // std::invalid_argument.
+    void load(const Macrocell& macrocell);
+
+    // Copies the given window, or the bounding box, into a new Grid.
+    Grid to_grid(int64_t x, int64_t y, size_t width, size_t height) const;
+    Grid to_grid() const;
+    // Live cells relative to the top-left corner of bounding_box().
+    RLEPattern to_pattern() const;
+    // The tree as it stands, each distinct subtree written once.
+    Macrocell to_macrocell() const;
+
+    // Advances exactly n generations.
+    void step(uint64_t n);
+    // Advances by the largest power of two the tree can currently take in
+    // one step (it grows with the pattern); returns the generations done.
+    uint64_t step_superspeed();
+
+    uint64_t generation() const { return generation_; }
+    uint64_t population() const;
+    Rect bounding_box() const;
+
+    size_t node_count() const { return live_; }
+    size_t memory_usage() const;
+    size_t memory_limit() const { return memory_limit_; }
+    void set_memory_limit(size_t bytes);
+    // Frees every node not reachable from the current pattern, along with
+    // the memoized results that pointed at them.
+    void collect_garbage();
+
+private:
+    static constexpr uint32_t kNone = ~uint32_t(0);
+    static constexpr uint8_t kFree = 0xFF;
+    static constexpr unsigned kChunkBits = 12;
+    static constexpr unsigned kMaxLevel = 62;  // keeps coordinates well inside int64
+
+    struct Node {
+        uint32_t nw, ne, sw, se;
+        uint32_t next;         // hash chain, or free list
+        uint32_t result;       // 2^(level-2) generations on, kNone if unknown
+        uint32_t step_result;  // 2^step_log2 generations on, kNone if unknown
+        uint8_t level;         // kFree for unused slots
+        uint8_t step_log2;
+        uint8_t marked;
+        uint64_t population;
+    };
+
+    uint32_t memory_limit_nodes() const;
+    Node& at(uint32_t i) { return chunks_[i >> kChunkBits][i & ((1u << kChunkBits) - 1)]; }
+    const Node& at(uint32_t i) const {
+        return chunks_[i >> kChunkBits][i & ((1u << kChunkBits) - 1)];
+    }
+
+    uint32_t allocate();
+    uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+    uint32_t empty(unsigned level);
+    void rehash(size_t buckets);
+    void mark(uint32_t n);
+    void maybe_collect();
+
+    unsigned root_level() const { return at(root_).level; }
+    int64_t half() const { return int64_t(1) << (root_level() - 1); }
+    uint32_t grow(uint32_t n);
+    void expand();
+    bool covers(int64_t x0, int64_t y0, int64_t x1, int64_t y1) const;
+    bool centered() const;
+
+    uint32_t result(uint32_t n);
+    uint32_t advance(uint32_t n, unsigned log2_gens);
+    uint32_t combine(uint32_t n, unsigned log2_gens);
+    void advance_root(unsigned log2_gens);
+
+    uint32_t set(uint32_t n, uint64_t x, uint64_t y, bool alive);
+    uint32_t merge(uint32_t a, uint32_t b);
+    uint32_t build(const Grid& grid, unsigned level, int64_t x0, int64_t y0,
+                   int64_t gx, int64_t gy);
+    uint32_t build_leaf(uint64_t cells, unsigned level, unsigned x0, unsigned y0);
+    uint64_t distance_to_live(int side) const;
+
+    std::vector<std::unique_ptr<Node[]>> chunks_;
+    size_t used_ = 0;  // slots handed out in chunks_
+    size_t live_ = 0;
+    uint32_t free_ = kNone;
+    std::vector<uint32_t> buckets_;
+    std::vector<uint32_t> empty_;
+    std::vector<uint32_t> stack_;  // intermediate nodes kept alive while stepping
+    size_t memory_limit_;
+    uint32_t root_;
+    uint64_t generation_ = 0;
+};
+
+} // namespace gol
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gol {
+
+class Plane;
+
+// Golly's Macrocell format: the pattern's quadtree written bottom-up, one
+// node per line, so a subtree that repeats is stored once and the file
+// follows the tree rather than the area. The root is centred on the
+// origin, its top-left corner at (-2^(level-1), -2^(level-1)).
+struct Macrocell {
+    // Level 3 nodes are 8x8 leaves: bit y * 8 + x of `cells` is cell
+    // (x, y). Higher nodes name their nw, ne, sw and se children by
+    // position in `nodes` plus one, 0 meaning an empty child.
+    struct Node {
+        uint8_t level = 3;
+        uint32_t children[4] = {0, 0, 0, 0};
+        uint64_t cells = 0;
+    };
+
+    std::string rule;         // the #R line, or empty
+    uint64_t generation = 0;  // the #G line
+    std::vector<Node> nodes;  // children first; the last is the root
+
+    unsigned level() const { return nodes.empty() ? 3 : nodes.back().level; }
+};
+
+// A malformed file, with the 1-based line where reading stopped.
+class MacrocellError : public std::invalid_argument {
+public:
+    MacrocellError(const std::string& what, size_t line);
+    size_t line() const { return line_; }
+
+private:
+    size_t line_;
+};
+
+// Reads the two-state "[M2]" format; throws MacrocellError.
+Macrocell parse_macrocell(const std::string& text);
+std::string to_macrocell(const Macrocell& macrocell);
+
+// ORs the pattern in with its origin at (x, y), one live leaf at a time,
+// and switches the plane to its rule; HashLife::load takes the tree as it
+// is.
+void load_macrocell(Plane& plane, const Macrocell& macrocell, int64_t x = 0, int64_t y = 0);
+
+} // namespace gol
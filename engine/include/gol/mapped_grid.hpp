@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gol/aligned_allocator.hpp"
+#include "gol/grid.hpp"
+#include "gol/rule.hpp"
+
+namespace gol {
+
+// A torus like Grid, for boards larger than memory: the cells live in a
+// file mapped shared, and step() rewrites them in place rather than into a
+// second board. The file is a snapshot saved without `sparse` (see
+// snapshot.hpp), so save_snapshot output opens here, and load_snapshot
+// reads the file back into a Grid when it fits; the header's generation
+// and rule are kept current.
+//
+// Stepping runs in bands of whole tile rows, each band's tile rows in
+// parallel as in Grid's low-memory mode. The next band is prefetched while
+// one is stepped and bands are released once done, so about two bands are
+// resident and the rest is left to the page cache: past memory, throughput
+// falls to what the disk streams. Tile rows whose neighborhood did not
+// change in the last generation are skipped, unread.
+//
+// The file only changes through this object while it is open. All calls
+// throw std::runtime_error on I/O errors, and on systems without mmap.
+class MappedGrid {
+public:
+    static constexpr size_t kTileRows = Grid::kTileRows;
+    static constexpr size_t kDefaultResidentLimit = size_t(256) << 20;
+
+    // Creates `path` as an empty board, replacing any file there. The file
+    // is sparse until cells are written.
+    MappedGrid(const std::string& path, size_t width, size_t height);
+    // Opens a snapshot to step it, clearing any bits it holds past the width.
+    explicit MappedGrid(const std::string& path);
+    ~MappedGrid();
+    MappedGrid(const MappedGrid&) = delete;
+    MappedGrid& operator=(const MappedGrid&) = delete;
+
+    size_t width() const { return width_; }
+    size_t height() const { return height_; }
+    size_t generation() const { return generation_; }
+    void set_generation(size_t generation);
+
+    void set_rule(const Rule& rule);
+    const Rule& rule() const { return rule_; }
+
+    void set_cell(size_t x, size_t y, bool alive);
+    bool get_cell(size_t x, size_t y) const;
+
+    void step();
+    void step_n(size_t n);
+    // Punches the cells out of the file, so it takes no disk space again.
+    void clear();
+    // The cells Grid::randomize(density, seed) gives a grid of this size.
+    void randomize(double density = 0.1, uint64_t seed = 0);
+
+    // As Grid's: both wrap around the board.
+    void paste(const Grid& pattern, size_t x, size_t y, BlitMode mode = BlitMode::kOr);
+    Grid extract(size_t x, size_t y, size_t w, size_t h) const;
+
+    // Kept per tile row as it is stepped, so only edited rows are recounted.
+    size_t population() const;
+
+    // Packed cells, laid out as in Grid.
+    const uint64_t* data() const { return words_; }
+    size_t words_per_row() const { return words_per_row_; }
+
+    // Bytes of cells stepping keeps resident, about two bands; at least one
+    // tile row goes in a band.
+    void set_resident_limit(size_t bytes) { resident_limit_ = bytes; }
+    size_t resident_limit() const { return resident_limit_; }
+
+    // Writes every change out and waits for the disk.
+    void sync();
+
+private:
+    using Words = std::vector<uint64_t, AlignedAllocator<uint64_t, 64>>;
+
+    static constexpr uint64_t kPopStale = ~uint64_t(0);
+
+    void map(const std::string& path, int prot, size_t size);
+    void write_header();
+    uint64_t* row(size_t y) const { return words_ + y * words_per_row_; }
+    size_t tile_rows(size_t ty) const;
+    // Tile rows per band.
+    size_t band() const;
+    // madvise() hints for rows [begin, end), rounded out to whole pages.
+    void prefetch(size_t begin, size_t end) const;
+    void release(size_t begin, size_t end) const;
+    void edited(size_t y_begin, size_t y_end);
+    template <class Op>
+    void blit(const Grid& src, size_t sx, size_t sy, size_t w, size_t h, size_t dx, size_t dy,
+              Op op);
+
+    std::string path_;
+    int fd_ = -1;
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    uint64_t* words_ = nullptr;
+
+    size_t width_ = 0;
+    size_t height_ = 0;
+    size_t row_words_ = 0;      // words holding live cells
+    size_t words_per_row_ = 0;  // row stride in the file
+    size_t tiles_x_ = 0;
+    size_t tiles_y_ = 0;
+    size_t generation_ = 0;
+    size_t resident_limit_ = kDefaultResidentLimit;
+    Rule rule_;
+
+    std::vector<uint8_t> changed_;       // per tile row, in the last generation
+    std::vector<uint8_t> active_;        // scratch for step()
+    mutable std::vector<uint64_t> pop_;  // per tile row, kPopStale until recounted
+    Words edges_;  // step(): first and last row of each tile row in a band
+    Words wrap_;   // step(): rows 0 and height - 1 before the generation
+    Words above_;  // step(): the row above the band, before the generation
+};
+
+} // namespace gol
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "gol/rule.hpp"
+
+namespace gol {
+
+class Grid;
+
+// Life, or another rule, on the unbounded plane, stored as a hash map of
+// 64x64 packed tiles.
+// A tile exists only while it holds live cells: tiles are created when a
+// birth reaches them and dropped when they die out, so memory follows the
+// live region instead of a board size.
+//
+// width and height only describe a nominal view, the area randomize()
+// fills and the Python front ends draw; cells outside it live and move on
+// as usual. Coordinates are signed; cells set beyond +-2^37 are ignored.
+class Plane {
+public:
+    static constexpr size_t kTileSize = 64;
+
+    struct Rect {
+        int64_t x = 0;
+        int64_t y = 0;
+        uint64_t width = 0;
+        uint64_t height = 0;
+    };
+
+    explicit Plane(size_t width = 0, size_t height = 0);
+
+    size_t width() const { return width_; }
+    size_t height() const { return height_; }
+
+    // Rules with B0 would fill the whole plane at once, so they throw
+    // std::invalid_argument.
+    void set_rule(const Rule& rule);
+    const Rule& rule() const { return rule_; }
+
+    void set_cell(int64_t x, int64_t y, bool alive);
+    bool get_cell(int64_t x, int64_t y) const;
+
+    void step();
+    void step_n(size_t n);
+    void clear();
+    // Fills the nominal view, replacing what was there.
+    void randomize(double density = 0.1, uint64_t seed = 0);
+
+    void paste(const Grid& pattern, int64_t x, int64_t y);
+    Grid extract(int64_t x, int64_t y, size_t w, size_t h) const;
+
+    size_t population() const { return population_; }
+    size_t generation() const { return generation_; }
+    size_t tile_count() const { return tiles_.size(); }
+    size_t memory_usage() const;
+    Rect bounding_box() const;
+
+private:
+    struct alignas(64) Tile {
+        uint64_t rows[kTileSize];  // bit x of rows[y] is cell (x, y)
+    };
+    using Key = uint64_t;
+    using Tiles = std::unordered_map<Key, Tile>;
+
+    static Key key(int64_t tx, int64_t ty) {
+        return (uint64_t(uint32_t(ty)) << 32) | uint32_t(tx);
+    }
+    static int64_t key_x(Key k) { return int32_t(uint32_t(k)); }
+    static int64_t key_y(Key k) { return int32_t(uint32_t(k >> 32)); }
+    const Tile* find(int64_t tx, int64_t ty) const;
+
+    size_t width_;
+    size_t height_;
+    size_t generation_ = 0;
+    size_t population_ = 0;
+    Rule rule_;
+    Tiles tiles_;
+    std::vector<Key> candidates_;  // scratch for step()
+};
+
+} // namespace gol
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gol/grid.hpp"
+
+namespace gol {
+
+namespace detail {
+class MappedFile;
+}
+
+// Writes a run to disk as it happens: a keyframe of the whole board every
+// `keyframe_interval` generations and, in between, only the words that
+// changed, XOR-ed against the generation before. A delta costs a few bytes
+// per changed word, so a quiet board records almost nothing however large
+// it is.
+//
+// Attach it with grid.set_recorder(&recorder). The constructor writes the
+// grid as it stands; each record() after that appends one generation. A
+// generation that does not follow the last one recorded (after clear() or
+// set_generation()) starts a new keyframe. Throws std::runtime_error if the
+// file cannot be written.
+class Recorder {
+public:
+    Recorder(const std::string& path, const Grid& grid, size_t keyframe_interval = 1024);
+    ~Recorder();
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    // A grid other than the one last recorded (a copy carried on, say)
+    // starts a new keyframe and is followed from then on. Throws
+    // std::invalid_argument if its size differs from the recording's.
+    void record(const Grid& grid);
+    // Flushes and closes the file; record() does nothing afterwards.
+    void close();
+
+    size_t bytes_written() const { return bytes_; }
+
+private:
+    void write_keyframe(const Grid& grid);
+    void write_delta(const Grid& grid);
+    void write_record(uint8_t kind, uint64_t generation);
+
+    std::string path_;
+    std::FILE* file_ = nullptr;
+    const Grid* grid_;
+    size_t width_;
+    size_t height_;
+    size_t interval_;
+    uint64_t last_generation_ = 0;
+    uint64_t last_keyframe_ = 0;
+    uint64_t seen_ = 0;              // grid change_count() at the last record
+    std::vector<uint64_t> prev_;     // words as of the last record
+    std::vector<uint8_t> payload_;
+    size_t bytes_ = 0;
+};
+
+// Reads a recording back. Seeking restarts from the nearest keyframe at or
+// before the target, or carries on from the current generation when that
+// is closer. A recording cut short (by a crash, say) plays up to its last
+// whole record.
+class Player {
+public:
+    explicit Player(const std::string& path);
+    ~Player();
+    Player(const Player&) = delete;
+    Player& operator=(const Player&) = delete;
+
+    uint64_t first_generation() const { return records_.front().generation; }
+    uint64_t last_generation() const { return records_.back().generation; }
+    size_t keyframes() const { return keyframes_.size(); }
+
+    // The board at the last recorded generation not after `generation`;
+    // throws std::out_of_range before the first one.
+    const Grid& seek(uint64_t generation);
+    const Grid& grid() const { return grid_; }
+
+private:
+    struct Record {
+        uint64_t generation;
+        size_t offset;  // of the payload
+        size_t size;
+        bool keyframe;
+    };
+
+    void apply(const Record& record);
+
+    std::unique_ptr<detail::MappedFile> file_;
+    std::string path_;
+    std::vector<Record> records_;
+    std::vector<size_t> keyframes_;  // indices into records_
+    size_t at_ = 0;                  // record the grid shows
+    Grid grid_;
+};
+
+} // namespace gol
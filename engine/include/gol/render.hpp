@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace gol {
+
+class Grid;
+
+// Terminal lines of a board region for text UIs. Each character stacks two
+// blocks of zoom x zoom cells, drawn with ' ', U+2580 (upper half), U+2584
+// (lower half) or U+2588 (full block) in UTF-8; a block shows as lit if any
+// of its cells is alive. The h lines cover columns [x, x + w * zoom) and rows
+// [y, y + 2 * h * zoom), each line exactly w characters, and cells past the
+// edge of the board render blank rather than wrapping. Throws
+// std::invalid_argument if zoom is 0.
+std::vector<std::string> render_halfblock(const Grid& grid, size_t x, size_t y, size_t w,
+                                          size_t h, size_t zoom = 1);
+
+} // namespace gol
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <utility>
@@ -7,16 +9,58 @@
 namespace gol {
 
 class Grid;
+class MappedGrid;
+class Plane;
 
 struct RLEPattern {
     std::string name;
     size_t width = 0;
     size_t height = 0;
+    std::string rule;  // the header's "rule =" field as written, or empty
     std::vector<std::pair<size_t, size_t>> alive_cells;
 };
 
+// A malformed pattern, with the 1-based line and column where reading
+// stopped.
+class RLEError : public std::invalid_argument {
+public:
+    RLEError(const std::string& what, size_t line, size_t column);
+    size_t line() const { return line_; }
+    size_t column() const { return column_; }
+
+private:
+    size_t line_;
+    size_t column_;
+};
+
+// The readers throw RLEError for malformed input. parse_rle keeps any rule
+// as written, whether or not the engine supports it.
 RLEPattern parse_rle(const std::string& rle);
-std::string to_rle(const Grid& grid);
+// Also switches the grid or plane to the pattern's rule, if it names one,
+// and throws RLEError if it names one the engine cannot run. Bodies of
+// a megabyte or more are split at row ends and decoded on the grid thread
+// pool, with the same cells and errors as one pass.
 void load_rle(Grid& grid, const std::string& rle, size_t offset_x = 0, size_t offset_y = 0);
+void load_rle(Plane& plane, const std::string& rle, int64_t offset_x = 0, int64_t offset_y = 0);
+
+// Stream a file instead: it is memory-mapped where possible and decoded
+// like load_rle (read in chunks and decoded in one pass otherwise), runs
+// going straight into the grid's words, so nothing but the grid grows with
+// the pattern. Throw std::runtime_error if the file cannot be read.
+void load_rle_file(Grid& grid, const std::string& path, size_t offset_x = 0, size_t offset_y = 0);
+// A grid sized and ruled by the file's header.
+Grid read_rle_file(const std::string& path);
+
+// Golly-style RLE: runs are found a word at a time, the ends of blank rows
+// merge into one "n$" and lines wrap at 70 columns.
+std::string to_rle(const Grid& grid);
+std::string to_rle(const MappedGrid& grid);
+// The same, streamed out through a 64 KiB buffer so the encoding is never
+// held whole. Throw std::runtime_error if writing fails.
+void save_rle_file(const Grid& grid, const std::string& path);
+void save_rle_file(const MappedGrid& grid, const std::string& path);
+#if defined(__unix__) || defined(__APPLE__)
+void write_rle(const Grid& grid, int fd);
+#endif
 
 } // namespace gol
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace gol {
+
+// An outer-totalistic ("life-like") rule. Bit n of `birth` is set if a dead
+// cell with n live neighbors comes alive, bit n of `survive` if a live one
+// stays alive. The default is Conway's Life, B3/S23.
+struct Rule {
+    uint16_t birth = 1u << 3;
+    uint16_t survive = 1u << 2 | 1u << 3;
+
+    // Parses "B36/S23" (any case, either part first, either part may be
+    // empty), the older survive/birth form "23/36", and the names Life,
+    // HighLife, Seeds and DayAndNight. A Golly ":T..." topology suffix is
+    // ignored. Throws std::invalid_argument for anything else.
+    static Rule parse(const std::string& text);
+    // Canonical "B36/S23" form.
+    std::string to_string() const;
+
+    bool operator==(const Rule& other) const {
+        return birth == other.birth && survive == other.survive;
+    }
+    bool operator!=(const Rule& other) const { return !(*this == other); }
+};
+
+} // namespace gol
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "gol/grid.hpp"
+
+namespace gol {
+
+// Steps a grid continuously on a thread of its own, at a target rate or as
+// fast as it goes, and publishes copies of it for other threads to read.
+//
+// Copies live in three slots. A reader takes the latest without locking
+// and the stepper never waits for one: it only writes a slot that is
+// neither the latest nor held. While readers hold both others it keeps
+// stepping, or pauses and finishes edits all the same, and publishes once
+// a reader lets a slot go. Copies go out about kPublishHz times a second,
+// and whenever the runner pauses or applies an edit.
+class SimulationRunner {
+public:
+    static constexpr double kPublishHz = 120;
+
+    // A published copy, held until destroyed or released. Hold it no longer
+    // than needed, as its slot cannot be reused meanwhile, and never past
+    // the runner.
+    class Snapshot {
+    public:
+        Snapshot() = default;
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot&& other) noexcept;
+        ~Snapshot() { release(); }
+
+        const Grid& grid() const { return *grid_; }
+        const Grid* operator->() const { return grid_; }
+        explicit operator bool() const { return grid_ != nullptr; }
+        void release();
+
+    private:
+        friend class SimulationRunner;
+        Snapshot(const SimulationRunner* runner, const Grid* grid,
+                 std::atomic<uint32_t>* readers)
+            : runner_(runner), grid_(grid), readers_(readers) {}
+
+        const SimulationRunner* runner_ = nullptr;
+        const Grid* grid_ = nullptr;
+        std::atomic<uint32_t>* readers_ = nullptr;
+    };
+
+    // `rate` is in generations per second, 0 for as fast as possible.
+    explicit SimulationRunner(Grid grid, double rate = 0, bool paused = false);
+    ~SimulationRunner();
+    SimulationRunner(const SimulationRunner&) = delete;
+    SimulationRunner& operator=(const SimulationRunner&) = delete;
+
+    void pause();
+    void resume();
+    bool paused() const;
+    // While paused, runs n more generations and stays paused.
+    void step(size_t n = 1);
+    void set_rate(double rate);
+    double rate() const;
+
+    Snapshot snapshot() const;
+    // Blocks until a copy at `generation` or later is out, or the runner
+    // has nothing left to step, and returns the latest.
+    Snapshot wait_for(uint64_t generation);
+
+    // Runs fn(grid) on the stepping thread between steps and returns; the
+    // result is published at once, or as soon as a slot is free. An
+    // exception from fn is rethrown here. Throws
+    // std::logic_error once the runner is stopped.
+    void edit(const std::function<void(Grid&)>& fn);
+
+    // Measured over the last half second or so; 0 while idle.
+    double generations_per_second() const { return gens_per_second_.load(); }
+    // Of the latest copy.
+    uint64_t generation() const { return published_generation_.load(); }
+
+    // Stops the thread and hands back the grid. Snapshots stay readable.
+    Grid stop();
+
+private:
+    struct Slot {
+        explicit Slot(const Grid& g) : grid(0, 0) { grid.copy_state_from(g); }
+        Grid grid;
+        std::atomic<uint32_t> readers{0};
+    };
+    struct Edit {
+        const std::function<void(Grid&)>* fn;
+        std::exception_ptr error;
+        bool done = false;
+    };
+
+    void run();
+    bool publish();
+    // Called as the last reader lets a slot go.
+    void slot_freed() const;
+
+    Grid grid_;
+    std::unique_ptr<Slot> slots_[3];
+    std::atomic<int> latest_{0};
+    std::atomic<uint64_t> published_generation_;
+    std::atomic<double> gens_per_second_{0};
+    // Set while a copy waits for a free slot; the reader freeing one wakes
+    // the stepper.
+    mutable std::atomic<bool> want_slot_{false};
+
+    mutable std::mutex mutex_;  // guards the controls below, not the slots
+    mutable std::condition_variable wake_;  // the stepper waits here
+    std::condition_variable published_;     // edit() and wait_for() wait here
+    bool paused_;
+    bool stopping_ = false;
+    bool stopped_ = false;
+    bool idle_ = false;
+    bool repace_ = true;
+    size_t pending_ = 0;
+    double rate_;
+    std::deque<Edit*> edits_;
+    std::thread thread_;
+};
+
+} // namespace gol
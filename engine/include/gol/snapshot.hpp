@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace gol {
+
+class Grid;
+
+// Binary snapshots: a one-page header with the size, generation and rule,
+// then the grid's words exactly as they sit in memory, so loading maps the
+// file and copies rows straight in. `sparse` leaves out tiles without live
+// cells, behind a bitmap of the tiles present.
+//
+// Saving writes "<path>.tmp" and renames it over `path`, so a crash leaves
+// the previous snapshot whole. Both throw std::runtime_error on I/O errors
+// or a file that is not a snapshot this build can read.
+void save_snapshot(const Grid& grid, const std::string& path, bool sparse = false);
+Grid load_snapshot(const std::string& path);
+
+} // namespace gol
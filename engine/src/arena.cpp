@@ -0,0 +1,214 @@
+#include "gol/arena.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define GOL_ARENA_MMAP 1
+#endif
+
+namespace gol {
+
+namespace {
+
+size_t round_up(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+size_t page_size() {
+#ifdef GOL_ARENA_MMAP
+    static const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+    return page;
+#else
+    return 4096;
+#endif
+}
+
+HugePages default_mode() {
+    if (const char* env = std::getenv("GOL_HUGE_PAGES")) {
+        if (std::strcmp(env, "off") == 0) return HugePages::kOff;
+        if (std::strcmp(env, "reserve") == 0) return HugePages::kReserve;
+    }
+    return HugePages::kAdvise;
+}
+
+// A pooled block serves requests that would waste at most an eighth of it.
+bool fits(size_t block, size_t request) { return block >= request && block - request <= block / 8; }
+
+} // namespace
+
+// Never destroyed, so grids that outlive static destruction can still
+// hand their storage back.
+Arena& Arena::instance() {
+    static Arena* arena = new Arena;
+    return *arena;
+}
+
+Arena::Arena() : mode_(default_mode()) {}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+#ifdef GOL_ARENA_MMAP
+    if (bytes >= kMapMin && alignment <= page_size()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const bool huge = mode_ != HugePages::kOff && bytes >= kHugePage;
+        const size_t size = round_up(bytes, huge ? kHugePage : page_size());
+
+        auto it = free_.lower_bound(size);
+        if (it != free_.end() && fits(it->first, size)) {
+            uintptr_t address = it->second;
+            free_.erase(it);
+            pooled_ -= blocks_[address].size;
+            ++reused_;
+            return reinterpret_cast<void*>(address);
+        }
+
+        void* p = MAP_FAILED;
+        bool hugetlb = false;
+#ifdef MAP_HUGETLB
+        if (huge && mode_ == HugePages::kReserve) {
+            p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            hugetlb = p != MAP_FAILED;
+        }
+#endif
+        if (p == MAP_FAILED && huge) {
+            // Over-map by a huge page and cut the ends off to align it.
+            void* raw = ::mmap(nullptr, size + kHugePage, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw != MAP_FAILED) {
+                uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+                uintptr_t aligned = round_up(start, kHugePage);
+                if (aligned > start) ::munmap(raw, aligned - start);
+                size_t tail = start + size + kHugePage - (aligned + size);
+                if (tail) ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+                p = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+                ::madvise(p, size, MADV_HUGEPAGE);
+#endif
+            }
+        } else if (p == MAP_FAILED) {
+            p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        blocks_[reinterpret_cast<uintptr_t>(p)] = Block{size, hugetlb};
+        mapped_ += size;
+        return p;
+    }
+#endif
+    void* p = ::operator new(bytes, std::align_val_t(alignment));
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_ += bytes;
+    return p;
+}
+
+void Arena::deallocate(void* p, size_t bytes, size_t alignment) {
+    if (!p) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blocks_.find(reinterpret_cast<uintptr_t>(p));
+    if (it == blocks_.end()) {
+        heap_ -= bytes;
+        ::operator delete(p, std::align_val_t(alignment));
+        return;
+    }
+    const size_t size = it->second.size;
+    if (pooled_ + size > pool_limit_) {
+        unmap(it->first, it->second);
+        blocks_.erase(it);
+        return;
+    }
+    pooled_ += size;
+    free_.emplace(size, it->first);
+}
+
+void Arena::unmap(uintptr_t address, const Block& block) {
+#ifdef GOL_ARENA_MMAP
+    ::munmap(reinterpret_cast<void*>(address), block.size);
+#endif
+    mapped_ -= block.size;
+}
+
+void Arena::trim_to(size_t limit) {
+    // Largest blocks go first.
+    while (pooled_ > limit) {
+        auto it = std::prev(free_.end());
+        auto block = blocks_.find(it->second);
+        pooled_ -= block->second.size;
+        unmap(block->first, block->second);
+        blocks_.erase(block);
+        free_.erase(it);
+    }
+}
+
+void Arena::set_huge_pages(HugePages mode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mode_ = mode;
+}
+
+HugePages Arena::huge_pages() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mode_;
+}
+
+void Arena::set_pool_limit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pool_limit_ = bytes;
+    trim_to(bytes);
+}
+
+size_t Arena::pool_limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pool_limit_;
+}
+
+void Arena::trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trim_to(0);
+}
+
+// MAP_HUGETLB blocks count whole. For the rest, /proc/self/smaps gives the
+// transparent huge pages of each mapping; the kernel may merge blocks with
+// their neighbors into one mapping, so each mapping counts at most the
+// bytes of ours it overlaps.
+Arena::Stats Arena::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.mapped = mapped_;
+    stats.pooled = pooled_;
+    stats.heap = heap_;
+    stats.reused = reused_;
+    for (const auto& entry : blocks_)
+        if (entry.second.hugetlb) stats.huge += entry.second.size;
+#ifdef __linux__
+    if (blocks_.empty()) return stats;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    uintptr_t start = 0, end = 0;
+    while (std::getline(smaps, line)) {
+        unsigned long long a, b;
+        if (std::sscanf(line.c_str(), "%llx-%llx ", &a, &b) == 2) {
+            start = uintptr_t(a);
+            end = uintptr_t(b);
+            continue;
+        }
+        unsigned long long kb;
+        if (std::sscanf(line.c_str(), "AnonHugePages: %llu kB", &kb) != 1 || kb == 0) continue;
+        size_t overlap = 0;
+        auto it = blocks_.upper_bound(start);
+        if (it != blocks_.begin()) --it;
+        for (; it != blocks_.end() && it->first < end; ++it) {
+            uintptr_t lo = std::max(start, it->first);
+            uintptr_t hi = std::min(end, it->first + it->second.size);
+            if (!it->second.hugetlb && hi > lo) overlap += hi - lo;
+        }
+        stats.huge += std::min(overlap, size_t(kb) * 1024);
+    }
+#endif
+    return stats;
+}
+
+} // namespace gol
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace gol {
+namespace detail {
+
+// SplitMix64: the odd constant its counter steps by, and the finalizer that
+// scrambles a counter value into a random-looking word. Grid hashes and
+// RandomWords both build on these.
+constexpr uint64_t kSplitMixGamma = 0x9E3779B97F4A7C15ULL;
+
+inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Sets or clears bits [begin, end) of a packed row, whole words at a time.
+inline void fill_bits(uint64_t* row, size_t begin, size_t end, bool value) {
+    if (begin >= end) return;
+    size_t first = begin / 64;
+    size_t last = (end - 1) / 64;
+    for (size_t w = first; w <= last; ++w) {
+        uint64_t mask = ~uint64_t(0);
+        if (w == first) mask &= ~uint64_t(0) << (begin % 64);
+        if (w == last) mask &= ~uint64_t(0) >> (63 - (end - 1) % 64);
+        row[w] = value ? row[w] | mask : row[w] & ~mask;
+    }
+}
+
+// Whether any of bits [begin, end) of a packed row is set.
+inline bool any_bits(const uint64_t* row, size_t begin, size_t end) {
+    if (begin >= end) return false;
+    size_t first = begin / 64;
+    size_t last = (end - 1) / 64;
+    for (size_t w = first; w <= last; ++w) {
+        uint64_t mask = ~uint64_t(0);
+        if (w == first) mask &= ~uint64_t(0) << (begin % 64);
+        if (w == last) mask &= ~uint64_t(0) >> (63 - (end - 1) % 64);
+        if (row[w] & mask) return true;
+    }
+    return false;
+}
+
+// Bits [at, at + 64) of a packed row, where `at` may be negative; bits
+// outside words [first, last] read as zero and are never loaded.
+inline uint64_t load_bits(const uint64_t* row, int64_t at, size_t first, size_t last) {
+    auto word = [&](int64_t k) {
+        return k >= int64_t(first) && k <= int64_t(last) ? row[k] : 0;
+    };
+    int64_t k = at >= 0 ? at / 64 : -((63 - at) / 64);
+    unsigned shift = unsigned(at & 63);
+    if (!shift) return word(k);
+    return (word(k) >> shift) | (word(k + 1) << (64 - shift));
+}
+
+inline uint64_t reverse64(uint64_t v) {
+    v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+    v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(v);
+}
+
+// Transposes a 64x64 bit block in place: bit x of word y swaps with bit y
+// of word x.
+inline void transpose64(uint64_t* a) {
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (unsigned j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+        for (unsigned k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t t = ((a[k] >> j) ^ a[k | j]) & mask;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+// Combines `count` bits of a packed row starting at src_bit into another
+// starting at dst_bit, op(old, new, mask) deciding each destination word;
+// bits outside the mask must come back unchanged. Source words past the
+// range are never read. Returns whether any destination bit changed.
+template <class Op>
+inline bool blit_bits(uint64_t* dst, size_t dst_bit, const uint64_t* src, size_t src_bit,
+                      size_t count, Op op) {
+    if (count == 0) return false;
+    const size_t first = dst_bit / 64;
+    const size_t last = (dst_bit + count - 1) / 64;
+    const size_t src_first = src_bit / 64;
+    const size_t src_last = (src_bit + count - 1) / 64;
+    // Bit 0 of destination word w lines up with source bit w * 64 + delta.
+    const int64_t delta = int64_t(src_bit) - int64_t(dst_bit);
+    const unsigned shift = unsigned(delta & 63);
+    auto edge = [&](size_t w) {
+        uint64_t mask = ~uint64_t(0);
+        if (w == first) mask &= ~uint64_t(0) << (dst_bit % 64);
+        if (w == last) mask &= ~uint64_t(0) >> (63 - (dst_bit + count - 1) % 64);
+        uint64_t old = dst[w];
+        dst[w] = op(old, load_bits(src, int64_t(w * 64) + delta, src_first, src_last), mask);
+        return old ^ dst[w];
+    };
+
+    uint64_t changed = edge(first);
+    if (last == first) return changed != 0;
+    // Whole words in between read whole source words, unchecked.
+    const uint64_t* s = src + (int64_t((first + 1) * 64) + delta) / 64;
+    if (shift) {
+        for (size_t w = first + 1; w < last; ++w, ++s) {
+            uint64_t old = dst[w];
+            dst[w] = op(old, (s[0] >> shift) | (s[1] << (64 - shift)), ~uint64_t(0));
+            changed |= old ^ dst[w];
+        }
+    } else {
+        for (size_t w = first + 1; w < last; ++w, ++s) {
+            uint64_t old = dst[w];
+            dst[w] = op(old, *s, ~uint64_t(0));
+            changed |= old ^ dst[w];
+        }
+    }
+    changed |= edge(last);
+    return changed != 0;
+}
+
+// Word ops for the paste modes, as blit_bits takes them.
+struct OrBits {
+    uint64_t operator()(uint64_t old, uint64_t bits, uint64_t mask) const {
+        return old | (bits & mask);
+    }
+};
+struct AndBits {
+    uint64_t operator()(uint64_t old, uint64_t bits, uint64_t mask) const {
+        return old & (bits | ~mask);
+    }
+};
+struct XorBits {
+    uint64_t operator()(uint64_t old, uint64_t bits, uint64_t mask) const {
+        return old ^ (bits & mask);
+    }
+};
+struct CopyBits {
+    uint64_t operator()(uint64_t old, uint64_t bits, uint64_t mask) const {
+        return (old & ~mask) | (bits & mask);
+    }
+};
+
+// Splits `length` positions from `start` around a ring of `size` into runs
+// that do not wrap: fn(offset into the length, position on the ring, run).
+template <class Fn>
+void wrap_runs(size_t start, size_t length, size_t size, Fn&& fn) {
+    size_t at = start % size;
+    for (size_t done = 0; done < length; at = 0) {
+        size_t run = std::min(length - done, size - at);
+        fn(done, at, run);
+        done += run;
+    }
+}
+
+// Copies `count` bits from src_bit on into dst_bit on in reverse order:
+// the last source bit lands first. The ranges must not share words.
+inline void copy_reversed(uint64_t* dst, size_t dst_bit, const uint64_t* src, size_t src_bit,
+                          size_t count) {
+    if (count == 0) return;
+    const size_t first = dst_bit / 64;
+    const size_t last = (dst_bit + count - 1) / 64;
+    const size_t src_first = src_bit / 64;
+    const size_t src_last = (src_bit + count - 1) / 64;
+    // Bit j of destination word w comes from source bit top - j.
+    const int64_t top = int64_t(src_bit + count - 1 + dst_bit);
+    for (size_t w = first; w <= last; ++w) {
+        uint64_t mask = ~uint64_t(0);
+        if (w == first) mask &= ~uint64_t(0) << (dst_bit % 64);
+        if (w == last) mask &= ~uint64_t(0) >> (63 - (dst_bit + count - 1) % 64);
+        int64_t at = top - int64_t(w * 64) - 63;
+        uint64_t bits = reverse64(load_bits(src, at, src_first, src_last));
+        dst[w] = (dst[w] & ~mask) | (bits & mask);
+    }
+}
+
+} // namespace detail
+} // namespace gol
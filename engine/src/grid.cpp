@@ -1,19 +1,60 @@
 #include "gol/grid.hpp"
-#include <random>
+#include "gol/recorder.hpp"
+#include "gol/snapshot.hpp"
+#include "bits.hpp"
+#include "kernel.hpp"
+#include "random_words.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
 #include <cstring>
-
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include <stdexcept>
+#include <unordered_map>
 
 namespace gol {
 
+namespace {
+
+// Row stride granularity: one 64-byte line, the widest vector load.
+constexpr size_t kRowAlignWords = 8;
+
+// Temporal blocking: boards below kBlockMinBytes stay in the cache anyway,
+// and each band's scratch rows are sized to about kBlockScratchBytes.
+constexpr size_t kBlockMinBytes = size_t(8) << 20;
+constexpr size_t kBlockScratchBytes = size_t(256) << 10;
+constexpr size_t kBlockDefaultDepth = 8;
+// Words are hashed salted with their position and summed, so tile hashes
+// add up to the board hash and empty words cost nothing.
+constexpr uint64_t kHashSalt = detail::kSplitMixGamma;
+
+static_assert(Grid::kTileWords == detail::kTileWords, "kernel and grid tiles differ");
+static_assert(Grid::kTileWords % kRowAlignWords == 0, "tiles must be whole lines");
+
+} // namespace
+
 Grid::Grid(size_t width, size_t height)
     : width_(width), height_(height),
-      words_per_row_((width + 63) / 64),
-      data_(words_per_row_ * height, 0),
-      buffer_(words_per_row_ * height, 0) {}
+      row_words_((width + 63) / 64),
+      words_per_row_((row_words_ + kRowAlignWords - 1) / kRowAlignWords * kRowAlignWords),
+      tiles_x_((row_words_ + kTileWords - 1) / kTileWords),
+      tiles_y_((height + kTileRows - 1) / kTileRows),
+      tile_changed_(tiles_x_ * tiles_y_, 1),
+      tile_active_(tiles_x_ * tiles_y_, 0),
+      tile_diff_(tiles_x_ * tiles_y_, 0),
+      row_diff_(tiles_x_ * tiles_y_, 0),
+      tile_pop_(tiles_x_ * tiles_y_, 0),
+      tile_hash_(tiles_x_ * tiles_y_, 0),
+      tile_stamp_(tiles_x_ * tiles_y_, 0),
+      row_stamp_(height, 0) {
+    // Each tile row is zeroed by the worker that steps it.
+    data_.resize(words_per_row_ * height);
+    buffer_.resize(words_per_row_ * height);
+    detail::ThreadPool::instance().parallel_for(tiles_y_, [&](size_t ty, size_t) {
+        size_t begin = ty * kTileRows * words_per_row_;
+        size_t end = std::min(height_, (ty + 1) * kTileRows) * words_per_row_;
+        std::fill(data_.begin() + begin, data_.begin() + end, 0);
+        std::fill(buffer_.begin() + begin, buffer_.begin() + end, 0);
+    });
+}
 
 void Grid::set_cell(size_t x, size_t y, bool alive) {
     if (x >= width_ || y >= height_) return;
@@ -23,6 +64,26 @@ void Grid::set_cell(size_t x, size_t y, bool alive) {
         data_[idx] |= mask;
     else
         data_[idx] &= ~mask;
+    size_t tile = tile_index(x, y);
+    tile_changed_[tile] = 1;
+    tile_pop_[tile] = kPopStale;
+    tile_hash_[tile] = kHashStale;
+    tile_stamp_[tile] = ++change_count_;
+    row_stamp_[y] = change_count_;
+}
+
+void Grid::set_span(size_t x, size_t y, size_t length, bool alive) {
+    if (x >= width_ || y >= height_ || length == 0) return;
+    size_t end = x + std::min(length, width_ - x);
+    detail::fill_bits(&data_[y * words_per_row_], x, end, alive);
+    row_stamp_[y] = ++change_count_;
+    for (size_t tx = x / 64 / kTileWords; tx <= (end - 1) / 64 / kTileWords; ++tx) {
+        size_t tile = (y / kTileRows) * tiles_x_ + tx;
+        tile_changed_[tile] = 1;
+        tile_pop_[tile] = kPopStale;
+        tile_hash_[tile] = kHashStale;
+        tile_stamp_[tile] = change_count_;
+    }
 }
 
 bool Grid::get_cell(size_t x, size_t y) const {
@@ -30,127 +91,672 @@ bool Grid::get_cell(size_t x, size_t y) const {
     return (data_[word_index(x, y)] & bit_mask(x)) != 0;
 }
 
-int Grid::count_neighbors(size_t x, size_t y) const {
-    int count = 0;
-    size_t w = width_;
-    size_t h = height_;
+void Grid::set_rule(const Rule& rule) {
+    rule_ = rule;
+    // Skipping a tile relies on it having been stepped with the same rule.
+    touch_all();
+}
+
+void Grid::step() {
+    ensure_scratch();
+    const detail::RuleTable rule = detail::make_rule_table(rule_.birth, rule_.survive);
+    const detail::StepRowFn step_row = detail::active_kernel().step_row[rule.kind];
 
-    size_t xm = (x + w - 1) % w;
-    size_t xp = (x + 1) % w;
-    size_t ym = (y + h - 1) % h;
-    size_t yp = (y + 1) % h;
+    // A tile can only change if it or one of its eight neighbors changed in
+    // the last generation. Neighbors wrap around like the board does.
+    for (size_t ty = 0; ty < tiles_y_; ++ty) {
+        size_t tym = (ty + tiles_y_ - 1) % tiles_y_;
+        size_t typ = (ty + 1) % tiles_y_;
+        for (size_t tx = 0; tx < tiles_x_; ++tx) {
+            size_t txm = (tx + tiles_x_ - 1) % tiles_x_;
+            size_t txp = (tx + 1) % tiles_x_;
+            uint8_t active = 0;
+            for (size_t row : {tym, ty, typ}) {
+                const uint8_t* changed = &tile_changed_[row * tiles_x_];
+                active |= changed[txm] | changed[tx] | changed[txp];
+            }
+            tile_active_[ty * tiles_x_ + tx] = active;
+        }
+    }
 
-    auto get = [&](size_t cx, size_t cy) -> int {
-        return (data_[cy * words_per_row_ + cx / 64] >> (cx % 64)) & 1;
+    // Inactive tiles are left alone: buffer_ holds the previous generation,
+    // which equals both the current and the next one there.
+    const uint64_t stamp = ++change_count_;
+    auto row_active = [&](size_t ty) {
+        const uint8_t* active = &tile_active_[ty * tiles_x_];
+        return std::find(active, active + tiles_x_, 1) != active + tiles_x_;
     };
+    detail::ThreadPool& pool = detail::ThreadPool::instance();
+    // In place, a tile row reads the rows just outside it from edges_, as
+    // its neighbors may have overwritten them already; its own rows are
+    // written back one behind, once the row below no longer needs them.
+    std::vector<Words> pending;
+    if (low_memory_) {
+        for (size_t ty = 0; ty < tiles_y_; ++ty) {
+            if (!row_active((ty + tiles_y_ - 1) % tiles_y_) && !row_active((ty + 1) % tiles_y_))
+                continue;
+            size_t first = ty * kTileRows;
+            size_t last = std::min(height_, first + kTileRows) - 1;
+            std::copy_n(&data_[first * words_per_row_], row_words_, &edges_[2 * ty * words_per_row_]);
+            std::copy_n(&data_[last * words_per_row_], row_words_,
+                        &edges_[(2 * ty + 1) * words_per_row_]);
+        }
+        pending.resize(pool.size());
+    }
+    Words& next = low_memory_ ? data_ : buffer_;
+    pool.parallel_for(tiles_y_, [&](size_t ty, size_t worker) {
+        const uint8_t* active = &tile_active_[ty * tiles_x_];
+        uint64_t* diff = &tile_diff_[ty * tiles_x_];
+        uint64_t* row_diff = &row_diff_[ty * tiles_x_];
+        if (!row_active(ty)) {
+            std::fill(&tile_changed_[ty * tiles_x_], &tile_changed_[(ty + 1) * tiles_x_], 0);
+            return;
+        }
+        std::fill(diff, diff + tiles_x_, 0);
+        if (low_memory_ && pending[worker].empty()) pending[worker].resize(2 * words_per_row_);
+        auto write_back = [&](size_t y) {
+            const uint64_t* from = &pending[worker][(y % 2) * words_per_row_];
+            for (size_t tx = 0; tx < tiles_x_;) {
+                if (!active[tx]) { ++tx; continue; }
+                size_t run_end = tx;
+                while (run_end < tiles_x_ && active[run_end]) ++run_end;
+                size_t begin = tx * kTileWords, end = std::min(run_end * kTileWords, row_words_);
+                std::memcpy(&data_[y * words_per_row_ + begin], from + begin,
+                            (end - begin) * sizeof(uint64_t));
+                tx = run_end;
+            }
+        };
 
-    count += get(xm, ym);
-    count += get(x,  ym);
-    count += get(xp, ym);
-    count += get(xm, y);
-    count += get(xp, y);
-    count += get(xm, yp);
-    count += get(x,  yp);
-    count += get(xp, yp);
+        size_t y_begin = ty * kTileRows;
+        size_t y_end = std::min(height_, (ty + 1) * kTileRows);
+        for (size_t y = y_begin; y < y_end; ++y) {
+            const uint64_t* up = &data_[((y + height_ - 1) % height_) * words_per_row_];
+            const uint64_t* mid = &data_[y * words_per_row_];
+            const uint64_t* down = &data_[((y + 1) % height_) * words_per_row_];
+            uint64_t* out;
+            if (low_memory_) {
+                if (y == y_begin)
+                    up = &edges_[(2 * ((ty + tiles_y_ - 1) % tiles_y_) + 1) * words_per_row_];
+                if (y + 1 == y_end) down = &edges_[2 * ((ty + 1) % tiles_y_) * words_per_row_];
+                out = &pending[worker][(y % 2) * words_per_row_];
+            } else {
+                out = &buffer_[y * words_per_row_];
+            }
 
-    return count;
-}
+            // Runs of adjacent active tiles go to the kernel in one call.
+            // The kernel's diffs are taken per row, which stamps the rows
+            // that changed at the cost of folding them into the tiles'.
+            std::fill(row_diff, row_diff + tiles_x_, 0);
+            for (size_t tx = 0; tx < tiles_x_;) {
+                if (!active[tx]) { ++tx; continue; }
+                size_t run_end = tx;
+                while (run_end < tiles_x_ && active[run_end]) ++run_end;
+                step_row(up, mid, down, out, tx * kTileWords,
+                         std::min(run_end * kTileWords, row_words_),
+                         row_words_, width_, row_diff + tx, rule.masks);
+                tx = run_end;
+            }
+            uint64_t row_changed = 0;
+            for (size_t tx = 0; tx < tiles_x_; ++tx) {
+                diff[tx] |= row_diff[tx];
+                row_changed |= row_diff[tx];
+            }
+            if (row_changed) row_stamp_[y] = stamp;
+            if (low_memory_ && y > y_begin) write_back(y - 1);
+        }
+        if (low_memory_) write_back(y_end - 1);
 
-void Grid::step() {
-    std::fill(buffer_.begin(), buffer_.end(), 0);
-
-    #ifdef _OPENMP
-    #pragma omp parallel for schedule(static)
-    #endif
-    for (size_t y = 0; y < height_; ++y) {
-        for (size_t x = 0; x < width_; ++x) {
-            int neighbors = count_neighbors(x, y);
-            bool alive = get_cell(x, y);
-            bool next = (alive && (neighbors == 2 || neighbors == 3)) ||
-                        (!alive && neighbors == 3);
-            if (next) {
-                buffer_[y * words_per_row_ + x / 64] |= uint64_t(1) << (x % 64);
+        // Unchanged tiles keep their cached population.
+        for (size_t tx = 0; tx < tiles_x_; ++tx) {
+            size_t tile = ty * tiles_x_ + tx;
+            tile_changed_[tile] = diff[tx] != 0;
+            if (diff[tx]) {
+                tile_pop_[tile] = kPopStale;
+                tile_hash_[tile] = hash_in_step_ ? hash_tile(next, tile) : kHashStale;
+                tile_stamp_[tile] = stamp;
             }
         }
-    }
+    });
 
-    std::swap(data_, buffer_);
+    if (!low_memory_) std::swap(data_, buffer_);
     ++generation_;
+    if (recorder_.ptr) recorder_.ptr->record(*this);
 }
 
 void Grid::step_n(size_t n) {
-    for (size_t i = 0; i < n; ++i) {
-        step();
+    while (n > 0) {
+        size_t depth = temporal_depth_ ? temporal_depth_ : auto_temporal_depth();
+        size_t k = recorder_.ptr || low_memory_ ? 1 : std::min(depth, n);
+        if (checkpoint_every_)
+            k = std::min(k, checkpoint_every_ - generation_ % checkpoint_every_);
+        if (k > 1)
+            step_blocked(k);
+        else
+            step();
+        n -= k;
+        if (checkpoint_every_ && generation_ % checkpoint_every_ == 0)
+            save_snapshot(*this, checkpoint_path_, checkpoint_sparse_);
     }
 }
 
+void Grid::set_low_memory(bool on) {
+    if (on == low_memory_) return;
+    low_memory_ = on;
+    if (on) {
+        Words().swap(buffer_);
+        edges_.assign(2 * tiles_y_ * words_per_row_, 0);
+    } else {
+        // A copy of the board is an exact previous generation for every
+        // tile that step() would skip.
+        buffer_ = data_;
+        Words().swap(edges_);
+    }
+}
+
+void Grid::set_checkpoint(const std::string& path, size_t every, bool sparse) {
+    checkpoint_path_ = path;
+    checkpoint_every_ = path.empty() ? 0 : every;
+    checkpoint_sparse_ = sparse;
+}
+
+// Blocking recomputes every tile, so it only pays off on big boards where
+// most tiles are changing anyway.
+size_t Grid::auto_temporal_depth() const {
+    if (data_.size() * sizeof(uint64_t) < kBlockMinBytes) return 1;
+    if (changed_tiles() * 2 < tile_changed_.size()) return 1;
+    return kBlockDefaultDepth;
+}
+
+// Advances `generations` steps in one pass over the board. Each band of
+// rows starts from the band plus `generations` halo rows either side and
+// keeps one row fewer per side each generation, so the last one is exactly
+// the band; only that one is written back.
+void Grid::step_blocked(size_t generations) {
+    ensure_scratch();
+    const detail::RuleTable rule = detail::make_rule_table(rule_.birth, rule_.survive);
+    const detail::StepRowFn step_row = detail::active_kernel().step_row[rule.kind];
+    const size_t k = generations;
+    const size_t stride = words_per_row_;
+    if (height_ == 0) {
+        generation_ += k;
+        return;
+    }
+    size_t band_rows = kBlockScratchBytes / (stride * sizeof(uint64_t));
+    band_rows = std::min(height_, std::max(band_rows > 2 * k ? band_rows - 2 * k : 0, 4 * k));
+    const size_t bands = (height_ + band_rows - 1) / band_rows;
+    // Row y0 - k + i of the board, wrapped.
+    const size_t lift = (k / height_ + 1) * height_ - k;
+
+    detail::ThreadPool& pool = detail::ThreadPool::instance();
+    std::vector<Words> scratch(2 * pool.size());
+    std::vector<std::vector<uint64_t>> diffs(pool.size());
+
+    pool.parallel_for(bands, [&](size_t band, size_t worker) {
+        Words* pair = &scratch[2 * worker];
+        std::vector<uint64_t>& diff = diffs[worker];
+        if (diff.empty()) {
+            pair[0].resize((band_rows + 2 * k) * stride);
+            pair[1].resize((band_rows + 2 * k) * stride);
+            diff.resize(tiles_x_);
+        }
+
+        size_t y0 = band * band_rows;
+        size_t rows = std::min(band_rows, height_ - y0) + 2 * k;
+        auto board_row = [&](size_t i) { return ((y0 + i + lift) % height_) * stride; };
+
+        for (size_t g = 1; g <= k; ++g) {
+            const uint64_t* src = g == 1 ? nullptr : pair[g % 2].data();
+            uint64_t* dst = pair[(g + 1) % 2].data();
+            auto in = [&](size_t i) {
+                return src ? src + i * stride : &data_[board_row(i)];
+            };
+            for (size_t i = g; i < rows - g; ++i) {
+                uint64_t* out = g == k ? &buffer_[board_row(i)] : dst + i * stride;
+                step_row(in(i - 1), in(i), in(i + 1), out, 0, row_words_,
+                         row_words_, width_, diff.data(), rule.masks);
+            }
+        }
+    });
+
+    // buffer_ now holds generation k and data_ generation 0, so the tile
+    // bookkeeping restarts from scratch.
+    std::swap(data_, buffer_);
+    touch_all();
+    generation_ += k;
+}
+
 void Grid::clear() {
     std::fill(data_.begin(), data_.end(), 0);
+    touch_all();
+    std::fill(tile_pop_.begin(), tile_pop_.end(), 0);
+    std::fill(tile_hash_.begin(), tile_hash_.end(), 0);
     generation_ = 0;
 }
 
-void Grid::randomize(double density, uint64_t seed) {
-    std::mt19937_64 rng(seed ? seed : std::random_device{}());
-    std::bernoulli_distribution dist(density);
+void Grid::replace(const Grid& other) {
+    if (&other == this) return;
+    std::string path = std::move(checkpoint_path_);
+    const size_t every = checkpoint_every_;
+    const bool sparse = checkpoint_sparse_;
+    Recorder* recorder = recorder_.ptr;
+    const uint64_t count = change_count_;
+    *this = other;
+    checkpoint_path_ = std::move(path);
+    checkpoint_every_ = every;
+    checkpoint_sparse_ = sparse;
+    recorder_.ptr = recorder;
+    change_count_ = std::max(change_count_, count);
+    touch_all();
+}
 
-    std::fill(data_.begin(), data_.end(), 0);
-    for (size_t y = 0; y < height_; ++y) {
-        for (size_t x = 0; x < width_; ++x) {
-            if (dist(rng)) {
-                data_[y * words_per_row_ + x / 64] |= uint64_t(1) << (x % 64);
-            }
-        }
+void Grid::copy_state_from(const Grid& other) {
+    if (&other == this) return;
+    width_ = other.width_;
+    height_ = other.height_;
+    row_words_ = other.row_words_;
+    words_per_row_ = other.words_per_row_;
+    generation_ = other.generation_;
+    temporal_depth_ = other.temporal_depth_;
+    checkpoint_path_ = other.checkpoint_path_;
+    checkpoint_every_ = other.checkpoint_every_;
+    checkpoint_sparse_ = other.checkpoint_sparse_;
+    recorder_.ptr = nullptr;
+    change_count_ = other.change_count_;
+    hash_in_step_ = other.hash_in_step_;
+    low_memory_ = other.low_memory_;
+    rule_ = other.rule_;
+    data_.assign(other.data_.begin(), other.data_.end());
+    buffer_.clear();
+    edges_.clear();
+    tiles_x_ = other.tiles_x_;
+    tiles_y_ = other.tiles_y_;
+    tile_changed_ = other.tile_changed_;
+    tile_active_.resize(tile_changed_.size());
+    tile_diff_.resize(tile_changed_.size());
+    row_diff_.resize(tile_changed_.size());
+    tile_pop_ = other.tile_pop_;
+    tile_hash_ = other.tile_hash_;
+    tile_stamp_ = other.tile_stamp_;
+    row_stamp_ = other.row_stamp_;
+}
+
+// Brings back the scratch copy_state_from() leaves out. A new buffer_ holds
+// no previous generation, so no tile may be skipped the next step.
+void Grid::ensure_scratch() {
+    if (low_memory_) {
+        const size_t edges = 2 * tiles_y_ * words_per_row_;
+        if (edges_.size() != edges) edges_.assign(edges, 0);
+        return;
     }
+    if (buffer_.size() == data_.size()) return;
+    buffer_.assign(data_.size(), 0);
+    std::fill(tile_changed_.begin(), tile_changed_.end(), 1);
+}
+
+void Grid::touch() {
+    touch_all();
+}
+
+void Grid::touch_all() {
+    std::fill(tile_changed_.begin(), tile_changed_.end(), 1);
+    std::fill(tile_pop_.begin(), tile_pop_.end(), kPopStale);
+    std::fill(tile_hash_.begin(), tile_hash_.end(), kHashStale);
+    std::fill(tile_stamp_.begin(), tile_stamp_.end(), ++change_count_);
+    std::fill(row_stamp_.begin(), row_stamp_.end(), change_count_);
+}
+
+void Grid::randomize(double density, uint64_t seed, Symmetry symmetry) {
+    if ((symmetry == Symmetry::kC4 || symmetry == Symmetry::kD8) && width_ != height_)
+        throw std::invalid_argument("randomize: C4 and D8 soups need a square grid");
+    const detail::RandomWords random(density, seed);
+    const uint64_t last_mask =
+        width_ % 64 ? (uint64_t(1) << (width_ % 64)) - 1 : ~uint64_t(0);
+    detail::ThreadPool::instance().parallel_for(tiles_y_, [&](size_t ty, size_t) {
+        size_t end = std::min(height_, (ty + 1) * kTileRows);
+        for (size_t y = ty * kTileRows; y < end; ++y) {
+            uint64_t* row = &data_[y * words_per_row_];
+            for (size_t w = 0; w < row_words_; ++w) row[w] = random(y * row_words_ + w);
+            if (row_words_) row[row_words_ - 1] &= last_mask;
+        }
+    });
+    symmetrize(symmetry);
+    touch_all();
     generation_ = 0;
 }
 
-void Grid::paste(const Grid& pattern, size_t ox, size_t oy) {
-    for (size_t py = 0; py < pattern.height_; ++py) {
-        for (size_t px = 0; px < pattern.width_; ++px) {
-            if (pattern.get_cell(px, py)) {
-                size_t tx = (ox + px) % width_;
-                size_t ty = (oy + py) % height_;
-                set_cell(tx, ty, true);
-            }
+// Makes every cell a copy of one representative of its orbit under the
+// symmetry, working a row at a time from the random board. The transpose,
+// where one is needed, goes in buffer_; touch_all() afterwards makes step()
+// rewrite all of it.
+void Grid::symmetrize(Symmetry symmetry) {
+    if (symmetry == Symmetry::kNone || width_ == 0 || height_ == 0) return;
+    detail::ThreadPool& pool = detail::ThreadPool::instance();
+    auto row = [&](Words& words, size_t y) { return &words[y * words_per_row_]; };
+    const size_t n = width_;
+    const size_t half = n / 2, upper = n - half;  // columns left of and from the middle
+
+    if (symmetry == Symmetry::kC2) {
+        // (x, y) ~ (n-1-x, h-1-y): the bottom rows are the top ones read
+        // backwards, and an odd middle row mirrors its left half.
+        const size_t h = height_;
+        pool.parallel_for(h / 2, [&](size_t i, size_t) {
+            detail::copy_reversed(row(data_, h - 1 - i), 0, row(data_, i), 0, n);
+        });
+        if (h % 2) {
+            uint64_t* middle = row(data_, h / 2);
+            std::vector<uint64_t> left(middle, middle + row_words_);
+            detail::copy_reversed(middle, upper, left.data(), 0, half);
+        }
+        return;
+    }
+
+    // The transpose of data_, in 64x64 blocks; in low-memory mode it needs
+    // a board of its own for the while.
+    ensure_scratch();
+    Words scratch;
+    if (low_memory_) scratch.resize(data_.size());
+    Words& transposed = low_memory_ ? scratch : buffer_;
+    const size_t blocks = row_words_;
+    pool.parallel_for(blocks, [&](size_t by, size_t) {
+        uint64_t block[64];
+        for (size_t bx = 0; bx < blocks; ++bx) {
+            for (size_t i = 0; i < 64; ++i)
+                block[i] = by * 64 + i < n ? row(data_, by * 64 + i)[bx] : 0;
+            detail::transpose64(block);
+            for (size_t i = 0; i < 64 && bx * 64 + i < n; ++i)
+                row(transposed, bx * 64 + i)[by] = block[i];
         }
+    });
+    const detail::CopyBits copy;
+
+    if (symmetry == Symmetry::kC4) {
+        // A quarter turn takes (x, y) to (n-1-y, x). The top-left block
+        // [0, upper) x [0, half) keeps its cells and its turns tile the
+        // rest of the board around the middle cell:
+        //   top right    [upper, n) x [0, upper)  cell (x, y) = A(y, n-1-x)
+        //   bottom right [half, n) x [upper, n)   cell (x, y) = A(n-1-x, n-1-y)
+        //   bottom left  [0, half) x [half, n)    cell (x, y) = A(n-1-y, x)
+        // The top right comes from the transpose and is written first, as
+        // the bottom right reads top-left rows that share its words.
+        pool.parallel_for(upper, [&](size_t y, size_t) {
+            detail::copy_reversed(row(data_, y), upper, row(transposed, y), 0, half);
+        });
+        pool.parallel_for(n - half, [&](size_t i, size_t) {
+            size_t y = half + i;
+            detail::blit_bits(row(data_, y), 0, row(transposed, n - 1 - y), 0, half, copy);
+            if (y >= upper)
+                detail::copy_reversed(row(data_, y), half, row(data_, n - 1 - y), 0, upper);
+        });
+        return;
     }
+
+    // D8: the representative of (x, y) is A(min(fx, fy), max(fx, fy)) with
+    // fx = min(x, n-1-x) and fy = min(y, n-1-y). Each row first takes the
+    // transpose right of the diagonal and mirrors its left half; the
+    // bottom rows then copy the top ones.
+    std::vector<std::vector<uint64_t>> left(pool.size(), std::vector<uint64_t>(row_words_));
+    pool.parallel_for(n, [&](size_t y, size_t worker) {
+        uint64_t* r = row(data_, y);
+        if (y + 1 < n) detail::blit_bits(r, y + 1, row(transposed, y), y + 1, n - y - 1, copy);
+        std::copy(r, r + row_words_, left[worker].begin());
+        detail::copy_reversed(r, upper, left[worker].data(), 0, half);
+    });
+    pool.parallel_for(half, [&](size_t i, size_t) {
+        std::copy(row(data_, i), row(data_, i) + row_words_, row(data_, n - 1 - i));
+    });
 }
 
-Grid Grid::extract(size_t x, size_t y, size_t w, size_t h) const {
-    Grid result(w, h);
-    for (size_t ey = 0; ey < h; ++ey) {
-        for (size_t ex = 0; ex < w; ++ex) {
-            size_t sx = (x + ex) % width_;
-            size_t sy = (y + ey) % height_;
-            result.set_cell(ex, ey, get_cell(sx, sy));
+// Rows go in parallel a tile's worth at a time; each row notes whether it
+// changed, and the changed ones are stamped afterwards.
+template <class Op>
+void Grid::blit(const Grid& src, size_t sx, size_t sy, size_t w, size_t h, size_t dx, size_t dy,
+                Op op) {
+    if (w == 0 || h == 0) return;
+    std::vector<uint8_t> changed(h);
+    auto rows = [&](size_t block, size_t) {
+        size_t end = std::min(h, (block + 1) * kTileRows);
+        for (size_t r = block * kTileRows; r < end; ++r)
+            changed[r] = detail::blit_bits(&data_[(dy + r) * words_per_row_], dx,
+                                           &src.data_[(sy + r) * src.words_per_row_], sx, w, op);
+    };
+    const size_t blocks = (h + kTileRows - 1) / kTileRows;
+    if (blocks == 1)
+        rows(0, 0);
+    else
+        detail::ThreadPool::instance().parallel_for(blocks, rows);
+
+    const size_t tx_begin = dx / 64 / kTileWords;
+    const size_t tx_end = (dx + w - 1) / 64 / kTileWords;
+    uint64_t stamp = 0;
+    for (size_t r = 0; r < h; ++r) {
+        if (!changed[r]) continue;
+        if (!stamp) stamp = ++change_count_;
+        size_t y = dy + r;
+        row_stamp_[y] = stamp;
+        for (size_t tx = tx_begin; tx <= tx_end; ++tx) {
+            size_t tile = (y / kTileRows) * tiles_x_ + tx;
+            tile_changed_[tile] = 1;
+            tile_pop_[tile] = kPopStale;
+            tile_hash_[tile] = kHashStale;
+            tile_stamp_[tile] = stamp;
         }
     }
+}
+
+void Grid::paste(const Grid& pattern, size_t ox, size_t oy, BlitMode mode) {
+    if (&pattern == this) {
+        Grid copy(pattern);
+        paste(copy, ox, oy, mode);
+        return;
+    }
+    if (width_ == 0 || height_ == 0) return;
+    detail::wrap_runs(oy, pattern.height_, height_, [&](size_t py, size_t y, size_t h) {
+        detail::wrap_runs(ox, pattern.width_, width_, [&](size_t px, size_t x, size_t w) {
+            switch (mode) {
+            case BlitMode::kOr: blit(pattern, px, py, w, h, x, y, detail::OrBits()); break;
+            case BlitMode::kAnd: blit(pattern, px, py, w, h, x, y, detail::AndBits()); break;
+            case BlitMode::kXor: blit(pattern, px, py, w, h, x, y, detail::XorBits()); break;
+            case BlitMode::kCopy: blit(pattern, px, py, w, h, x, y, detail::CopyBits()); break;
+            }
+        });
+    });
+}
+
+Grid Grid::extract(size_t x, size_t y, size_t w, size_t h) const {
+    Grid result(w, h);
+    result.rule_ = rule_;
+    if (width_ == 0 || height_ == 0) return result;
+    detail::wrap_runs(y, h, height_, [&](size_t ry, size_t sy, size_t rh) {
+        detail::wrap_runs(x, w, width_, [&](size_t rx, size_t sx, size_t rw) {
+            result.blit(*this, sx, sy, rw, rh, rx, ry, detail::CopyBits());
+        });
+    });
     return result;
 }
 
 void Grid::to_flat_bool(uint8_t* out, size_t len) const {
-    size_t total = width_ * height_;
-    size_t n = std::min(len, total);
-    for (size_t i = 0; i < n; ++i) {
-        size_t x = i % width_;
-        size_t y = i / width_;
-        out[i] = get_cell(x, y) ? 1 : 0;
+    if (len >= width_ * height_) {
+        unpack(out, width_);
+        return;
     }
+    const detail::UnpackRowFn unpack_row = detail::active_kernel().unpack_row;
+    size_t rows = width_ ? len / width_ : 0;
+    for (size_t y = 0; y < rows; ++y)
+        unpack_row(&data_[y * words_per_row_], out + y * width_, width_);
+    for (size_t x = 0; x < len - rows * width_; ++x)
+        out[rows * width_ + x] = get_cell(x, rows) ? 1 : 0;
+}
+
+void Grid::unpack(uint8_t* out, size_t stride) const {
+    const detail::UnpackRowFn unpack_row = detail::active_kernel().unpack_row;
+    detail::ThreadPool::instance().parallel_for(tiles_y_, [&](size_t ty, size_t) {
+        size_t end = std::min(height_, (ty + 1) * kTileRows);
+        for (size_t y = ty * kTileRows; y < end; ++y)
+            unpack_row(&data_[y * words_per_row_], out + y * stride, width_);
+    });
+}
+
+void Grid::pack(const uint8_t* in, size_t stride) {
+    const detail::PackRowFn pack_row = detail::active_kernel().pack_row;
+    detail::ThreadPool::instance().parallel_for(tiles_y_, [&](size_t ty, size_t) {
+        size_t end = std::min(height_, (ty + 1) * kTileRows);
+        for (size_t y = ty * kTileRows; y < end; ++y)
+            pack_row(in + y * stride, &data_[y * words_per_row_], width_);
+    });
+    touch_all();
+}
+
+void Grid::count_tile(size_t tile) const {
+    size_t ty = tile / tiles_x_;
+    size_t tx = tile % tiles_x_;
+    size_t y_end = std::min(height_, (ty + 1) * kTileRows);
+    size_t w_end = std::min((tx + 1) * kTileWords, row_words_);
+    detail::CountSpanFn count_span = detail::active_kernel().count_span;
+    size_t count = 0;
+    for (size_t y = ty * kTileRows; y < y_end; ++y)
+        count += count_span(&data_[y * words_per_row_], tx * kTileWords, w_end);
+    tile_pop_[tile] = static_cast<uint32_t>(count);
 }
 
 size_t Grid::population() const {
+    // Bits past the width are always zero, so whole words can be counted.
     size_t count = 0;
-    for (size_t y = 0; y < height_; ++y) {
-        for (size_t w = 0; w < words_per_row_; ++w) {
-            uint64_t word = data_[y * words_per_row_ + w];
-            // Mask out bits beyond width in the last word of each row
-            if (w == words_per_row_ - 1 && (width_ % 64) != 0) {
-                word &= (uint64_t(1) << (width_ % 64)) - 1;
+    for (size_t tile = 0; tile < tile_pop_.size(); ++tile) {
+        if (tile_pop_[tile] == kPopStale)
+            count_tile(tile);
+        count += tile_pop_[tile];
+    }
+    return count;
+}
+
+uint64_t Grid::hash_tile(const Words& cells, size_t tile) const {
+    size_t ty = tile / tiles_x_;
+    size_t tx = tile % tiles_x_;
+    size_t y_end = std::min(height_, (ty + 1) * kTileRows);
+    size_t w_end = std::min((tx + 1) * kTileWords, row_words_);
+    uint64_t hash = 0;
+    for (size_t y = ty * kTileRows; y < y_end; ++y) {
+        for (size_t w = tx * kTileWords; w < w_end; ++w) {
+            uint64_t word = cells[y * words_per_row_ + w];
+            if (word) hash += detail::mix64(word ^ ((y * words_per_row_ + w) * kHashSalt));
+        }
+    }
+    return hash;
+}
+
+uint64_t Grid::state_hash() const {
+    uint64_t hash = 0;
+    for (size_t tile = 0; tile < tile_hash_.size(); ++tile) {
+        if (tile_hash_[tile] == kHashStale)
+            tile_hash_[tile] = hash_tile(data_, tile);
+        hash += tile_hash_[tile];
+    }
+    return hash;
+}
+
+// The first repeat of a state within the window marks the start of the
+// cycle: had it started earlier, the repeat would have come earlier too.
+Grid::Stability Grid::run_until_stable(size_t max_generations, size_t max_period) {
+    struct Seen {
+        size_t generation;
+        uint64_t hash;
+    };
+    std::vector<Seen> window(max_period + 1, Seen{0, 0});
+    std::vector<uint8_t> used(window.size(), 0);
+    std::unordered_map<uint64_t, size_t> latest;  // hash -> generation
+    auto remember = [&](uint64_t hash) {
+        size_t slot = generation_ % window.size();
+        if (used[slot]) {
+            auto it = latest.find(window[slot].hash);
+            if (it != latest.end() && it->second == window[slot].generation)
+                latest.erase(it);
+        }
+        window[slot] = Seen{generation_, hash};
+        used[slot] = 1;
+        latest[hash] = generation_;
+    };
+
+    Stability result;
+    const size_t last = generation_ + max_generations;
+    hash_in_step_ = true;
+    remember(state_hash());
+    while (generation_ < last) {
+        step();
+        uint64_t hash = state_hash();
+        auto it = latest.find(hash);
+        if (it != latest.end() && generation_ - it->second <= max_period) {
+            size_t period = generation_ - it->second;
+            size_t start = it->second;
+            Words snapshot = data_;
+            for (size_t i = 0; i < period; ++i)
+                step();
+            if (data_ == snapshot) {
+                result = Stability{true, period, start};
+                break;
             }
-            count += __builtin_popcountll(word);
+            hash = state_hash();  // a collision: keep going
+        }
+        remember(hash);
+    }
+    hash_in_step_ = false;
+    return result;
+}
+
+std::vector<Grid::Rect> Grid::changed_since(uint64_t count) const {
+    std::vector<Rect> rects;
+    for (size_t ty = 0; ty < tiles_y_; ++ty) {
+        size_t y0 = ty * kTileRows, y1 = std::min(height_, y0 + kTileRows);
+        while (y0 < y1 && !row_changed_since(y0, count)) ++y0;
+        while (y1 > y0 && !row_changed_since(y1 - 1, count)) --y1;
+        if (y0 == y1) continue;
+        for (size_t tx = 0; tx < tiles_x_;) {
+            if (!tile_changed_since(ty * tiles_x_ + tx, count)) { ++tx; continue; }
+            size_t run_end = tx;
+            while (run_end < tiles_x_ && tile_changed_since(ty * tiles_x_ + run_end, count))
+                ++run_end;
+            size_t x0 = tx * kTileWords * 64;
+            size_t x1 = std::min(width_, run_end * kTileWords * 64);
+            rects.push_back(Rect{x0, y0, x1 - x0, y1 - y0});
+            tx = run_end;
         }
     }
+    return rects;
+}
+
+size_t Grid::changed_tiles() const {
+    size_t count = 0;
+    for (uint8_t changed : tile_changed_)
+        count += changed;
     return count;
 }
 
+const char* Grid::kernel_name() {
+    return detail::active_kernel().name;
+}
+
+std::vector<std::string> Grid::available_kernels() {
+    const detail::StepKernel* kernels[8];
+    size_t n = detail::supported_kernels(kernels, 8);
+    std::vector<std::string> names;
+    for (size_t i = 0; i < n; ++i)
+        names.emplace_back(kernels[i]->name);
+    return names;
+}
+
+bool Grid::set_kernel(const std::string& name) {
+    return detail::select_kernel(name.c_str());
+}
+
+void Grid::set_num_threads(size_t threads) {
+    detail::ThreadPool::instance().resize(threads);
+}
+
+size_t Grid::num_threads() {
+    return detail::ThreadPool::instance().size();
+}
+
+void Grid::set_cpu_affinity(const std::vector<int>& cpus) {
+    detail::ThreadPool::instance().set_affinity(cpus);
+}
+
 } // namespace gol
@@ -0,0 +1,178 @@
+#include "gol/grid_batch.hpp"
+#include "gol/grid.hpp"
+#include "kernel.hpp"
+#include "random_words.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace gol {
+
+namespace {
+
+// Grids per parallel task: enough that both buffers of a task stay in the
+// L2 cache through all generations of a step_n().
+constexpr size_t kBlockBytes = size_t(128) << 10;
+
+} // namespace
+
+GridBatch::GridBatch(size_t count, size_t width, size_t height)
+    : count_(count), width_(width), height_(height),
+      row_words_((width + 63) / 64),
+      stride_((count + detail::kTileWords - 1) / detail::kTileWords * detail::kTileWords),
+      stable_(count, 0) {
+    size_t grid_bytes = std::max<size_t>(1, row_words_ * height_ * sizeof(uint64_t));
+    block_ = std::max(detail::kTileWords,
+                      kBlockBytes / grid_bytes / detail::kTileWords * detail::kTileWords);
+    data_.resize(row_words_ * height_ * stride_);
+    buffer_.resize(data_.size());
+    changed_.resize(stride_);
+    changed2_.resize(stride_);
+    std::fill(data_.begin(), data_.end(), 0);
+    std::fill(buffer_.begin(), buffer_.end(), 0);
+}
+
+void GridBatch::set_cell(size_t index, size_t x, size_t y, bool alive) {
+    if (index >= count_ || x >= width_ || y >= height_) return;
+    size_t idx = word_index(index, x, y);
+    uint64_t mask = uint64_t(1) << (x % 64);
+    // buffer_ gets the edit too, so the period-2 check in step() compares
+    // against a state the grid really had.
+    if (alive) {
+        data_[idx] |= mask;
+        buffer_[idx] |= mask;
+    } else {
+        data_[idx] &= ~mask;
+        buffer_[idx] &= ~mask;
+    }
+    stable_[index] = 0;
+}
+
+bool GridBatch::get_cell(size_t index, size_t x, size_t y) const {
+    if (index >= count_ || x >= width_ || y >= height_) return false;
+    return (data_[word_index(index, x, y)] >> (x % 64)) & 1;
+}
+
+// Both copy whole words, gathered from or scattered to the grid's lane.
+Grid GridBatch::grid(size_t index) const {
+    if (index >= count_)
+        throw std::out_of_range("GridBatch: grid index out of range");
+    Grid result(width_, height_);
+    result.set_rule(rule_);
+    uint64_t* out = result.mutable_data();
+    for (size_t y = 0; y < height_; ++y)
+        for (size_t j = 0; j < row_words_; ++j)
+            out[y * result.words_per_row() + j] = data_[(y * row_words_ + j) * stride_ + index];
+    result.touch();
+    return result;
+}
+
+void GridBatch::set_grid(size_t index, const Grid& grid) {
+    if (index >= count_)
+        throw std::out_of_range("GridBatch: grid index out of range");
+    const size_t words = std::min(row_words_, grid.words_per_row());
+    const uint64_t last_mask =
+        width_ % 64 ? (uint64_t(1) << (width_ % 64)) - 1 : ~uint64_t(0);
+    for (size_t y = 0; y < height_; ++y) {
+        const size_t have = y < grid.height() ? words : 0;
+        const uint64_t* row = grid.data() + std::min(y, grid.height()) * grid.words_per_row();
+        for (size_t j = 0; j < row_words_; ++j) {
+            uint64_t word = j < have ? row[j] : 0;
+            if (j + 1 == row_words_) word &= last_mask;
+            size_t idx = (y * row_words_ + j) * stride_ + index;
+            // buffer_ too, as in set_cell().
+            data_[idx] = word;
+            buffer_[idx] = word;
+        }
+    }
+    stable_[index] = 0;
+}
+
+void GridBatch::unpack(uint8_t* out) const {
+    const detail::UnpackRowFn unpack_row = detail::active_kernel().unpack_row;
+    detail::ThreadPool::instance().parallel_for(count_, [&](size_t i, size_t) {
+        std::vector<uint64_t> row(row_words_);
+        for (size_t y = 0; y < height_; ++y) {
+            for (size_t j = 0; j < row_words_; ++j)
+                row[j] = data_[(y * row_words_ + j) * stride_ + i];
+            unpack_row(row.data(), out + (i * height_ + y) * width_, width_);
+        }
+    });
+}
+
+void GridBatch::step() {
+    step_n(1);
+}
+
+// Each task runs all n generations on its own block of grids, ping-ponging
+// between the two buffers, so a block is read from memory once per call.
+void GridBatch::step_n(size_t n) {
+    if (n == 0) return;
+    const detail::RuleTable rule = detail::make_rule_table(rule_.birth, rule_.survive);
+    const detail::StepBatchFn step_batch = detail::active_kernel().step_batch[rule.kind];
+    const size_t blocks = (stride_ + block_ - 1) / block_;
+
+    if (row_words_ != 0 && height_ != 0) {
+        detail::ThreadPool::instance().parallel_for(blocks, [&](size_t b, size_t) {
+            size_t begin = b * block_;
+            size_t end = std::min(stride_, begin + block_);
+            for (size_t i = 0; i < n; ++i) {
+                // Only the last generation decides stable().
+                if (i + 1 == n) {
+                    std::fill(&changed_[begin], &changed_[begin] + (end - begin), 0);
+                    std::fill(&changed2_[begin], &changed2_[begin] + (end - begin), 0);
+                }
+                const Words& in = i % 2 ? buffer_ : data_;
+                Words& out = i % 2 ? data_ : buffer_;
+                step_batch(in.data(), out.data(), stride_, begin, end, width_, height_,
+                           changed_.data(), changed2_.data(), rule.masks);
+            }
+        });
+        if (n % 2) std::swap(data_, buffer_);
+        for (size_t g = 0; g < count_; ++g)
+            stable_[g] = changed_[g] == 0 || changed2_[g] == 0;
+    }
+    generation_ += n;
+}
+
+void GridBatch::clear() {
+    std::fill(data_.begin(), data_.end(), 0);
+    std::fill(buffer_.begin(), buffer_.end(), 0);
+    std::fill(stable_.begin(), stable_.end(), 0);
+    generation_ = 0;
+}
+
+void GridBatch::randomize(double density, const std::vector<uint64_t>& seeds) {
+    if (seeds.size() != count_)
+        throw std::invalid_argument("GridBatch: need one seed per grid");
+    // Blocks are whole cache lines of every row, so tasks never share one.
+    const size_t blocks = (stride_ + block_ - 1) / block_;
+    detail::ThreadPool::instance().parallel_for(blocks, [&](size_t b, size_t) {
+        size_t end = std::min(count_, (b + 1) * block_);
+        for (size_t g = b * block_; g < end; ++g) {
+            const detail::RandomWords random(density, seeds[g]);
+            for (size_t y = 0; y < height_; ++y) {
+                for (size_t j = 0; j < row_words_; ++j) {
+                    uint64_t word = random(y * row_words_ + j);
+                    if (width_ - j * 64 < 64) word &= (uint64_t(1) << (width_ - j * 64)) - 1;
+                    data_[(y * row_words_ + j) * stride_ + g] = word;
+                }
+            }
+        }
+    });
+    buffer_ = data_;
+    std::fill(stable_.begin(), stable_.end(), 0);
+    generation_ = 0;
+}
+
+std::vector<size_t> GridBatch::populations() const {
+    std::vector<size_t> counts(count_, 0);
+    for (size_t w = 0; w < row_words_ * height_; ++w) {
+        const uint64_t* words = &data_[w * stride_];
+        for (size_t g = 0; g < count_; ++g)
+            counts[g] += size_t(__builtin_popcountll(words[g]));
+    }
+    return counts;
+}
+
+} // namespace gol
@@ -0,0 +1,658 @@
+#include "gol/hashlife.hpp"
+#include "gol/grid.hpp"
+#include "gol/macrocell.hpp"
+#include "gol/rle.hpp"
+#include "gol/rule.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace gol {
+
+namespace {
+
+// Next state of the centre 2x2 of every 4x4 block; bit y * 4 + x of the
+// index is cell (x, y), bit (y - 1) * 2 + (x - 1) of the entry its future.
+const std::array<uint8_t, 1 << 16>& centre_table() {
+    static const std::array<uint8_t, 1 << 16> table = [] {
+        std::array<uint8_t, 1 << 16> t{};
+        for (unsigned block = 0; block < t.size(); ++block) {
+            uint8_t out = 0;
+            for (int cy = 1; cy <= 2; ++cy) {
+                for (int cx = 1; cx <= 2; ++cx) {
+                    int n = 0;
+                    for (int dy = -1; dy <= 1; ++dy)
+                        for (int dx = -1; dx <= 1; ++dx)
+                            if (dx || dy) n += (block >> ((cy + dy) * 4 + cx + dx)) & 1;
+                    bool alive = (block >> (cy * 4 + cx)) & 1;
+                    if (n == 3 || (alive && n == 2))
+                        out |= uint8_t(1) << ((cy - 1) * 2 + cx - 1);
+                }
+            }
+            t[block] = out;
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint64_t hash_children(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint64_t h = nw * 0x9E3779B97F4A7C15ull;
+    h ^= ne * 0xC2B2AE3D27D4EB4Full;
+    h ^= sw * 0x165667B19E3779F9ull;
+    h ^= se * 0x27D4EB2F165667C5ull;
+    return h ^ (h >> 29);
+}
+
+constexpr int64_t kCoordLimit = int64_t(1) << 61;
+
+// The tree only knows Life's transitions.
+void check_rule(const std::string& rule) {
+    if (!rule.empty() && Rule::parse(rule) != Rule())
+        throw std::invalid_argument("HashLife: only runs B3/S23, not '" + rule + "'");
+}
+
+} // namespace
+
+HashLife::HashLife(size_t memory_limit)
+    : buckets_(1024, kNone), memory_limit_(memory_limit) {
+    // Leaves: node 0 is a dead cell, node 1 a live one.
+    for (uint32_t alive = 0; alive < 2; ++alive) {
+        Node& leaf = at(allocate());
+        leaf = Node{kNone, kNone, kNone, kNone, kNone, kNone, kNone, 0, 0, 0, alive};
+    }
+    empty_.push_back(0);
+    root_ = empty(3);
+}
+
+HashLife::~HashLife() = default;
+
+uint32_t HashLife::allocate() {
+    ++live_;
+    if (free_ != kNone) {
+        uint32_t i = free_;
+        free_ = at(i).next;
+        return i;
+    }
+    if (used_ == chunks_.size() << kChunkBits) {
+        if (used_ >= kNone)
+            throw std::runtime_error("HashLife: node store is full");
+        chunks_.emplace_back(new Node[size_t(1) << kChunkBits]);
+    }
+    return uint32_t(used_++);
+}
+
+uint32_t HashLife::join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    size_t bucket = hash_children(nw, ne, sw, se) & (buckets_.size() - 1);
+    for (uint32_t i = buckets_[bucket]; i != kNone;) {
+        const Node& n = at(i);
+        if (n.nw == nw && n.ne == ne && n.sw == sw && n.se == se)
+            return i;
+        i = n.next;
+    }
+
+    uint32_t i = allocate();
+    Node& n = at(i);
+    n.nw = nw;
+    n.ne = ne;
+    n.sw = sw;
+    n.se = se;
+    n.result = kNone;
+    n.step_result = kNone;
+    n.level = uint8_t(at(nw).level + 1);
+    n.step_log2 = 0;
+    n.marked = 0;
+    n.population = at(nw).population + at(ne).population +
+                   at(sw).population + at(se).population;
+    n.next = buckets_[bucket];
+    buckets_[bucket] = i;
+    if (live_ > buckets_.size())
+        rehash(buckets_.size() * 2);
+    return i;
+}
+
+uint32_t HashLife::empty(unsigned level) {
+    while (empty_.size() <= level) {
+        uint32_t e = empty_.back();
+        empty_.push_back(join(e, e, e, e));
+    }
+    return empty_[level];
+}
+
+void HashLife::rehash(size_t buckets) {
+    buckets_.assign(buckets, kNone);
+    for (size_t i = 0; i < used_; ++i) {
+        Node& n = at(uint32_t(i));
+        if (n.level == kFree || n.level == 0) continue;
+        size_t bucket = hash_children(n.nw, n.ne, n.sw, n.se) & (buckets - 1);
+        n.next = buckets_[bucket];
+        buckets_[bucket] = uint32_t(i);
+    }
+}
+
+// ---- Memory ----
+
+uint32_t HashLife::memory_limit_nodes() const {
+    if (memory_limit_ == 0) return kNone;
+    size_t nodes = memory_limit_ / (sizeof(Node) + 2 * sizeof(uint32_t));
+    return uint32_t(std::min<size_t>(std::max<size_t>(nodes, 1024), kNone - 1));
+}
+
+size_t HashLife::memory_usage() const {
+    return chunks_.size() * (sizeof(Node) << kChunkBits) +
+           buckets_.size() * sizeof(uint32_t) +
+           stack_.capacity() * sizeof(uint32_t);
+}
+
+void HashLife::set_memory_limit(size_t bytes) {
+    memory_limit_ = bytes;
+}
+
+void HashLife::mark(uint32_t n) {
+    Node& node = at(n);
+    if (node.marked) return;
+    node.marked = 1;
+    if (node.level == 0) return;
+    mark(node.nw);
+    mark(node.ne);
+    mark(node.sw);
+    mark(node.se);
+}
+
+void HashLife::collect_garbage() {
+    // set() and result() name the leaves by index, so they always stay.
+    mark(0);
+    mark(1);
+    mark(root_);
+    for (uint32_t n : empty_) mark(n);
+    for (uint32_t n : stack_) mark(n);
+
+    for (size_t i = 0; i < used_; ++i) {
+        Node& n = at(uint32_t(i));
+        if (n.level == kFree || n.marked) continue;
+        n.level = kFree;
+        n.next = free_;
+        free_ = uint32_t(i);
+        --live_;
+    }
+    // Memoized results may point at freed nodes; forget those.
+    for (size_t i = 0; i < used_; ++i) {
+        Node& n = at(uint32_t(i));
+        if (n.level == kFree) continue;
+        if (n.result != kNone && !at(n.result).marked) n.result = kNone;
+        if (n.step_result != kNone && !at(n.step_result).marked) n.step_result = kNone;
+    }
+    for (size_t i = 0; i < used_; ++i)
+        at(uint32_t(i)).marked = 0;
+    rehash(buckets_.size());
+}
+
+// Called only where every node still in use is reachable from root_ or
+// stack_, so collecting is safe.
+void HashLife::maybe_collect() {
+    uint32_t limit = memory_limit_nodes();
+    if (live_ < limit) return;
+    collect_garbage();
+    if (live_ > limit - limit / 8)
+        throw std::runtime_error("HashLife: memory limit reached");
+}
+
+// ---- Geometry ----
+
+// Node n in the middle of an empty node of twice its side.
+uint32_t HashLife::grow(uint32_t n) {
+    Node node = at(n);
+    uint32_t e = empty(node.level - 1);
+    uint32_t nw = join(e, e, e, node.nw);
+    uint32_t ne = join(e, e, node.ne, e);
+    uint32_t sw = join(e, node.sw, e, e);
+    uint32_t se = join(node.se, e, e, e);
+    return join(nw, ne, sw, se);
+}
+
+// Doubles the root's side, keeping the pattern centred on the origin.
+void HashLife::expand() {
+    if (root_level() >= kMaxLevel)
+        throw std::overflow_error("HashLife: pattern outgrew 64-bit coordinates");
+    root_ = grow(root_);
+}
+
+bool HashLife::covers(int64_t x0, int64_t y0, int64_t x1, int64_t y1) const {
+    int64_t h = half();
+    return x0 >= -h && y0 >= -h && x1 <= h && y1 <= h;
+}
+
+// True if every live cell lies in the central quarter of the root, the
+// square of side 2^(level-2) around the origin.
+bool HashLife::centered() const {
+    const Node& root = at(root_);
+    uint64_t inner = at(at(at(root.nw).se).se).population + at(at(at(root.ne).sw).sw).population +
+                     at(at(at(root.sw).ne).ne).population + at(at(at(root.se).nw).nw).population;
+    return inner == root.population;
+}
+
+// ---- Stepping ----
+
+// The centre half of node n, 2^(level-2) generations on.
+uint32_t HashLife::result(uint32_t n) {
+    Node& node = at(n);
+    if (node.result != kNone) return node.result;
+    if (node.population == 0) return node.nw;
+
+    size_t base = stack_.size();
+    stack_.push_back(n);
+    maybe_collect();
+
+    uint32_t r;
+    if (node.level == 2) {
+        const uint32_t quads[4] = {node.nw, node.ne, node.sw, node.se};
+        unsigned block = 0;
+        for (int q = 0; q < 4; ++q) {
+            const Node& c = at(quads[q]);
+            int shift = (q / 2) * 8 + (q % 2) * 2;
+            block |= (c.nw | c.ne << 1 | c.sw << 4 | c.se << 5) << shift;
+        }
+        uint8_t out = centre_table()[block];
+        r = join(out & 1, (out >> 1) & 1, (out >> 2) & 1, (out >> 3) & 1);
+    } else {
+        r = combine(n, node.level - 2);
+    }
+    at(n).result = r;
+    stack_.resize(base);
+    return r;
+}
+
+// The centre half of node n, 2^log2_gens generations on, for
+// log2_gens <= level - 2.
+uint32_t HashLife::advance(uint32_t n, unsigned log2_gens) {
+    Node& node = at(n);
+    if (log2_gens + 2 == node.level) return result(n);
+    if (node.population == 0) return node.nw;
+    if (node.step_result != kNone && node.step_log2 == log2_gens) return node.step_result;
+
+    size_t base = stack_.size();
+    stack_.push_back(n);
+    maybe_collect();
+
+    uint32_t r = combine(n, log2_gens);
+    Node& done = at(n);
+    done.step_result = r;
+    done.step_log2 = uint8_t(log2_gens);
+    stack_.resize(base);
+    return r;
+}
+
+// Splits n into the nine overlapping squares of half its side, moves each
+// on (a full step) or just takes its centre (a partial step), then steps
+// the four squares those make up and joins their centres.
+uint32_t HashLife::combine(uint32_t n, unsigned log2_gens) {
+    const Node& node = at(n);
+    bool full = log2_gens + 2 == node.level;
+
+    uint32_t g[4][4];
+    const uint32_t quads[4] = {node.nw, node.ne, node.sw, node.se};
+    for (int q = 0; q < 4; ++q) {
+        const Node& c = at(quads[q]);
+        int r = (q / 2) * 2, col = (q % 2) * 2;
+        g[r][col] = c.nw;
+        g[r][col + 1] = c.ne;
+        g[r + 1][col] = c.sw;
+        g[r + 1][col + 1] = c.se;
+    }
+
+    uint32_t m[3][3];
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            if (full) {
+                m[r][c] = result(join(g[r][c], g[r][c + 1], g[r + 1][c], g[r + 1][c + 1]));
+            } else {
+                m[r][c] = join(at(g[r][c]).se, at(g[r][c + 1]).sw,
+                               at(g[r + 1][c]).ne, at(g[r + 1][c + 1]).nw);
+            }
+            stack_.push_back(m[r][c]);
+        }
+    }
+
+    uint32_t out[2][2];
+    for (int r = 0; r < 2; ++r) {
+        for (int c = 0; c < 2; ++c) {
+            uint32_t square = join(m[r][c], m[r][c + 1], m[r + 1][c], m[r + 1][c + 1]);
+            out[r][c] = full ? result(square) : advance(square, log2_gens);
+            stack_.push_back(out[r][c]);
+        }
+    }
+    return join(out[0][0], out[0][1], out[1][0], out[1][1]);
+}
+
+// Moves the whole pattern 2^log2_gens generations on. With the pattern in
+// the root's central quarter and log2_gens <= level - 3, nothing can
+// escape the half that advance() returns.
+void HashLife::advance_root(unsigned log2_gens) {
+    while (root_level() < log2_gens + 3 || !centered())
+        expand();
+    stack_.clear();
+    try {
+        root_ = advance(root_, log2_gens);
+    } catch (...) {
+        stack_.clear();
+        throw;
+    }
+    generation_ += uint64_t(1) << log2_gens;
+}
+
+void HashLife::step(uint64_t n) {
+    constexpr unsigned kMaxStep = kMaxLevel - 3;
+    for (unsigned bit = 0; n != 0; ++bit, n >>= 1) {
+        if (!(n & 1)) continue;
+        if (bit <= kMaxStep) {
+            advance_root(bit);
+        } else {
+            for (uint64_t i = 0; i < (uint64_t(1) << (bit - kMaxStep)); ++i)
+                advance_root(kMaxStep);
+        }
+    }
+}
+
+uint64_t HashLife::step_superspeed() {
+    while (root_level() < 3 || !centered())
+        expand();
+    unsigned log2_gens = root_level() - 3;
+    advance_root(log2_gens);
+    return uint64_t(1) << log2_gens;
+}
+
+// ---- Cells ----
+
+uint32_t HashLife::set(uint32_t n, uint64_t x, uint64_t y, bool alive) {
+    Node node = at(n);
+    if (node.level == 0) return alive ? 1 : 0;
+    uint64_t s = uint64_t(1) << (node.level - 1);
+    if (y < s) {
+        if (x < s) return join(set(node.nw, x, y, alive), node.ne, node.sw, node.se);
+        return join(node.nw, set(node.ne, x - s, y, alive), node.sw, node.se);
+    }
+    if (x < s) return join(node.nw, node.ne, set(node.sw, x, y - s, alive), node.se);
+    return join(node.nw, node.ne, node.sw, set(node.se, x - s, y - s, alive));
+}
+
+void HashLife::set_cell(int64_t x, int64_t y, bool alive) {
+    if (x < -kCoordLimit || x >= kCoordLimit || y < -kCoordLimit || y >= kCoordLimit)
+        throw std::out_of_range("HashLife: coordinate out of range");
+    while (!covers(x, y, x + 1, y + 1))
+        expand();
+    int64_t h = half();
+    root_ = set(root_, uint64_t(x + h), uint64_t(y + h), alive);
+}
+
+bool HashLife::get_cell(int64_t x, int64_t y) const {
+    if (x < -kCoordLimit || x >= kCoordLimit || y < -kCoordLimit || y >= kCoordLimit)
+        return false;
+    if (!covers(x, y, x + 1, y + 1)) return false;
+    int64_t h = half();
+    uint64_t ux = uint64_t(x + h), uy = uint64_t(y + h);
+    uint32_t n = root_;
+    while (at(n).level > 0) {
+        const Node& node = at(n);
+        if (node.population == 0) return false;
+        uint64_t s = uint64_t(1) << (node.level - 1);
+        if (uy < s) {
+            n = ux < s ? node.nw : node.ne;
+        } else {
+            n = ux < s ? node.sw : node.se;
+            uy -= s;
+        }
+        if (ux >= s) ux -= s;
+    }
+    return n == 1;
+}
+
+void HashLife::clear() {
+    root_ = empty(3);
+    generation_ = 0;
+}
+
+uint64_t HashLife::population() const {
+    return at(root_).population;
+}
+
+// Distance from one edge of the root to the nearest live cell, walking the
+// tree a level at a time and keeping only the distinct nodes that can hold
+// it. Sides are 0 west, 1 east, 2 north, 3 south.
+uint64_t HashLife::distance_to_live(int side) const {
+    std::vector<uint32_t> frontier{root_}, near, far;
+    uint64_t distance = 0;
+    for (unsigned level = root_level(); level > 0; --level) {
+        near.clear();
+        far.clear();
+        for (uint32_t i : frontier) {
+            const Node& n = at(i);
+            uint32_t a, b, c, d;  // a, b nearest the edge
+            switch (side) {
+            case 0: a = n.nw; b = n.sw; c = n.ne; d = n.se; break;
+            case 1: a = n.ne; b = n.se; c = n.nw; d = n.sw; break;
+            case 2: a = n.nw; b = n.ne; c = n.sw; d = n.se; break;
+            default: a = n.sw; b = n.se; c = n.nw; d = n.ne; break;
+            }
+            for (uint32_t child : {a, b})
+                if (at(child).population) near.push_back(child);
+            for (uint32_t child : {c, d})
+                if (at(child).population) far.push_back(child);
+        }
+        if (near.empty()) {
+            distance += uint64_t(1) << (level - 1);
+            frontier.swap(far);
+        } else {
+            frontier.swap(near);
+        }
+        std::sort(frontier.begin(), frontier.end());
+        frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+    }
+    return distance;
+}
+
+HashLife::Rect HashLife::bounding_box() const {
+    Rect box;
+    if (population() == 0) return box;
+    int64_t h = half();
+    box.x = -h + int64_t(distance_to_live(0));
+    box.y = -h + int64_t(distance_to_live(2));
+    box.width = uint64_t(h - int64_t(distance_to_live(1)) - box.x);
+    box.height = uint64_t(h - int64_t(distance_to_live(3)) - box.y);
+    return box;
+}
+
+// ---- Conversions ----
+
+uint32_t HashLife::merge(uint32_t a, uint32_t b) {
+    if (a == b || at(b).population == 0) return a;
+    if (at(a).population == 0) return b;
+    if (at(a).level == 0) return 1;
+    Node na = at(a), nb = at(b);
+    return join(merge(na.nw, nb.nw), merge(na.ne, nb.ne),
+                merge(na.sw, nb.sw), merge(na.se, nb.se));
+}
+
+// Node of the given level with top-left corner (x0, y0) holding the cells
+// of `grid` placed at (gx, gy).
+uint32_t HashLife::build(const Grid& grid, unsigned level, int64_t x0, int64_t y0,
+                         int64_t gx, int64_t gy) {
+    int64_t side = int64_t(1) << level;
+    if (x0 + side <= gx || y0 + side <= gy ||
+        x0 >= gx + int64_t(grid.width()) || y0 >= gy + int64_t(grid.height()))
+        return empty(level);
+    if (level == 0)
+        return grid.get_cell(size_t(x0 - gx), size_t(y0 - gy)) ? 1 : 0;
+    int64_t s = side / 2;
+    uint32_t nw = build(grid, level - 1, x0, y0, gx, gy);
+    uint32_t ne = build(grid, level - 1, x0 + s, y0, gx, gy);
+    uint32_t sw = build(grid, level - 1, x0, y0 + s, gx, gy);
+    uint32_t se = build(grid, level - 1, x0 + s, y0 + s, gx, gy);
+    return join(nw, ne, sw, se);
+}
+
+void HashLife::load(const Grid& grid, int64_t x, int64_t y) {
+    check_rule(grid.rule().to_string());
+    int64_t x1 = x + int64_t(grid.width()), y1 = y + int64_t(grid.height());
+    if (x < -kCoordLimit || y < -kCoordLimit || x1 > kCoordLimit || y1 > kCoordLimit)
+        throw std::out_of_range("HashLife: coordinate out of range");
+    while (!covers(x, y, x1, y1))
+        expand();
+    int64_t h = half();
+    root_ = merge(root_, build(grid, root_level(), -h, -h, x, y));
+}
+
+void HashLife::load(const RLEPattern& pattern, int64_t x, int64_t y) {
+    check_rule(pattern.rule);
+    for (auto& [cx, cy] : pattern.alive_cells)
+        set_cell(x + int64_t(cx), y + int64_t(cy), true);
+}
+
+// Node of the given level holding the square of an 8x8 leaf with top-left
+// corner (x0, y0).
+uint32_t HashLife::build_leaf(uint64_t cells, unsigned level, unsigned x0, unsigned y0) {
+    if (level == 0) return uint32_t(cells >> (y0 * 8 + x0)) & 1;
+    unsigned s = 1u << (level - 1);
+    uint32_t nw = build_leaf(cells, level - 1, x0, y0);
+    uint32_t ne = build_leaf(cells, level - 1, x0 + s, y0);
+    uint32_t sw = build_leaf(cells, level - 1, x0, y0 + s);
+    uint32_t se = build_leaf(cells, level - 1, x0 + s, y0 + s);
+    return join(nw, ne, sw, se);
+}
+
+void HashLife::load(const Macrocell& macrocell) {
+    check_rule(macrocell.rule);
+    if (macrocell.nodes.empty()) return;
+    if (macrocell.level() > kMaxLevel)
+        throw std::overflow_error("HashLife: pattern outgrew 64-bit coordinates");
+    std::vector<uint32_t> ids(macrocell.nodes.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        const Macrocell::Node& node = macrocell.nodes[i];
+        if (node.level == 3) {
+            ids[i] = build_leaf(node.cells, 3, 0, 0);
+            continue;
+        }
+        uint32_t c[4];
+        for (int q = 0; q < 4; ++q)
+            c[q] = node.children[q] ? ids[node.children[q] - 1] : empty(node.level - 1u);
+        ids[i] = join(c[0], c[1], c[2], c[3]);
+    }
+    uint32_t n = ids.back();
+    while (root_level() < at(n).level)
+        expand();
+    while (at(n).level < root_level())
+        n = grow(n);
+    root_ = merge(root_, n);
+}
+
+Macrocell HashLife::to_macrocell() const {
+    Macrocell macrocell;
+    macrocell.rule = "B3/S23";
+    macrocell.generation = generation_;
+
+    struct Walk {
+        const HashLife& life;
+        Macrocell& out;
+        std::unordered_map<uint32_t, uint32_t> written;  // node -> line
+
+        uint64_t cells(uint32_t n, unsigned x0, unsigned y0) const {
+            const Node& node = life.at(n);
+            if (node.population == 0) return 0;
+            if (node.level == 0) return uint64_t(1) << (y0 * 8 + x0);
+            unsigned s = 1u << (node.level - 1);
+            return cells(node.nw, x0, y0) | cells(node.ne, x0 + s, y0) |
+                   cells(node.sw, x0, y0 + s) | cells(node.se, x0 + s, y0 + s);
+        }
+        uint32_t operator()(uint32_t n) {
+            const Node& node = life.at(n);
+            if (node.population == 0) return 0;
+            auto found = written.find(n);
+            if (found != written.end()) return found->second;
+            Macrocell::Node line;
+            line.level = node.level;
+            if (node.level == 3) {
+                line.cells = cells(n, 0, 0);
+            } else {
+                const uint32_t quads[4] = {node.nw, node.ne, node.sw, node.se};
+                for (int q = 0; q < 4; ++q) line.children[q] = (*this)(quads[q]);
+            }
+            out.nodes.push_back(line);
+            return written[n] = uint32_t(out.nodes.size());
+        }
+    };
+    Walk{*this, macrocell, {}}(root_);
+    return macrocell;
+}
+
+Grid HashLife::to_grid(int64_t x, int64_t y, size_t width, size_t height) const {
+    Grid grid(width, height);
+    if (population() == 0 || width == 0 || height == 0) return grid;
+
+    struct Walk {
+        const HashLife& life;
+        Grid& grid;
+        int64_t x, y, x1, y1;
+        void operator()(uint32_t n, int64_t x0, int64_t y0) const {
+            const Node& node = life.at(n);
+            int64_t side = int64_t(1) << node.level;
+            if (node.population == 0 || x0 >= x1 || y0 >= y1 ||
+                x0 + side <= x || y0 + side <= y)
+                return;
+            if (node.level == 0) {
+                grid.set_cell(size_t(x0 - x), size_t(y0 - y), true);
+                return;
+            }
+            int64_t s = side / 2;
+            (*this)(node.nw, x0, y0);
+            (*this)(node.ne, x0 + s, y0);
+            (*this)(node.sw, x0, y0 + s);
+            (*this)(node.se, x0 + s, y0 + s);
+        }
+    };
+    int64_t h = half();
+    Walk{*this, grid, x, y, x + int64_t(width), y + int64_t(height)}(root_, -h, -h);
+    return grid;
+}
+
+Grid HashLife::to_grid() const {
+    Rect box = bounding_box();
+    return to_grid(box.x, box.y, std::max<size_t>(box.width, 1),
+                   std::max<size_t>(box.height, 1));
+}
+
+RLEPattern HashLife::to_pattern() const {
+    RLEPattern pattern;
+    Rect box = bounding_box();
+    pattern.width = box.width;
+    pattern.height = box.height;
+    if (population() == 0) return pattern;
+
+    struct Walk {
+        const HashLife& life;
+        RLEPattern& pattern;
+        int64_t x, y;
+        void operator()(uint32_t n, int64_t x0, int64_t y0) const {
+            const Node& node = life.at(n);
+            if (node.population == 0) return;
+            if (node.level == 0) {
+                pattern.alive_cells.emplace_back(size_t(x0 - x), size_t(y0 - y));
+                return;
+            }
+            int64_t s = int64_t(1) << (node.level - 1);
+            (*this)(node.nw, x0, y0);
+            (*this)(node.ne, x0 + s, y0);
+            (*this)(node.sw, x0, y0 + s);
+            (*this)(node.se, x0 + s, y0 + s);
+        }
+    };
+    int64_t h = half();
+    pattern.alive_cells.reserve(population());
+    Walk{*this, pattern, box.x, box.y}(root_, -h, -h);
+    std::sort(pattern.alive_cells.begin(), pattern.alive_cells.end(),
+              [](const auto& a, const auto& b) {
+                  return a.second != b.second ? a.second < b.second : a.first < b.first;
+              });
+    return pattern;
+}
+
+} // namespace gol
@@ -0,0 +1,87 @@
+#include "kernel_impl.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace gol {
+namespace detail {
+
+const StepKernel kScalarKernel = make_kernel<ScalarOps>("scalar");
+
+RuleTable make_rule_table(uint16_t birth, uint16_t survive) {
+    RuleTable table;
+    if (birth == 1u << 3 && survive == (1u << 2 | 1u << 3))
+        table.kind = kRuleLife;
+    else if (birth == (1u << 3 | 1u << 6) && survive == (1u << 2 | 1u << 3))
+        table.kind = kRuleHighLife;
+    else if (birth == 1u << 2 && survive == 0)
+        table.kind = kRuleSeeds;
+    else if (birth == (1u << 3 | 1u << 6 | 1u << 7 | 1u << 8) &&
+             survive == (1u << 3 | 1u << 4 | 1u << 6 | 1u << 7 | 1u << 8))
+        table.kind = kRuleDayNight;
+    else
+        table.kind = kRuleTable;
+    for (int n = 0; n < 9; ++n) {
+        table.masks[n] = (birth >> n & 1) ? ~uint64_t(0) : 0;
+        table.masks[9 + n] = (survive >> n & 1) ? ~uint64_t(0) : 0;
+    }
+    return table;
+}
+
+namespace {
+
+std::atomic<const StepKernel*> g_active{nullptr};
+
+const StepKernel* find_supported(const char* name) {
+    const StepKernel* kernels[4];
+    size_t n = supported_kernels(kernels, 4);
+    for (size_t i = 0; i < n; ++i) {
+        if (std::strcmp(kernels[i]->name, name) == 0)
+            return kernels[i];
+    }
+    return nullptr;
+}
+
+const StepKernel* detect_kernel() {
+    if (const char* forced = std::getenv("GOL_KERNEL")) {
+        if (const StepKernel* k = find_supported(forced))
+            return k;
+    }
+    const StepKernel* kernels[4];
+    size_t n = supported_kernels(kernels, 4);
+    return kernels[n - 1];
+}
+
+} // namespace
+
+size_t supported_kernels(const StepKernel** out, size_t max) {
+    size_t n = 0;
+    if (n < max) out[n++] = &kScalarKernel;
+#ifdef GOL_X86_KERNELS
+    __builtin_cpu_init();
+    if (n < max && __builtin_cpu_supports("sse2")) out[n++] = &kSse2Kernel;
+    if (n < max && __builtin_cpu_supports("avx2")) out[n++] = &kAvx2Kernel;
+    if (n < max && __builtin_cpu_supports("avx512f")) out[n++] = &kAvx512Kernel;
+#endif
+    return n;
+}
+
+const StepKernel& active_kernel() {
+    const StepKernel* k = g_active.load(std::memory_order_acquire);
+    if (!k) {
+        const StepKernel* detected = detect_kernel();
+        if (g_active.compare_exchange_strong(k, detected, std::memory_order_acq_rel))
+            k = detected;
+    }
+    return *k;
+}
+
+bool select_kernel(const char* name) {
+    const StepKernel* k = find_supported(name);
+    if (!k) return false;
+    g_active.store(k, std::memory_order_release);
+    return true;
+}
+
+} // namespace detail
+} // namespace gol
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gol {
+namespace detail {
+
+// Width of an activity tile in words; rows are padded to a multiple of it.
+constexpr size_t kTileWords = 8;
+
+// Rules with a kernel of their own; any other rule runs as kRuleTable.
+enum RuleKind : uint8_t {
+    kRuleLife,      // B3/S23
+    kRuleHighLife,  // B36/S23
+    kRuleSeeds,     // B2/S
+    kRuleDayNight,  // B3678/S34678
+    kRuleTable,
+    kRuleKinds
+};
+
+// A rule as the kernels take it. masks[n] is all ones iff a dead cell with
+// n live neighbors is born, masks[9 + n] iff a live one survives; only the
+// kRuleTable kernels read them.
+struct RuleTable {
+    RuleKind kind;
+    uint64_t masks[18];
+};
+
+// birth and survive have bit n set for each neighbor count n in the rule.
+RuleTable make_rule_table(uint16_t birth, uint16_t survive);
+
+// Computes the next generation of words [begin, end) of one row. `up`, `mid`
+// and `down` point at the start of the rows above, at and below the output
+// row (already torus-wrapped), `nwords` is the number of live words in a row
+// and `width` the row width in cells. `begin` is a multiple of kTileWords;
+// tile_diff[i] is OR-ed with a value that is nonzero iff some cell of the
+// i-th tile of the span changed. Words past the live cells are written as zero.
+// `masks` is RuleTable::masks.
+using StepRowFn = void (*)(const uint64_t* up, const uint64_t* mid,
+                           const uint64_t* down, uint64_t* out,
+                           size_t begin, size_t end,
+                           size_t nwords, size_t width, uint64_t* tile_diff,
+                           const uint64_t* masks);
+
+// Live cells in words [begin, end) of a row.
+using CountSpanFn = size_t (*)(const uint64_t* row, size_t begin, size_t end);
+
+// The first `width` cells of a row as one byte each, 1 if alive.
+using UnpackRowFn = void (*)(const uint64_t* row, uint8_t* out, size_t width);
+// `width` bytes, nonzero meaning alive, into the first (width + 63) / 64
+// words of a row; bits past the width are written as zero.
+using PackRowFn = void (*)(const uint8_t* in, uint64_t* row, size_t width);
+
+// Computes a column of `rows` words (one per row, rows a multiple of
+// kTileWords) into 64-byte aligned `out`. `west`, `mid` and `east` hold
+// rows + 2 words each, from the row above the column to the row below it.
+// Returns nonzero iff some output cell is alive.
+using StepColumnFn = uint64_t (*)(const uint64_t* west, const uint64_t* mid,
+                                  const uint64_t* east, uint64_t* out, size_t rows,
+                                  const uint64_t* masks);
+
+// Steps grids [begin, end) of a batch of `count` interleaved width x height
+// tori: word j of row y of grid g is in[(y * row_words + j) * count + g].
+// count, begin and end are multiples of kTileWords and both buffers 64-byte
+// aligned. changed[g] and changed2[g] are OR-ed with values that are nonzero
+// iff grid g's new generation differs from `in` and from what `out` held.
+using StepBatchFn = void (*)(const uint64_t* in, uint64_t* out, size_t count,
+                             size_t begin, size_t end, size_t width, size_t height,
+                             uint64_t* changed, uint64_t* changed2, const uint64_t* masks);
+
+// One instruction set; the stepping entries are indexed by RuleKind.
+struct StepKernel {
+    const char* name;
+    StepRowFn step_row[kRuleKinds];
+    CountSpanFn count_span;
+    UnpackRowFn unpack_row;
+    PackRowFn pack_row;
+    StepColumnFn step_column[kRuleKinds];
+    StepBatchFn step_batch[kRuleKinds];
+};
+
+extern const StepKernel kScalarKernel;
+#ifdef GOL_X86_KERNELS
+extern const StepKernel kSse2Kernel;
+extern const StepKernel kAvx2Kernel;
+extern const StepKernel kAvx512Kernel;
+#endif
+
+// Kernel chosen from CPUID on first use. GOL_KERNEL=<name> in the
+// environment overrides the choice if the CPU supports that kernel.
+const StepKernel& active_kernel();
+
+// Kernels the running CPU can execute, narrowest first.
+size_t supported_kernels(const StepKernel** out, size_t max);
+
+bool select_kernel(const char* name);
+
+} // namespace detail
+} // namespace gol
@@ -0,0 +1,51 @@
+#include "kernel_impl.hpp"
+#include <immintrin.h>
+
+namespace gol {
+namespace detail {
+
+namespace {
+
+struct Avx2Ops : Avx2Bytes {
+    using V = __m256i;
+    static constexpr size_t lanes = 4;
+
+    static V load(const uint64_t* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+    static V loadu(const uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(uint64_t* p, V v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+    static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+    static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+    static V xor_(V a, V b) { return _mm256_xor_si256(a, b); }
+    static V andnot(V a, V b) { return _mm256_andnot_si256(a, b); }
+    static V shl(V a, int n) { return _mm256_slli_epi64(a, n); }
+    static V shr(V a, int n) { return _mm256_srli_epi64(a, n); }
+    static V xor3(V a, V b, V c) { return xor_(xor_(a, b), c); }
+    static V maj(V a, V b, V c) { return or_(and_(a, b), and_(xor_(a, b), c)); }
+    static V zero() { return _mm256_setzero_si256(); }
+    static uint64_t any(V a) { return !_mm256_testz_si256(a, a); }
+    // alignr only shifts within 128-bit halves, so first line up the halves
+    // that straddle the chunk boundary.
+    static V west(V prev, V cur) {
+        return _mm256_alignr_epi8(cur, _mm256_permute2x128_si256(prev, cur, 0x21), 8);
+    }
+    static V east(V cur, V next) {
+        return _mm256_alignr_epi8(_mm256_permute2x128_si256(cur, next, 0x21), cur, 8);
+    }
+    static V lane(size_t i, uint64_t v) {
+        V hit = _mm256_cmpeq_epi64(_mm256_setr_epi64x(0, 1, 2, 3),
+                                   _mm256_set1_epi64x(static_cast<long long>(i)));
+        return _mm256_and_si256(hit, _mm256_set1_epi64x(static_cast<long long>(v)));
+    }
+    static V set1(uint64_t v) { return _mm256_set1_epi64x(static_cast<long long>(v)); }
+    static V head_mask(size_t n) {
+        return _mm256_cmpgt_epi64(_mm256_set1_epi64x(static_cast<long long>(n)),
+                                  _mm256_setr_epi64x(0, 1, 2, 3));
+    }
+};
+
+} // namespace
+
+const StepKernel kAvx2Kernel = make_kernel<Avx2Ops>("avx2");
+
+} // namespace detail
+} // namespace gol
@@ -0,0 +1,46 @@
+#include "kernel_impl.hpp"
+#include <immintrin.h>
+
+namespace gol {
+namespace detail {
+
+namespace {
+
+struct Avx512Ops : Avx2Bytes {
+    using V = __m512i;
+    static constexpr size_t lanes = 8;
+
+    static V load(const uint64_t* p) { return _mm512_load_si512(p); }
+    static V loadu(const uint64_t* p) { return _mm512_loadu_si512(p); }
+    static void store(uint64_t* p, V v) { _mm512_store_si512(p, v); }
+    static V and_(V a, V b) { return _mm512_and_si512(a, b); }
+    static V or_(V a, V b) { return _mm512_or_si512(a, b); }
+    static V xor_(V a, V b) { return _mm512_xor_si512(a, b); }
+    // GCC 12's unmasked forms of andnot, the shifts and alignr pass an
+    // uninitialized vector as the merge source, which trips
+    // -Wmaybe-uninitialized wherever they inline. Vector operators and the
+    // merge-masked alignr compile to the same instructions.
+    static V andnot(V a, V b) { return V(~__v8du(a) & __v8du(b)); }
+    static V shl(V a, int n) { return V(__v8du(a) << n); }
+    static V shr(V a, int n) { return V(__v8du(a) >> n); }
+    // Three-input logic in one instruction: 0x96 is a^b^c, 0xE8 majority.
+    static V xor3(V a, V b, V c) { return _mm512_ternarylogic_epi64(a, b, c, 0x96); }
+    static V maj(V a, V b, V c) { return _mm512_ternarylogic_epi64(a, b, c, 0xE8); }
+    static V zero() { return _mm512_setzero_si512(); }
+    static uint64_t any(V a) { return _mm512_test_epi64_mask(a, a); }
+    static V west(V prev, V cur) { return _mm512_mask_alignr_epi64(cur, 0xFF, cur, prev, 7); }
+    static V east(V cur, V next) { return _mm512_mask_alignr_epi64(cur, 0xFF, next, cur, 1); }
+    static V lane(size_t i, uint64_t v) {
+        return i < lanes ? _mm512_maskz_set1_epi64(__mmask8(1u << i), static_cast<long long>(v))
+                         : zero();
+    }
+    static V set1(uint64_t v) { return _mm512_set1_epi64(static_cast<long long>(v)); }
+    static V head_mask(size_t n) { return _mm512_maskz_set1_epi64(__mmask8((1u << n) - 1), -1); }
+};
+
+} // namespace
+
+const StepKernel kAvx512Kernel = make_kernel<Avx512Ops>("avx512");
+
+} // namespace detail
+} // namespace gol
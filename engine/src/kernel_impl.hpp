@@ -0,0 +1,522 @@
+#pragma once
+
+// Shared body of the step kernels. Each kernel_*.cpp includes this file and
+// is compiled for its own instruction set, so everything here has internal
+// linkage: the linker must never merge an AVX-512 copy of a helper into the
+// baseline build. For the same reason this header pulls in no standard
+// library templates.
+
+#include "kernel.hpp"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace gol {
+namespace detail {
+namespace {
+
+// One byte per cell and back, eight cells per multiply: pack8 gathers the
+// nonzero-ness of each byte into a bit, unpack8 spreads eight bits into
+// 0/1 bytes.
+inline uint64_t pack8(uint64_t bytes) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t nonzero = (((bytes & low7) + low7) | bytes) >> 7 & 0x0101010101010101ULL;
+    return nonzero * 0x0102040810204080ULL >> 56;
+}
+
+inline uint64_t unpack8(uint64_t bits) {
+    uint64_t spread = (bits & 0xFF) * 0x0101010101010101ULL & 0x8040201008040201ULL;
+    return (spread + 0x7F7F7F7F7F7F7F7FULL) >> 7 & 0x0101010101010101ULL;
+}
+
+// Plain 64-bit words. Besides loads (aligned and not) and bitwise ops, every
+// Ops type provides
+//   west(prev, cur) / east(cur, next): the chunk shifted by one word, pulling
+//       in the last word of `prev` or the first word of `next`;
+//   lane(i, v): `v` in lane i and zero elsewhere (all zero if i >= lanes);
+//   head_mask(n): all ones in the first n lanes;
+//   set1(v): `v` in every lane;
+//   any(v): nonzero iff some bit of v is set;
+//   pack64(in) / unpack64(word, out): one word to 64 cell bytes and back.
+struct ScalarOps {
+    using V = uint64_t;
+    static constexpr size_t lanes = 1;
+
+    static V load(const uint64_t* p) { return *p; }
+    static V loadu(const uint64_t* p) { return *p; }
+    static void store(uint64_t* p, V v) { *p = v; }
+    static V and_(V a, V b) { return a & b; }
+    static V or_(V a, V b) { return a | b; }
+    static V xor_(V a, V b) { return a ^ b; }
+    static V andnot(V a, V b) { return ~a & b; }
+    static V shl(V a, int n) { return a << n; }
+    static V shr(V a, int n) { return a >> n; }
+    static V xor3(V a, V b, V c) { return a ^ b ^ c; }
+    static V maj(V a, V b, V c) { return (a & b) | ((a ^ b) & c); }
+    static V zero() { return 0; }
+    static uint64_t any(V a) { return a; }
+    static V west(V prev, V) { return prev; }
+    static V east(V, V next) { return next; }
+    static V lane(size_t i, uint64_t v) { return i == 0 ? v : 0; }
+    static V head_mask(size_t n) { return n > 0 ? ~uint64_t(0) : 0; }
+    static V set1(uint64_t v) { return v; }
+    static uint64_t pack64(const uint8_t* in) {
+        uint64_t word = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t bytes;
+            __builtin_memcpy(&bytes, in + 8 * i, 8);
+            word |= pack8(bytes) << (8 * i);
+        }
+        return word;
+    }
+    static void unpack64(uint64_t word, uint8_t* out) {
+        for (int i = 0; i < 8; ++i) {
+            uint64_t bytes = unpack8(word >> (8 * i));
+            __builtin_memcpy(out + 8 * i, &bytes, 8);
+        }
+    }
+};
+
+#ifdef __AVX2__
+// pack64 / unpack64 on 32 bytes at a time, shared by the AVX2 and AVX-512
+// kernels (the latter is built without the byte instructions of AVX-512BW).
+struct Avx2Bytes {
+    static uint64_t pack64(const uint8_t* in) {
+        const __m256i zero = _mm256_setzero_si256();
+        uint64_t word = 0;
+        for (int i = 0; i < 2; ++i) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 32 * i));
+            uint32_t dead = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+            word |= uint64_t(~dead) << (32 * i);
+        }
+        return word;
+    }
+    static void unpack64(uint64_t word, uint8_t* out) {
+        // Byte k of each 32-bit half fills output bytes 8k..8k+7, which then
+        // keep bit j of it in byte j.
+        const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                                2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+        const __m256i bit = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+        const __m256i one = _mm256_set1_epi8(1);
+        for (int i = 0; i < 2; ++i) {
+            __m256i v = _mm256_set1_epi32(static_cast<int>(word >> (32 * i)));
+            v = _mm256_and_si256(_mm256_shuffle_epi8(v, spread), bit);
+            v = _mm256_and_si256(_mm256_cmpeq_epi8(v, bit), one);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32 * i), v);
+        }
+    }
+};
+#endif
+
+// Hardware popcount where the translation unit is built with it, otherwise
+// the SWAR fallback (the libgcc call is far slower).
+inline uint32_t popcount64(uint64_t v) {
+#ifdef __POPCNT__
+    return static_cast<uint32_t>(__builtin_popcountll(v));
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<uint32_t>((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline size_t count_span_impl(const uint64_t* row, size_t begin, size_t end) {
+    size_t count = 0;
+    for (size_t w = begin; w < end; ++w)
+        count += popcount64(row[w]);
+    return count;
+}
+
+// The eight neighbor planes around each cell summed with full adders into
+// n = s0 + 2*s1 + 4*(t1 ^ c2) + 8*(t1 & c2). Rules read the planes they need
+// and leave the rest to dead-code elimination.
+template <class Ops>
+struct NeighborSum {
+    using V = typename Ops::V;
+    V s0, s1, t1, c2;
+
+    V high() const { return Ops::or_(t1, c2); }  // n >= 4
+    V s2() const { return Ops::xor_(t1, c2); }
+    V s3() const { return Ops::and_(t1, c2); }   // n == 8
+};
+
+template <class Ops>
+inline NeighborSum<Ops> neighbor_sum(typename Ops::V uw, typename Ops::V u, typename Ops::V ue,
+                                     typename Ops::V mw, typename Ops::V me,
+                                     typename Ops::V dw, typename Ops::V d, typename Ops::V de) {
+    using V = typename Ops::V;
+    V up_s = Ops::xor3(uw, u, ue);
+    V up_c = Ops::maj(uw, u, ue);
+    V dn_s = Ops::xor3(dw, d, de);
+    V dn_c = Ops::maj(dw, d, de);
+    V mid_s = Ops::xor_(mw, me);
+    V mid_c = Ops::and_(mw, me);
+
+    V k1 = Ops::maj(up_s, mid_s, dn_s);
+    V t0 = Ops::xor3(up_c, mid_c, dn_c);
+    NeighborSum<Ops> n;
+    n.s0 = Ops::xor3(up_s, mid_s, dn_s);
+    n.s1 = Ops::xor_(t0, k1);
+    n.t1 = Ops::maj(up_c, mid_c, dn_c);
+    n.c2 = Ops::and_(t0, k1);
+    return n;
+}
+
+// Rules map the neighbor sum and the current cell to the next cell. Every
+// rule is constructed from the 18-word table of RuleTable; only TableRule
+// reads it.
+
+// B3/S23: n == 3, or n == 2 and alive.
+template <class Ops>
+struct LifeRule {
+    using V = typename Ops::V;
+    explicit LifeRule(const uint64_t*) {}
+    V next(const NeighborSum<Ops>& n, V m) const {
+        return Ops::andnot(n.high(), Ops::and_(n.s1, Ops::or_(n.s0, m)));
+    }
+};
+
+// B36/S23: Life plus births on n == 6.
+template <class Ops>
+struct HighLifeRule {
+    using V = typename Ops::V;
+    explicit HighLifeRule(const uint64_t*) {}
+    V next(const NeighborSum<Ops>& n, V m) const {
+        V life = Ops::andnot(n.high(), Ops::and_(n.s1, Ops::or_(n.s0, m)));
+        V six = Ops::andnot(n.s0, Ops::and_(n.s1, n.s2()));
+        return Ops::or_(life, Ops::andnot(m, six));
+    }
+};
+
+// B2/S: dead cells with n == 2 are born, every live cell dies.
+template <class Ops>
+struct SeedsRule {
+    using V = typename Ops::V;
+    explicit SeedsRule(const uint64_t*) {}
+    V next(const NeighborSum<Ops>& n, V m) const {
+        return Ops::andnot(m, Ops::andnot(Ops::or_(n.s0, n.high()), n.s1));
+    }
+};
+
+// B3678/S34678 (Day & Night): n in {3, 6, 7, 8}, or n == 4 and alive.
+template <class Ops>
+struct DayNightRule {
+    using V = typename Ops::V;
+    explicit DayNightRule(const uint64_t*) {}
+    V next(const NeighborSum<Ops>& n, V m) const {
+        V s2 = n.s2();
+        V six_up = Ops::or_(Ops::and_(s2, n.s1), n.s3());
+        V three = Ops::andnot(n.high(), Ops::and_(n.s1, n.s0));
+        V four = Ops::andnot(Ops::or_(n.s0, n.s1), s2);
+        return Ops::or_(Ops::or_(six_up, three), Ops::and_(m, four));
+    }
+};
+
+// Any other rule: n is decoded into nine one-hot planes, each selecting the
+// birth or survival mask for its count.
+template <class Ops>
+struct TableRule {
+    using V = typename Ops::V;
+    V birth[9], survive[9];
+
+    explicit TableRule(const uint64_t* table) {
+        for (int i = 0; i < 9; ++i) {
+            birth[i] = Ops::set1(table[i]);
+            survive[i] = Ops::set1(table[9 + i]);
+        }
+    }
+    V next(const NeighborSum<Ops>& n, V m) const {
+        V s2 = n.s2();
+        V s3 = n.s3();
+        V ones = Ops::set1(~uint64_t(0));
+        V low[4] = {Ops::andnot(Ops::or_(n.s0, n.s1), ones), Ops::andnot(n.s1, n.s0),
+                    Ops::andnot(n.s0, n.s1), Ops::and_(n.s0, n.s1)};
+        V top[3] = {Ops::andnot(Ops::or_(s2, s3), ones), s2, s3};  // n < 4, 4..7, 8
+        V result = Ops::zero();
+        for (int i = 0; i < 9; ++i) {
+            V eq = Ops::and_(low[i & 3], top[i >> 2]);
+            V sel = Ops::or_(Ops::and_(m, survive[i]), Ops::andnot(m, birth[i]));
+            result = Ops::or_(result, Ops::and_(eq, sel));
+        }
+        return result;
+    }
+};
+
+// One output chunk from the current chunk of each input row (u, m, d) and
+// the same rows shifted one word west and east (their sources, that is: the
+// word whose bit 63 / bit 0 feeds each lane's west / east neighbor).
+template <class Ops, class Rule>
+inline typename Ops::V step_chunk(const Rule& rule,
+                                  typename Ops::V u, typename Ops::V u_west, typename Ops::V u_east,
+                                  typename Ops::V m, typename Ops::V m_west, typename Ops::V m_east,
+                                  typename Ops::V d, typename Ops::V d_west, typename Ops::V d_east) {
+    using V = typename Ops::V;
+    V uw = Ops::or_(Ops::shl(u, 1), Ops::shr(u_west, 63));
+    V ue = Ops::or_(Ops::shr(u, 1), Ops::shl(u_east, 63));
+    V mw = Ops::or_(Ops::shl(m, 1), Ops::shr(m_west, 63));
+    V me = Ops::or_(Ops::shr(m, 1), Ops::shl(m_east, 63));
+    V dw = Ops::or_(Ops::shl(d, 1), Ops::shr(d_west, 63));
+    V de = Ops::or_(Ops::shr(d, 1), Ops::shl(d_east, 63));
+    return rule.next(neighbor_sum<Ops>(uw, u, ue, mw, me, dw, d, de), m);
+}
+
+// Chunks [w_begin, w_end) away from the row ends: the west/east sources are
+// unaligned loads one word either side, which stay inside the row. Change
+// flags go to tile_diff, indexed from `begin`.
+template <class Ops, class Rule>
+inline void step_interior(const Rule& rule, const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                          uint64_t* out, size_t w_begin, size_t w_end,
+                          size_t begin, uint64_t* tile_diff) {
+    using V = typename Ops::V;
+    constexpr size_t L = Ops::lanes;
+    V changed = Ops::zero();
+    for (size_t w = w_begin; w < w_end; w += L) {
+        V m = Ops::load(mid + w);
+        V result = step_chunk<Ops>(
+            rule, Ops::load(up + w), Ops::loadu(up + w - 1), Ops::loadu(up + w + 1),
+            m, Ops::loadu(mid + w - 1), Ops::loadu(mid + w + 1),
+            Ops::load(down + w), Ops::loadu(down + w - 1), Ops::loadu(down + w + 1));
+        Ops::store(out + w, result);
+        changed = Ops::or_(changed, Ops::xor_(result, m));
+        if ((w + L) % kTileWords == 0 || w + L >= w_end) {
+            tile_diff[(w - begin) / kTileWords] |= Ops::any(changed);
+            changed = Ops::zero();
+        }
+    }
+}
+
+// A row chunk at either end of the row, with its west and east sources
+// patched for the torus wrap: before word 0 sits the last live cell (in bit
+// 63 of the previous lane), and the cell at column 0 is injected just past
+// the last live column (bit `width` of the row), where the east shift picks
+// it up. Cells past `width` come out as garbage and are masked on store.
+template <class Ops>
+struct EdgeRow {
+    using V = typename Ops::V;
+    V c, west, east;
+
+    EdgeRow(const uint64_t* row, size_t w, size_t last_chunk, size_t nwords, size_t width) {
+        constexpr size_t L = Ops::lanes;
+        c = Ops::load(row + w);
+        V next = Ops::zero();
+        if (w == last_chunk) {
+            size_t lane = width / 64 - last_chunk;  // 0..L
+            uint64_t bit = (row[0] & 1) << (width % 64);
+            c = Ops::or_(c, Ops::lane(lane, bit));
+            next = Ops::lane(lane - L, bit);
+        }
+        if (w == 0) {
+            uint64_t last_cell = (row[nwords - 1] >> ((width - 1) % 64)) & 1;
+            west = Ops::west(Ops::lane(L - 1, last_cell << 63), c);
+        } else {
+            west = Ops::loadu(row + w - 1);
+        }
+        east = w == last_chunk ? Ops::east(c, next) : Ops::loadu(row + w + 1);
+    }
+};
+
+template <class Ops, class Rule>
+inline uint64_t step_edge_chunk(const Rule& rule, const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                                uint64_t* out, size_t w, size_t last_chunk,
+                                size_t nwords, size_t width) {
+    using V = typename Ops::V;
+    EdgeRow<Ops> u(up, w, last_chunk, nwords, width);
+    EdgeRow<Ops> m(mid, w, last_chunk, nwords, width);
+    EdgeRow<Ops> d(down, w, last_chunk, nwords, width);
+    V result = step_chunk<Ops>(rule, u.c, u.west, u.east, m.c, m.west, m.east, d.c, d.west, d.east);
+    if (w == last_chunk) {
+        size_t live = nwords - last_chunk;
+        uint64_t last_mask = ~uint64_t(0) >> (63 - (width - 1) % 64);
+        result = Ops::and_(result, Ops::or_(Ops::head_mask(live - 1),
+                                            Ops::lane(live - 1, last_mask)));
+    }
+    Ops::store(out + w, result);
+    return Ops::any(Ops::xor_(result, Ops::load(mid + w)));
+}
+
+// Steps words [begin, end) of a row in aligned chunks of `Ops::lanes` words:
+// the chunks at the row ends through step_edge_chunk, the rest through
+// step_interior.
+template <class Ops, class Rule>
+inline void step_row_impl(const Rule& rule,
+                          const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                          uint64_t* out, size_t begin, size_t end,
+                          size_t nwords, size_t width, uint64_t* tile_diff) {
+    constexpr size_t L = Ops::lanes;
+    static_assert(kTileWords % L == 0, "tiles must hold whole chunks");
+    if (begin >= end) return;
+
+    size_t last_chunk = (nwords - 1) / L * L;
+    size_t w = begin;
+    if (w == 0 && last_chunk != 0) {
+        tile_diff[0] |= step_edge_chunk<Ops>(rule, up, mid, down, out, 0, last_chunk, nwords, width);
+        w = L;
+    }
+    size_t interior_end = end > last_chunk ? last_chunk : end;
+    if (w < interior_end)
+        step_interior<Ops>(rule, up, mid, down, out, w, interior_end, begin, tile_diff);
+    if (end > last_chunk) {
+        tile_diff[(last_chunk - begin) / kTileWords] |=
+            step_edge_chunk<Ops>(rule, up, mid, down, out, last_chunk, last_chunk, nwords, width);
+    }
+}
+
+// A column of `rows` words, `rows` a multiple of kTileWords, from three
+// columns of rows + 2 words each (the row above, the rows, the row below):
+// the column itself and its west and east neighbours. Lanes run down the
+// column, so no shuffles are needed. Returns nonzero iff a cell is alive.
+template <class Ops, class Rule>
+inline uint64_t step_column_impl(const Rule& rule, const uint64_t* west, const uint64_t* mid,
+                                 const uint64_t* east, uint64_t* out, size_t rows) {
+    using V = typename Ops::V;
+    V alive = Ops::zero();
+    for (size_t r = 0; r < rows; r += Ops::lanes) {
+        V result = step_chunk<Ops>(
+            rule, Ops::loadu(mid + r), Ops::loadu(west + r), Ops::loadu(east + r),
+            Ops::loadu(mid + r + 1), Ops::loadu(west + r + 1), Ops::loadu(east + r + 1),
+            Ops::loadu(mid + r + 2), Ops::loadu(west + r + 2), Ops::loadu(east + r + 2));
+        Ops::store(out + r, result);
+        alive = Ops::or_(alive, result);
+    }
+    return Ops::any(alive);
+}
+
+// One word of a row in an interleaved batch (see StepBatchFn), for `Ops::lanes`
+// grids at once, with its west and east sources wrapped around the torus
+// like EdgeRow does: the last word's west source is shifted so its top bit
+// is the last cell, and cell 0 is injected just past the last cell.
+template <class Ops>
+struct BatchRow {
+    using V = typename Ops::V;
+    V c, west, east;
+
+    BatchRow(const uint64_t* row, size_t count, size_t j, size_t last, unsigned tail) {
+        c = Ops::load(row + j * count);
+        if (j == last && tail)
+            c = Ops::or_(c, Ops::shl(Ops::and_(Ops::load(row), Ops::set1(1)), int(tail)));
+        if (j > 0) {
+            west = Ops::load(row + (j - 1) * count);
+        } else {
+            west = Ops::load(row + last * count);
+            if (tail) west = Ops::shl(west, int(64 - tail));
+        }
+        if (j < last)
+            east = Ops::load(row + (j + 1) * count);
+        else
+            east = tail ? Ops::zero() : Ops::load(row);
+    }
+};
+
+template <class Ops, class Rule>
+inline void step_batch_impl(const Rule& rule, const uint64_t* in, uint64_t* out,
+                            size_t count, size_t begin, size_t end,
+                            size_t width, size_t height,
+                            uint64_t* changed, uint64_t* changed2) {
+    using V = typename Ops::V;
+    constexpr size_t L = Ops::lanes;
+    const size_t row_words = (width + 63) / 64;
+    const size_t last = row_words - 1;
+    const unsigned tail = unsigned(width % 64);
+    const V last_mask = Ops::set1(tail ? (uint64_t(1) << tail) - 1 : ~uint64_t(0));
+    const size_t row_stride = row_words * count;
+
+    for (size_t y = 0; y < height; ++y) {
+        const uint64_t* up = in + ((y + height - 1) % height) * row_stride;
+        const uint64_t* mid = in + y * row_stride;
+        const uint64_t* down = in + ((y + 1) % height) * row_stride;
+        uint64_t* dst = out + y * row_stride;
+        for (size_t j = 0; j < row_words; ++j) {
+            for (size_t g = begin; g < end; g += L) {
+                BatchRow<Ops> u(up + g, count, j, last, tail);
+                BatchRow<Ops> m(mid + g, count, j, last, tail);
+                BatchRow<Ops> d(down + g, count, j, last, tail);
+                V result = step_chunk<Ops>(rule, u.c, u.west, u.east, m.c, m.west, m.east,
+                                           d.c, d.west, d.east);
+                if (j == last) result = Ops::and_(result, last_mask);
+                size_t at = j * count + g;
+                V before = Ops::load(dst + at);
+                Ops::store(dst + at, result);
+                Ops::store(changed + g, Ops::or_(Ops::load(changed + g),
+                                                 Ops::xor_(result, Ops::load(mid + at))));
+                Ops::store(changed2 + g, Ops::or_(Ops::load(changed2 + g),
+                                                  Ops::xor_(result, before)));
+            }
+        }
+    }
+}
+
+// StepRowFn, StepColumnFn and StepBatchFn for one rule.
+template <class Ops, template <class> class Rule>
+void step_row_rule(const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                   uint64_t* out, size_t begin, size_t end,
+                   size_t nwords, size_t width, uint64_t* tile_diff, const uint64_t* table) {
+    step_row_impl<Ops>(Rule<Ops>(table), up, mid, down, out, begin, end, nwords, width,
+                       tile_diff);
+}
+
+template <class Ops, template <class> class Rule>
+uint64_t step_column_rule(const uint64_t* west, const uint64_t* mid, const uint64_t* east,
+                          uint64_t* out, size_t rows, const uint64_t* table) {
+    return step_column_impl<Ops>(Rule<Ops>(table), west, mid, east, out, rows);
+}
+
+template <class Ops, template <class> class Rule>
+void step_batch_rule(const uint64_t* in, uint64_t* out, size_t count, size_t begin, size_t end,
+                     size_t width, size_t height, uint64_t* changed, uint64_t* changed2,
+                     const uint64_t* table) {
+    step_batch_impl<Ops>(Rule<Ops>(table), in, out, count, begin, end, width, height,
+                         changed, changed2);
+}
+
+inline size_t count_span_fn(const uint64_t* row, size_t begin, size_t end) {
+    return count_span_impl(row, begin, end);
+}
+
+// The partial word at the end of a row goes through a zeroed scratch, so
+// nothing past `width` is read or written.
+template <class Ops>
+void unpack_row_fn(const uint64_t* row, uint8_t* out, size_t width) {
+    const size_t full = width / 64;
+    for (size_t w = 0; w < full; ++w)
+        Ops::unpack64(row[w], out + w * 64);
+    if (size_t tail = width % 64) {
+        uint8_t scratch[64];
+        Ops::unpack64(row[full], scratch);
+        __builtin_memcpy(out + full * 64, scratch, tail);
+    }
+}
+
+template <class Ops>
+void pack_row_fn(const uint8_t* in, uint64_t* row, size_t width) {
+    const size_t full = width / 64;
+    for (size_t w = 0; w < full; ++w)
+        row[w] = Ops::pack64(in + w * 64);
+    if (size_t tail = width % 64) {
+        uint8_t scratch[64] = {};
+        __builtin_memcpy(scratch, in + full * 64, tail);
+        row[full] = Ops::pack64(scratch);
+    }
+}
+
+// The kernel of one instruction set, its entries indexed by RuleKind.
+template <class Ops>
+constexpr StepKernel make_kernel(const char* name) {
+    return StepKernel{name,
+                      {step_row_rule<Ops, LifeRule>, step_row_rule<Ops, HighLifeRule>,
+                       step_row_rule<Ops, SeedsRule>, step_row_rule<Ops, DayNightRule>,
+                       step_row_rule<Ops, TableRule>},
+                      count_span_fn,
+                      unpack_row_fn<Ops>,
+                      pack_row_fn<Ops>,
+                      {step_column_rule<Ops, LifeRule>, step_column_rule<Ops, HighLifeRule>,
+                       step_column_rule<Ops, SeedsRule>, step_column_rule<Ops, DayNightRule>,
+                       step_column_rule<Ops, TableRule>},
+                      {step_batch_rule<Ops, LifeRule>, step_batch_rule<Ops, HighLifeRule>,
+                       step_batch_rule<Ops, SeedsRule>, step_batch_rule<Ops, DayNightRule>,
+                       step_batch_rule<Ops, TableRule>}};
+}
+
+} // namespace
+} // namespace detail
+} // namespace gol
@@ -0,0 +1,71 @@
+#include "kernel_impl.hpp"
+#include <emmintrin.h>
+
+namespace gol {
+namespace detail {
+
+namespace {
+
+struct Sse2Ops {
+    using V = __m128i;
+    static constexpr size_t lanes = 2;
+
+    static V load(const uint64_t* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+    static V loadu(const uint64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(uint64_t* p, V v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+    static V and_(V a, V b) { return _mm_and_si128(a, b); }
+    static V or_(V a, V b) { return _mm_or_si128(a, b); }
+    static V xor_(V a, V b) { return _mm_xor_si128(a, b); }
+    static V andnot(V a, V b) { return _mm_andnot_si128(a, b); }
+    static V shl(V a, int n) { return _mm_slli_epi64(a, n); }
+    static V shr(V a, int n) { return _mm_srli_epi64(a, n); }
+    static V xor3(V a, V b, V c) { return xor_(xor_(a, b), c); }
+    static V maj(V a, V b, V c) { return or_(and_(a, b), and_(xor_(a, b), c)); }
+    static V zero() { return _mm_setzero_si128(); }
+    static uint64_t any(V a) {
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(a)) |
+               static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(a, a)));
+    }
+    static V west(V prev, V cur) {
+        return _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(prev), _mm_castsi128_pd(cur), 1));
+    }
+    static V east(V cur, V next) {
+        return _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(cur), _mm_castsi128_pd(next), 1));
+    }
+    static V lane(size_t i, uint64_t v) {
+        return _mm_set_epi64x(i == 1 ? static_cast<long long>(v) : 0,
+                              i == 0 ? static_cast<long long>(v) : 0);
+    }
+    static V set1(uint64_t v) { return _mm_set1_epi64x(static_cast<long long>(v)); }
+    static V head_mask(size_t n) { return _mm_set_epi64x(n > 1 ? -1 : 0, n > 0 ? -1 : 0); }
+    static uint64_t pack64(const uint8_t* in) {
+        const __m128i zero = _mm_setzero_si128();
+        uint64_t word = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16 * i));
+            uint64_t dead = static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+            word |= (~dead & 0xFFFF) << (16 * i);
+        }
+        return word;
+    }
+    // Each 8-byte half repeats one byte of the word, then keeps bit j of it
+    // in byte j.
+    static void unpack64(uint64_t word, uint8_t* out) {
+        const __m128i bit = _mm_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+        const __m128i one = _mm_set1_epi8(1);
+        for (int i = 0; i < 4; ++i) {
+            uint64_t lo = (word >> (16 * i)) & 0xFF, hi = (word >> (16 * i + 8)) & 0xFF;
+            __m128i v = _mm_set_epi64x(static_cast<long long>(hi * 0x0101010101010101ULL),
+                                       static_cast<long long>(lo * 0x0101010101010101ULL));
+            v = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(v, bit), bit), one);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * i), v);
+        }
+    }
+};
+
+} // namespace
+
+const StepKernel kSse2Kernel = make_kernel<Sse2Ops>("sse2");
+
+} // namespace detail
+} // namespace gol
@@ -0,0 +1,170 @@
+#include "gol/macrocell.hpp"
+#include "gol/plane.hpp"
+#include "gol/rule.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace gol {
+
+MacrocellError::MacrocellError(const std::string& what, size_t line)
+    : std::invalid_argument("Macrocell line " + std::to_string(line) + ": " + what),
+      line_(line) {}
+
+namespace {
+
+// Deeper trees would not fit 64-bit coordinates.
+constexpr unsigned kMaxLevel = 62;
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return std::string();
+    return s.substr(begin, s.find_last_not_of(" \t") - begin + 1);
+}
+
+// Parses a whole decimal field, false if it is not one.
+bool parse_number(const std::string& s, uint64_t& value) {
+    if (s.empty() || s.size() > 19 || s.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    value = std::strtoull(s.c_str(), nullptr, 10);
+    return true;
+}
+
+// "$"-separated rows of '.' and '*', trailing dead cells and rows left out.
+uint64_t parse_leaf(const std::string& s, size_t line) {
+    uint64_t cells = 0;
+    unsigned x = 0, y = 0;
+    for (char c : s) {
+        if (c == '$') {
+            ++y;
+            x = 0;
+            continue;
+        }
+        if (c != '.' && c != '*')
+            throw MacrocellError(std::string("unexpected character '") + c + "' in leaf", line);
+        if (x >= 8 || y >= 8) throw MacrocellError("leaf larger than 8x8", line);
+        if (c == '*') cells |= uint64_t(1) << (y * 8 + x);
+        ++x;
+    }
+    return cells;
+}
+
+// "level nw ne sw se", children numbering earlier nodes from 1.
+Macrocell::Node parse_node(const std::string& s, const std::vector<Macrocell::Node>& nodes,
+                           size_t line) {
+    std::vector<std::string> fields;
+    for (size_t pos = s.find_first_not_of(" \t"); pos != std::string::npos;) {
+        size_t end = std::min(s.find_first_of(" \t", pos), s.size());
+        fields.push_back(s.substr(pos, end - pos));
+        pos = s.find_first_not_of(" \t", end);
+    }
+    uint64_t values[5];
+    if (fields.size() != 5) throw MacrocellError("expected 'level nw ne sw se'", line);
+    for (int i = 0; i < 5; ++i)
+        if (!parse_number(fields[size_t(i)], values[i]))
+            throw MacrocellError("expected a number, got '" + fields[size_t(i)] + "'", line);
+    if (values[0] < 3) throw MacrocellError("multi-state nodes are not supported", line);
+    if (values[0] == 3 || values[0] > kMaxLevel)
+        throw MacrocellError("bad node level " + fields[0], line);
+
+    Macrocell::Node node;
+    node.level = uint8_t(values[0]);
+    for (int i = 0; i < 4; ++i) {
+        uint64_t child = values[i + 1];
+        if (child > nodes.size())
+            throw MacrocellError("child " + fields[size_t(i) + 1] + " is not an earlier node", line);
+        if (child && nodes[child - 1].level + 1 != node.level)
+            throw MacrocellError("child " + fields[size_t(i) + 1] + " has the wrong level", line);
+        node.children[i] = uint32_t(child);
+    }
+    return node;
+}
+
+void plant(Plane& plane, const Macrocell& macrocell, uint32_t index, int64_t x0, int64_t y0) {
+    if (index == 0) return;
+    const Macrocell::Node& node = macrocell.nodes[index - 1];
+    if (node.level == 3) {
+        for (uint64_t cells = node.cells; cells; cells &= cells - 1) {
+            int bit = __builtin_ctzll(cells);
+            plane.set_cell(x0 + bit % 8, y0 + bit / 8, true);
+        }
+        return;
+    }
+    int64_t s = int64_t(1) << (node.level - 1);
+    plant(plane, macrocell, node.children[0], x0, y0);
+    plant(plane, macrocell, node.children[1], x0 + s, y0);
+    plant(plane, macrocell, node.children[2], x0, y0 + s);
+    plant(plane, macrocell, node.children[3], x0 + s, y0 + s);
+}
+
+} // namespace
+
+Macrocell parse_macrocell(const std::string& text) {
+    Macrocell macrocell;
+    size_t line = 0;
+    for (size_t pos = 0; pos < text.size() || line == 0;) {
+        size_t end = std::min(text.find('\n', pos), text.size());
+        std::string s = text.substr(pos, end - pos);
+        if (!s.empty() && s.back() == '\r') s.pop_back();
+        pos = end + 1;
+        if (++line == 1) {
+            if (s.compare(0, 4, "[M2]") != 0) throw MacrocellError("expected '[M2]'", line);
+            continue;
+        }
+        if (s.empty()) continue;
+
+        if (s[0] == '#') {
+            std::string value = trim(s.substr(std::min<size_t>(2, s.size())));
+            if (s.size() > 1 && s[1] == 'R') {
+                try {
+                    Rule::parse(value);
+                } catch (const std::invalid_argument&) {
+                    throw MacrocellError("unsupported rule '" + value + "'", line);
+                }
+                macrocell.rule = value;
+            } else if (s.size() > 1 && s[1] == 'G') {
+                if (!parse_number(value, macrocell.generation))
+                    throw MacrocellError("expected a generation, got '" + value + "'", line);
+            }
+            continue;
+        }
+        if (macrocell.nodes.size() >= 0xFFFFFFFFu) throw MacrocellError("too many nodes", line);
+        if (s[0] == '.' || s[0] == '*' || s[0] == '$') {
+            Macrocell::Node leaf;
+            leaf.cells = parse_leaf(s, line);
+            macrocell.nodes.push_back(leaf);
+        } else {
+            macrocell.nodes.push_back(parse_node(s, macrocell.nodes, line));
+        }
+    }
+    return macrocell;
+}
+
+std::string to_macrocell(const Macrocell& macrocell) {
+    std::string out = "[M2] (game_of_life)\n";
+    if (!macrocell.rule.empty()) out += "#R " + macrocell.rule + "\n";
+    if (macrocell.generation) out += "#G " + std::to_string(macrocell.generation) + "\n";
+    for (const Macrocell::Node& node : macrocell.nodes) {
+        if (node.level == 3) {
+            for (unsigned y = 0; y < 8 && node.cells >> (y * 8); ++y) {
+                unsigned row = unsigned(node.cells >> (y * 8)) & 0xFF;
+                for (unsigned x = 0; row >> x; ++x) out += (row >> x) & 1 ? '*' : '.';
+                out += '$';
+            }
+            if (!node.cells) out += '$';
+        } else {
+            out += std::to_string(node.level);
+            for (uint32_t child : node.children) out += ' ' + std::to_string(child);
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+void load_macrocell(Plane& plane, const Macrocell& macrocell, int64_t x, int64_t y) {
+    if (!macrocell.rule.empty()) plane.set_rule(Rule::parse(macrocell.rule));
+    if (macrocell.nodes.empty()) return;
+    int64_t half = int64_t(1) << (macrocell.level() - 1);
+    plant(plane, macrocell, uint32_t(macrocell.nodes.size()), x - half, y - half);
+}
+
+} // namespace gol
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GOL_MAPPED_FILE_POSIX 1
+#endif
+
+namespace gol {
+namespace detail {
+
+// A whole file, read-only: mapped where possible, else read into memory.
+// Throws std::runtime_error with `what` if the file cannot be opened.
+class MappedFile {
+public:
+    MappedFile(const std::string& path, const std::string& what) {
+#ifdef GOL_MAPPED_FILE_POSIX
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error(what + ": cannot open '" + path + "'");
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            size_ = size_t(st.st_size);
+            void* map = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                ::close(fd);
+                map_ = map;
+                data_ = static_cast<const char*>(map);
+                return;
+            }
+        }
+        ::close(fd);
+#endif
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) throw std::runtime_error(what + ": cannot open '" + path + "'");
+        char chunk[1 << 16];
+        size_t got;
+        while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+            copy_.insert(copy_.end(), chunk, chunk + got);
+        std::fclose(file);
+        data_ = copy_.data();
+        size_ = copy_.size();
+    }
+    ~MappedFile() {
+#ifdef GOL_MAPPED_FILE_POSIX
+        if (map_) ::munmap(map_, size_);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void* map_ = nullptr;
+    std::vector<char> copy_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace detail
+} // namespace gol
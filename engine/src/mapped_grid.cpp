@@ -0,0 +1,429 @@
+#include "gol/mapped_grid.hpp"
+#include "bits.hpp"
+#include "kernel.hpp"
+#include "random_words.hpp"
+#include "snapshot_format.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GOL_MAPPED_GRID_POSIX 1
+#endif
+
+namespace gol {
+
+namespace {
+
+using namespace detail::snapshot;
+
+// Rows padded as in Grid, so kernels see the same layout.
+constexpr size_t kRowAlignWords = 8;
+
+[[noreturn]] void fail(const std::string& what, const std::string& path) {
+    throw std::runtime_error("MappedGrid: " + what + " '" + path + "'");
+}
+
+} // namespace
+
+MappedGrid::MappedGrid(const std::string& path, size_t width, size_t height)
+    : path_(path), width_(width), height_(height),
+      row_words_((width + 63) / 64),
+      words_per_row_((row_words_ + kRowAlignWords - 1) / kRowAlignWords * kRowAlignWords) {
+#ifdef GOL_MAPPED_GRID_POSIX
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) fail("cannot create", path);
+    const size_t size = kPage + words_per_row_ * height_ * sizeof(uint64_t);
+    if (::ftruncate(fd_, off_t(size)) != 0) {
+        ::close(fd_);
+        fail("cannot size", path);
+    }
+    map(path, PROT_READ | PROT_WRITE, size);
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrder;
+    header.width = width_;
+    header.height = height_;
+    header.words_per_row = words_per_row_;
+    std::memcpy(map_, &header, sizeof(header));
+    write_header();
+#else
+    fail("memory-mapped files are not supported here:", path);
+#endif
+    tiles_x_ = (row_words_ + Grid::kTileWords - 1) / Grid::kTileWords;
+    tiles_y_ = (height_ + kTileRows - 1) / kTileRows;
+    changed_.assign(tiles_y_, 0);
+    pop_.assign(tiles_y_, 0);
+}
+
+MappedGrid::MappedGrid(const std::string& path) : path_(path) {
+#ifdef GOL_MAPPED_GRID_POSIX
+    fd_ = ::open(path.c_str(), O_RDWR);
+    if (fd_ < 0) fail("cannot open", path);
+    struct stat st;
+    Header header;
+    if (::fstat(fd_, &st) != 0 || size_t(st.st_size) < kPage ||
+        ::pread(fd_, &header, sizeof(header), 0) != ssize_t(sizeof(header))) {
+        ::close(fd_);
+        fail("not a snapshot:", path);
+    }
+    try {
+        check_header(header, size_t(st.st_size), path);
+        if (header.flags & kSparse) fail("cannot step a sparse snapshot:", path);
+    } catch (...) {
+        ::close(fd_);
+        throw;
+    }
+    width_ = size_t(header.width);
+    height_ = size_t(header.height);
+    row_words_ = (width_ + 63) / 64;
+    words_per_row_ = size_t(header.words_per_row);
+    generation_ = size_t(header.generation);
+    rule_.birth = header.birth;
+    rule_.survive = header.survive;
+    map(path, PROT_READ | PROT_WRITE, kPage + words_per_row_ * height_ * sizeof(uint64_t));
+#else
+    fail("memory-mapped files are not supported here:", path);
+#endif
+    tiles_x_ = (row_words_ + Grid::kTileWords - 1) / Grid::kTileWords;
+    tiles_y_ = (height_ + kTileRows - 1) / kTileRows;
+    changed_.assign(tiles_y_, 1);
+    pop_.assign(tiles_y_, 0);
+
+    // The kernels need the bits past the width clear, and one pass over the
+    // file counts it while clearing them.
+    const detail::CountSpanFn count_span = detail::active_kernel().count_span;
+    const uint64_t last_mask = width_ % 64 ? (uint64_t(1) << (width_ % 64)) - 1 : ~uint64_t(0);
+    for (size_t t0 = 0; t0 < tiles_y_; t0 += band()) {
+        size_t t1 = std::min(tiles_y_, t0 + band());
+        prefetch(t0 * kTileRows, std::min(height_, t1 * kTileRows));
+        detail::ThreadPool::instance().parallel_for(t1 - t0, [&](size_t i, size_t) {
+            size_t ty = t0 + i;
+            uint64_t count = 0;
+            for (size_t y = ty * kTileRows; y < ty * kTileRows + tile_rows(ty); ++y) {
+                uint64_t* r = row(y);
+                if (row_words_ && (r[row_words_ - 1] & ~last_mask)) r[row_words_ - 1] &= last_mask;
+                for (size_t w = row_words_; w < words_per_row_; ++w)
+                    if (r[w]) r[w] = 0;
+                count += count_span(r, 0, row_words_);
+            }
+            pop_[ty] = count;
+        });
+        if (t1 - t0 < tiles_y_) release(t0 * kTileRows, std::min(height_, t1 * kTileRows));
+    }
+}
+
+MappedGrid::~MappedGrid() {
+#ifdef GOL_MAPPED_GRID_POSIX
+    if (map_) ::munmap(map_, map_size_);
+    if (fd_ >= 0) ::close(fd_);
+#endif
+}
+
+void MappedGrid::map(const std::string& path, int prot, size_t size) {
+#ifdef GOL_MAPPED_GRID_POSIX
+    void* p = ::mmap(nullptr, size, prot, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        ::close(fd_);
+        fd_ = -1;
+        fail("cannot map", path);
+    }
+    map_ = p;
+    map_size_ = size;
+    words_ = reinterpret_cast<uint64_t*>(static_cast<char*>(p) + kPage);
+#ifdef MADV_SEQUENTIAL
+    ::madvise(static_cast<char*>(p) + kPage, size - kPage, MADV_SEQUENTIAL);
+#endif
+#else
+    (void)prot;
+    (void)size;
+    fail("memory-mapped files are not supported here:", path);
+#endif
+}
+
+// The header sits in the mapping, so it goes out with the cells.
+void MappedGrid::write_header() {
+    Header* header = static_cast<Header*>(map_);
+    header->generation = generation_;
+    header->birth = rule_.birth;
+    header->survive = rule_.survive;
+}
+
+void MappedGrid::set_generation(size_t generation) {
+    generation_ = generation;
+    write_header();
+}
+
+void MappedGrid::set_rule(const Rule& rule) {
+    rule_ = rule;
+    std::fill(changed_.begin(), changed_.end(), 1);
+    write_header();
+}
+
+size_t MappedGrid::tile_rows(size_t ty) const {
+    return std::min(kTileRows, height_ - ty * kTileRows);
+}
+
+size_t MappedGrid::band() const {
+    size_t tile_row_bytes = kTileRows * words_per_row_ * sizeof(uint64_t);
+    return std::max<size_t>(1, resident_limit_ / 2 / std::max<size_t>(1, tile_row_bytes));
+}
+
+// Both round outward to whole pages. Releasing drops the pages from this
+// process only: dirty ones stay in the page cache until written back.
+void MappedGrid::prefetch(size_t begin, size_t end) const {
+#if defined(GOL_MAPPED_GRID_POSIX) && defined(MADV_WILLNEED)
+    if (begin >= end) return;
+    const uintptr_t page = uintptr_t(::sysconf(_SC_PAGESIZE));
+    uintptr_t from = reinterpret_cast<uintptr_t>(row(begin)) / page * page;
+    uintptr_t to = reinterpret_cast<uintptr_t>(row(end));
+    ::madvise(reinterpret_cast<void*>(from), to - from, MADV_WILLNEED);
+#else
+    (void)begin;
+    (void)end;
+#endif
+}
+
+void MappedGrid::release(size_t begin, size_t end) const {
+#if defined(GOL_MAPPED_GRID_POSIX) && defined(MADV_DONTNEED)
+    if (begin >= end) return;
+    const uintptr_t page = uintptr_t(::sysconf(_SC_PAGESIZE));
+    uintptr_t from = reinterpret_cast<uintptr_t>(row(begin)) / page * page;
+    uintptr_t to = (reinterpret_cast<uintptr_t>(row(end)) + page - 1) / page * page;
+    to = std::min(to, reinterpret_cast<uintptr_t>(map_) + map_size_);
+    ::madvise(reinterpret_cast<void*>(from), to - from, MADV_DONTNEED);
+#else
+    (void)begin;
+    (void)end;
+#endif
+}
+
+void MappedGrid::edited(size_t y_begin, size_t y_end) {
+    for (size_t ty = y_begin / kTileRows; ty * kTileRows < y_end; ++ty) {
+        changed_[ty] = 1;
+        pop_[ty] = kPopStale;
+    }
+}
+
+void MappedGrid::set_cell(size_t x, size_t y, bool alive) {
+    if (x >= width_ || y >= height_) return;
+    uint64_t& word = row(y)[x / 64];
+    uint64_t bit = uint64_t(1) << (x % 64);
+    if (bool(word & bit) == alive) return;
+    word ^= bit;
+    edited(y, y + 1);
+}
+
+bool MappedGrid::get_cell(size_t x, size_t y) const {
+    if (x >= width_ || y >= height_) return false;
+    return row(y)[x / 64] >> (x % 64) & 1;
+}
+
+// In place, as Grid does in low-memory mode: each tile row reads the rows
+// just outside it from copies, since a neighbor may have overwritten them,
+// and writes its own rows back one behind. Between bands, the row above
+// the next band is kept in above_, and the band's last tile row reads the
+// next band's first row from the file, where it is still unstepped.
+void MappedGrid::step() {
+    if (tiles_y_ == 0 || row_words_ == 0) {
+        set_generation(generation_ + 1);
+        return;
+    }
+    const detail::RuleTable rule = detail::make_rule_table(rule_.birth, rule_.survive);
+    const detail::StepRowFn step_row = detail::active_kernel().step_row[rule.kind];
+    const detail::CountSpanFn count_span = detail::active_kernel().count_span;
+    detail::ThreadPool& pool = detail::ThreadPool::instance();
+    const size_t stride = words_per_row_;
+
+    active_.resize(tiles_y_);
+    bool any = false;
+    for (size_t ty = 0; ty < tiles_y_; ++ty) {
+        active_[ty] = changed_[(ty + tiles_y_ - 1) % tiles_y_] | changed_[ty] |
+                      changed_[(ty + 1) % tiles_y_];
+        any |= active_[ty] != 0;
+    }
+    if (!any) {
+        set_generation(generation_ + 1);
+        return;
+    }
+
+    // A board that fits in one band stays mapped in whole; releasing it
+    // would only fault it back in next generation.
+    const size_t band_rows = std::min(band(), tiles_y_);
+    const bool streaming = band_rows < tiles_y_;
+    edges_.resize(2 * band_rows * stride);
+    wrap_.resize(2 * stride);
+    above_.resize(stride);
+    std::memcpy(&wrap_[0], row(0), stride * sizeof(uint64_t));
+    std::memcpy(&wrap_[stride], row(height_ - 1), stride * sizeof(uint64_t));
+    Words pending(pool.size() * 2 * stride);
+    std::vector<uint64_t> diffs(pool.size() * tiles_x_);
+
+    for (size_t t0 = 0; t0 < tiles_y_; t0 += band_rows) {
+        const size_t t1 = std::min(tiles_y_, t0 + band_rows);
+        const size_t y0 = t0 * kTileRows, y1 = std::min(height_, t1 * kTileRows);
+        if (std::find(&active_[t0], &active_[0] + t1, 1) == &active_[0] + t1) {
+            std::memcpy(above_.data(), row(y1 - 1), stride * sizeof(uint64_t));
+            continue;
+        }
+        if (streaming && t1 < tiles_y_)
+            prefetch(y1, std::min(height_, (t1 + band_rows) * kTileRows));
+
+        for (size_t ty = t0; ty < t1; ++ty) {
+            bool before = ty > t0 && active_[ty - 1], after = ty + 1 < t1 && active_[ty + 1];
+            if (!before && !after && !active_[ty]) continue;
+            size_t first = ty * kTileRows, last = first + tile_rows(ty) - 1;
+            std::memcpy(&edges_[2 * (ty - t0) * stride], row(first), stride * sizeof(uint64_t));
+            std::memcpy(&edges_[(2 * (ty - t0) + 1) * stride], row(last), stride * sizeof(uint64_t));
+        }
+
+        pool.parallel_for(t1 - t0, [&](size_t i, size_t worker) {
+            const size_t ty = t0 + i;
+            if (!active_[ty]) {
+                changed_[ty] = 0;
+                return;
+            }
+            uint64_t* out_rows = &pending[worker * 2 * stride];
+            uint64_t* diff = &diffs[worker * tiles_x_];
+            std::fill(diff, diff + tiles_x_, 0);
+            uint64_t count = 0;
+            const size_t y_begin = ty * kTileRows, y_end = y_begin + tile_rows(ty);
+            for (size_t y = y_begin; y < y_end; ++y) {
+                const uint64_t* up = y > y_begin ? row(y - 1)
+                                   : ty == 0    ? &wrap_[stride]
+                                   : ty == t0   ? above_.data()
+                                                : &edges_[(2 * (ty - 1 - t0) + 1) * stride];
+                const uint64_t* down = y + 1 < y_end     ? row(y + 1)
+                                     : ty + 1 == tiles_y_ ? &wrap_[0]
+                                     : ty + 1 == t1       ? row(y + 1)
+                                                          : &edges_[2 * (ty + 1 - t0) * stride];
+                uint64_t* out = out_rows + (y % 2) * stride;
+                step_row(up, row(y), down, out, 0, row_words_, row_words_, width_, diff,
+                         rule.masks);
+                count += count_span(out, 0, row_words_);
+                if (y > y_begin)
+                    std::memcpy(row(y - 1), out_rows + ((y - 1) % 2) * stride,
+                                row_words_ * sizeof(uint64_t));
+            }
+            std::memcpy(row(y_end - 1), out_rows + ((y_end - 1) % 2) * stride,
+                        row_words_ * sizeof(uint64_t));
+            changed_[ty] = std::any_of(diff, diff + tiles_x_, [](uint64_t d) { return d != 0; });
+            pop_[ty] = count;
+        });
+
+        // The next band's top neighbor, as it was before this generation.
+        std::memcpy(above_.data(),
+                    active_[t1 - 1] ? &edges_[(2 * (t1 - 1 - t0) + 1) * stride] : row(y1 - 1),
+                    stride * sizeof(uint64_t));
+        if (streaming) release(y0, y1);
+    }
+    set_generation(generation_ + 1);
+}
+
+void MappedGrid::step_n(size_t n) {
+    for (size_t i = 0; i < n; ++i) step();
+}
+
+void MappedGrid::clear() {
+#ifdef GOL_MAPPED_GRID_POSIX
+    // Cutting the file back to its header and growing it again reads back
+    // as zeros, without writing them.
+    if (::ftruncate(fd_, off_t(kPage)) != 0 || ::ftruncate(fd_, off_t(map_size_)) != 0)
+        fail("cannot clear", path_);
+#endif
+    std::fill(changed_.begin(), changed_.end(), 0);
+    std::fill(pop_.begin(), pop_.end(), 0);
+    set_generation(0);
+}
+
+void MappedGrid::randomize(double density, uint64_t seed) {
+    const detail::RandomWords random(density, seed);
+    const detail::CountSpanFn count_span = detail::active_kernel().count_span;
+    const uint64_t last_mask = width_ % 64 ? (uint64_t(1) << (width_ % 64)) - 1 : ~uint64_t(0);
+    for (size_t t0 = 0; t0 < tiles_y_; t0 += band()) {
+        size_t t1 = std::min(tiles_y_, t0 + band());
+        detail::ThreadPool::instance().parallel_for(t1 - t0, [&](size_t i, size_t) {
+            size_t ty = t0 + i;
+            uint64_t count = 0;
+            for (size_t y = ty * kTileRows; y < ty * kTileRows + tile_rows(ty); ++y) {
+                uint64_t* r = row(y);
+                for (size_t w = 0; w < row_words_; ++w) r[w] = random(y * row_words_ + w);
+                if (row_words_) r[row_words_ - 1] &= last_mask;
+                count += count_span(r, 0, row_words_);
+            }
+            pop_[ty] = count;
+        });
+        if (t1 - t0 < tiles_y_) release(t0 * kTileRows, std::min(height_, t1 * kTileRows));
+    }
+    std::fill(changed_.begin(), changed_.end(), 1);
+    set_generation(0);
+}
+
+template <class Op>
+void MappedGrid::blit(const Grid& src, size_t sx, size_t sy, size_t w, size_t h, size_t dx,
+                      size_t dy, Op op) {
+    if (w == 0 || h == 0) return;
+    bool changed = false;
+    for (size_t r = 0; r < h; ++r)
+        changed |= detail::blit_bits(row(dy + r), dx,
+                                     src.data() + (sy + r) * src.words_per_row(), sx, w, op);
+    if (changed) edited(dy, dy + h);
+}
+
+void MappedGrid::paste(const Grid& pattern, size_t ox, size_t oy, BlitMode mode) {
+    if (width_ == 0 || height_ == 0) return;
+    detail::wrap_runs(oy, pattern.height(), height_, [&](size_t py, size_t y, size_t h) {
+        detail::wrap_runs(ox, pattern.width(), width_, [&](size_t px, size_t x, size_t w) {
+            switch (mode) {
+            case BlitMode::kOr: blit(pattern, px, py, w, h, x, y, detail::OrBits()); break;
+            case BlitMode::kAnd: blit(pattern, px, py, w, h, x, y, detail::AndBits()); break;
+            case BlitMode::kXor: blit(pattern, px, py, w, h, x, y, detail::XorBits()); break;
+            case BlitMode::kCopy: blit(pattern, px, py, w, h, x, y, detail::CopyBits()); break;
+            }
+        });
+    });
+}
+
+Grid MappedGrid::extract(size_t x, size_t y, size_t w, size_t h) const {
+    Grid result(w, h);
+    result.set_rule(rule_);
+    if (width_ == 0 || height_ == 0) return result;
+    uint64_t* out = result.mutable_data();
+    detail::wrap_runs(y, h, height_, [&](size_t ry, size_t sy, size_t rh) {
+        detail::wrap_runs(x, w, width_, [&](size_t rx, size_t sx, size_t rw) {
+            for (size_t r = 0; r < rh; ++r)
+                detail::blit_bits(out + (ry + r) * result.words_per_row(), rx, row(sy + r), sx, rw,
+                                  detail::CopyBits());
+        });
+    });
+    result.touch();
+    return result;
+}
+
+size_t MappedGrid::population() const {
+    const detail::CountSpanFn count_span = detail::active_kernel().count_span;
+    size_t count = 0;
+    for (size_t ty = 0; ty < tiles_y_; ++ty) {
+        if (pop_[ty] == kPopStale) {
+            pop_[ty] = 0;
+            for (size_t y = ty * kTileRows; y < ty * kTileRows + tile_rows(ty); ++y)
+                pop_[ty] += count_span(row(y), 0, row_words_);
+        }
+        count += pop_[ty];
+    }
+    return count;
+}
+
+void MappedGrid::sync() {
+#ifdef GOL_MAPPED_GRID_POSIX
+    if (::msync(map_, map_size_, MS_SYNC) != 0) fail("cannot write", path_);
+#endif
+}
+
+} // namespace gol
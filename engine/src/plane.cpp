@@ -0,0 +1,208 @@
+#include "gol/plane.hpp"
+#include "gol/grid.hpp"
+#include "kernel.hpp"
+#include "random_words.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gol {
+
+namespace {
+
+constexpr int64_t kCoordLimit = int64_t(1) << 37;
+constexpr size_t kLastRow = Plane::kTileSize - 1;
+
+bool in_range(int64_t x, int64_t y) {
+    return x >= -kCoordLimit && x < kCoordLimit && y >= -kCoordLimit && y < kCoordLimit;
+}
+
+} // namespace
+
+Plane::Plane(size_t width, size_t height)
+    : width_(width), height_(height) {}
+
+void Plane::set_rule(const Rule& rule) {
+    // Births need a live neighbor, so only tiles next to live cells can
+    // come alive, which step() relies on.
+    if (rule.birth & 1) throw std::invalid_argument("Plane: B0 rules are not supported");
+    rule_ = rule;
+}
+
+const Plane::Tile* Plane::find(int64_t tx, int64_t ty) const {
+    auto it = tiles_.find(key(tx, ty));
+    return it == tiles_.end() ? nullptr : &it->second;
+}
+
+void Plane::set_cell(int64_t x, int64_t y, bool alive) {
+    if (!in_range(x, y)) return;
+    Key k = key(x >> 6, y >> 6);
+    uint64_t mask = uint64_t(1) << (x & 63);
+    if (alive) {
+        uint64_t& row = tiles_[k].rows[y & 63];
+        population_ += (row & mask) == 0;
+        row |= mask;
+        return;
+    }
+    auto it = tiles_.find(k);
+    if (it == tiles_.end()) return;
+    uint64_t& row = it->second.rows[y & 63];
+    population_ -= (row & mask) != 0;
+    row &= ~mask;
+    const uint64_t* rows = it->second.rows;
+    if (std::all_of(rows, rows + kTileSize, [](uint64_t r) { return r == 0; }))
+        tiles_.erase(it);
+}
+
+bool Plane::get_cell(int64_t x, int64_t y) const {
+    if (!in_range(x, y)) return false;
+    const Tile* tile = find(x >> 6, y >> 6);
+    return tile && (tile->rows[y & 63] >> (x & 63)) & 1;
+}
+
+void Plane::step() {
+    const detail::StepKernel& kernel = detail::active_kernel();
+    const detail::RuleTable rule = detail::make_rule_table(rule_.birth, rule_.survive);
+    const detail::StepColumnFn step_column = kernel.step_column[rule.kind];
+
+    // Every live tile, plus each missing neighbor that a live cell on the
+    // shared edge or corner could give birth in.
+    candidates_.clear();
+    for (auto& [k, tile] : tiles_) {
+        candidates_.push_back(k);
+        uint64_t any = 0;
+        for (uint64_t row : tile.rows) any |= row;
+        uint64_t top = tile.rows[0], bottom = tile.rows[kLastRow];
+        int64_t tx = key_x(k), ty = key_y(k);
+        const struct { bool spill; int dx, dy; } sides[] = {
+            {top != 0, 0, -1}, {bottom != 0, 0, 1},
+            {(any & 1) != 0, -1, 0}, {(any >> 63) != 0, 1, 0},
+            {(top & 1) != 0, -1, -1}, {(top >> 63) != 0, 1, -1},
+            {(bottom & 1) != 0, -1, 1}, {(bottom >> 63) != 0, 1, 1},
+        };
+        for (auto& side : sides) {
+            if (side.spill && !find(tx + side.dx, ty + side.dy))
+                candidates_.push_back(key(tx + side.dx, ty + side.dy));
+        }
+    }
+    std::sort(candidates_.begin(), candidates_.end());
+    candidates_.erase(std::unique(candidates_.begin(), candidates_.end()), candidates_.end());
+
+    std::vector<Tile> next(candidates_.size());
+    std::vector<uint8_t> alive(candidates_.size());
+    detail::ThreadPool::instance().parallel_for(candidates_.size(), [&](size_t i, size_t) {
+        int64_t tx = key_x(candidates_[i]), ty = key_y(candidates_[i]);
+        // West, centre and east columns with one halo row above and below.
+        alignas(64) uint64_t cols[3][kTileSize + 2];
+        for (int dx = -1; dx <= 1; ++dx) {
+            uint64_t* col = cols[dx + 1];
+            const Tile* above = find(tx + dx, ty - 1);
+            const Tile* mid = find(tx + dx, ty);
+            const Tile* below = find(tx + dx, ty + 1);
+            col[0] = above ? above->rows[kLastRow] : 0;
+            if (mid)
+                std::memcpy(col + 1, mid->rows, sizeof(mid->rows));
+            else
+                std::memset(col + 1, 0, sizeof(mid->rows));
+            col[kTileSize + 1] = below ? below->rows[0] : 0;
+        }
+        alive[i] = step_column(cols[0], cols[1], cols[2], next[i].rows, kTileSize,
+                               rule.masks) != 0;
+    });
+
+    Tiles stepped;
+    stepped.reserve(candidates_.size());
+    population_ = 0;
+    for (size_t i = 0; i < candidates_.size(); ++i) {
+        if (!alive[i]) continue;
+        population_ += kernel.count_span(next[i].rows, 0, kTileSize);
+        stepped.emplace(candidates_[i], next[i]);
+    }
+    tiles_.swap(stepped);
+    ++generation_;
+}
+
+void Plane::step_n(size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        step();
+    }
+}
+
+void Plane::clear() {
+    tiles_.clear();
+    population_ = 0;
+    generation_ = 0;
+}
+
+// Same words as Grid::randomize, so a Plane and a Grid randomized with one
+// seed start out identical.
+void Plane::randomize(double density, uint64_t seed) {
+    const detail::RandomWords random(density, seed);
+    const size_t row_words = (width_ + 63) / 64;
+
+    clear();
+    for (size_t y = 0; y < height_; ++y) {
+        for (size_t x0 = 0; x0 < width_; x0 += 64) {
+            uint64_t word = random(y * row_words + x0 / 64);
+            if (width_ - x0 < 64) word &= (uint64_t(1) << (width_ - x0)) - 1;
+            if (!word) continue;
+            tiles_[key(int64_t(x0 / 64), int64_t(y / 64))].rows[y % 64] = word;
+            population_ += size_t(__builtin_popcountll(word));
+        }
+    }
+}
+
+void Plane::paste(const Grid& pattern, int64_t x, int64_t y) {
+    for (size_t py = 0; py < pattern.height(); ++py) {
+        const uint64_t* row = pattern.data() + py * pattern.words_per_row();
+        for (size_t w = 0; w < pattern.words_per_row(); ++w) {
+            for (uint64_t bits = row[w]; bits; bits &= bits - 1) {
+                size_t px = w * 64 + size_t(__builtin_ctzll(bits));
+                set_cell(x + int64_t(px), y + int64_t(py), true);
+            }
+        }
+    }
+}
+
+Grid Plane::extract(int64_t x, int64_t y, size_t w, size_t h) const {
+    Grid result(w, h);
+    for (size_t ey = 0; ey < h; ++ey) {
+        for (size_t ex = 0; ex < w; ++ex) {
+            if (get_cell(x + int64_t(ex), y + int64_t(ey)))
+                result.set_cell(ex, ey, true);
+        }
+    }
+    return result;
+}
+
+size_t Plane::memory_usage() const {
+    // Tile, key and hash-node links per tile, plus the bucket array.
+    return tiles_.size() * (sizeof(Tile) + sizeof(Key) + 2 * sizeof(void*)) +
+           tiles_.bucket_count() * sizeof(void*);
+}
+
+Plane::Rect Plane::bounding_box() const {
+    Rect box;
+    if (tiles_.empty()) return box;
+    int64_t x0 = INT64_MAX, y0 = INT64_MAX, x1 = INT64_MIN, y1 = INT64_MIN;
+    for (auto& [k, tile] : tiles_) {
+        int64_t ox = key_x(k) * 64, oy = key_y(k) * 64;
+        uint64_t any = 0;
+        for (size_t r = 0; r < kTileSize; ++r) {
+            if (!tile.rows[r]) continue;
+            any |= tile.rows[r];
+            y0 = std::min(y0, oy + int64_t(r));
+            y1 = std::max(y1, oy + int64_t(r));
+        }
+        x0 = std::min(x0, ox + __builtin_ctzll(any));
+        x1 = std::max(x1, ox + 63 - __builtin_clzll(any));
+    }
+    box.x = x0;
+    box.y = y0;
+    box.width = uint64_t(x1 - x0 + 1);
+    box.height = uint64_t(y1 - y0 + 1);
+    return box;
+}
+
+} // namespace gol
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "bits.hpp"
+
+namespace gol {
+namespace detail {
+
+// Random cells 64 at a time. Word i of a board is a function of the seed
+// and i alone (SplitMix64 run as a counter), so rows can be filled in any
+// order on any number of threads and still come out the same. Boards index
+// their words row by row over (width + 63) / 64 words per row.
+//
+// The density is rounded to kBits binary digits. A cell lives where a
+// kBits-bit uniform number is below it, compared bit-sliced across whole
+// words: from the lowest nonzero digit up, a 1 ORs in a fresh random word
+// and a 0 ANDs one in. A density of 1/2^k is then k words ANDed together.
+class RandomWords {
+public:
+    static constexpr unsigned kBits = 16;
+
+    // A seed of 0 draws one from std::random_device.
+    RandomWords(double density, uint64_t seed)
+        : seed_(seed ? seed : std::random_device{}()),
+          threshold_(uint32_t(std::lround(std::min(std::max(density, 0.0), 1.0) *
+                                          double(1u << kBits)))) {
+        while (first_ < kBits && !(threshold_ >> first_ & 1)) ++first_;
+    }
+
+    uint64_t operator()(uint64_t index) const {
+        if (threshold_ >= 1u << kBits) return ~uint64_t(0);
+        uint64_t bits = 0;
+        for (unsigned i = first_; i < kBits; ++i) {
+            uint64_t r = mix64(seed_ + (index * kBits + i + 1) * kSplitMixGamma);
+            bits = threshold_ >> i & 1 ? bits | r : bits & r;
+        }
+        return bits;
+    }
+
+private:
+    uint64_t seed_;
+    uint32_t threshold_;
+    unsigned first_ = 0;
+};
+
+} // namespace detail
+} // namespace gol
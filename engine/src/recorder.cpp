@@ -0,0 +1,301 @@
+#include "gol/recorder.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gol {
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'O', 'L', 'R', 'E', 'C', '\0', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrder = 0x01020304;
+
+// Each record is a kind byte, the generation and the payload size as
+// varints, then the payload: runs of (words skipped since the last run,
+// run length, the words themselves). A keyframe's runs are the live words
+// of the board, a delta's the XOR of the words that changed.
+enum RecordKind : uint8_t { kKeyframe = 1, kDelta = 2 };
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t width;
+    uint64_t height;
+    uint64_t words_per_row;
+    uint16_t birth;
+    uint16_t survive;
+    uint32_t reserved;
+    uint64_t keyframe_interval;
+    uint64_t reserved2;
+};
+static_assert(sizeof(Header) == 64, "recording header layout");
+
+[[noreturn]] void fail(const std::string& what, const std::string& path) {
+    throw std::runtime_error("recording: " + what + " '" + path + "'");
+}
+
+void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+bool get_varint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = uint8_t(*p++);
+        v |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Appends the nonzero words of a sequence as runs. Words arrive in
+// increasing index order.
+class RunWriter {
+public:
+    explicit RunWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    void add(size_t index, uint64_t word) {
+        if (!word) return;
+        if (count_ && index != start_ + count_) flush();
+        if (!count_) start_ = index;
+        words_[count_++] = word;
+        if (count_ == kMaxRun) flush();
+    }
+
+    void flush() {
+        if (!count_) return;
+        put_varint(out_, start_ - next_);
+        put_varint(out_, count_);
+        size_t at = out_.size();
+        out_.resize(at + count_ * sizeof(uint64_t));
+        std::memcpy(&out_[at], words_, count_ * sizeof(uint64_t));
+        next_ = start_ + count_;
+        count_ = 0;
+    }
+
+private:
+    static constexpr size_t kMaxRun = 64;
+    std::vector<uint8_t>& out_;
+    uint64_t words_[kMaxRun];
+    size_t start_ = 0, count_ = 0, next_ = 0;
+};
+
+Grid header_grid(const detail::MappedFile& file, const std::string& path) {
+    Header header;
+    if (file.size() < sizeof(header)) fail("not a recording:", path);
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) fail("not a recording:", path);
+    if (header.byte_order != kByteOrder || header.version != kVersion)
+        fail("unsupported recording version in", path);
+    if (header.birth >> 9 || header.survive >> 9) fail("bad rule in", path);
+    // A grid the file's deltas could not index is refused before it is
+    // allocated.
+    if (header.width > (uint64_t(1) << 32) || header.height > (uint64_t(1) << 32))
+        fail("bad size in", path);
+    Grid grid(size_t(header.width), size_t(header.height));
+    if (grid.words_per_row() != header.words_per_row) fail("bad row stride in", path);
+    Rule rule;
+    rule.birth = header.birth;
+    rule.survive = header.survive;
+    grid.set_rule(rule);
+    return grid;
+}
+
+} // namespace
+
+Recorder::Recorder(const std::string& path, const Grid& grid, size_t keyframe_interval)
+    : path_(path),
+      grid_(&grid),
+      width_(grid.width()),
+      height_(grid.height()),
+      interval_(std::max<size_t>(keyframe_interval, 1)) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) fail("cannot create", path);
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrder;
+    header.width = grid.width();
+    header.height = grid.height();
+    header.words_per_row = grid.words_per_row();
+    header.birth = grid.rule().birth;
+    header.survive = grid.rule().survive;
+    header.keyframe_interval = interval_;
+    try {
+        if (std::fwrite(&header, sizeof(header), 1, file_) != 1) fail("cannot write", path_);
+        bytes_ = sizeof(header);
+        write_keyframe(grid);
+    } catch (...) {
+        std::fclose(file_);
+        throw;
+    }
+}
+
+Recorder::~Recorder() {
+    try {
+        close();
+    } catch (const std::runtime_error&) {
+    }
+}
+
+void Recorder::close() {
+    if (!file_) return;
+    std::FILE* file = file_;
+    file_ = nullptr;
+    if (std::fclose(file) != 0) fail("cannot write", path_);
+}
+
+void Recorder::record(const Grid& grid) {
+    if (!file_) return;
+    if (grid.width() != width_ || grid.height() != height_)
+        throw std::invalid_argument("recording: grid size differs from '" + path_ + "'");
+    if (&grid != grid_) {
+        // Its change stamps mean nothing against the last record.
+        grid_ = &grid;
+        write_keyframe(grid);
+        return;
+    }
+    uint64_t generation = grid.generation();
+    if (generation <= last_generation_ || generation - last_keyframe_ >= interval_)
+        write_keyframe(grid);
+    else
+        write_delta(grid);
+}
+
+void Recorder::write_keyframe(const Grid& grid) {
+    payload_.clear();
+    RunWriter runs(payload_);
+    const uint64_t* words = grid.data();
+    for (size_t i = 0; i < grid.data_size(); ++i) runs.add(i, words[i]);
+    runs.flush();
+    prev_.assign(words, words + grid.data_size());
+    write_record(kKeyframe, grid.generation());
+    last_keyframe_ = grid.generation();
+    // A reader sees at least every keyframe of a run that is cut short.
+    if (std::fflush(file_) != 0) fail("cannot write", path_);
+    seen_ = grid.change_count();
+}
+
+// Only tiles stamped since the last record are compared, in word order:
+// tile row by tile row, each row across its changed tiles.
+void Recorder::write_delta(const Grid& grid) {
+    payload_.clear();
+    RunWriter runs(payload_);
+    const uint64_t* words = grid.data();
+    const size_t stride = grid.words_per_row();
+    std::vector<size_t> dirty;
+    for (size_t ty = 0; ty < grid.tiles_y(); ++ty) {
+        dirty.clear();
+        for (size_t tx = 0; tx < grid.tiles_x(); ++tx)
+            if (grid.tile_changed_since(ty * grid.tiles_x() + tx, seen_)) dirty.push_back(tx);
+        if (dirty.empty()) continue;
+        size_t end = std::min(grid.height(), (ty + 1) * Grid::kTileRows);
+        for (size_t y = ty * Grid::kTileRows; y < end; ++y) {
+            for (size_t tx : dirty) {
+                size_t i = y * stride + tx * Grid::kTileWords;
+                for (size_t j = i; j < i + Grid::kTileWords; ++j) {
+                    runs.add(j, words[j] ^ prev_[j]);
+                    prev_[j] = words[j];
+                }
+            }
+        }
+    }
+    runs.flush();
+    write_record(kDelta, grid.generation());
+    seen_ = grid.change_count();
+}
+
+void Recorder::write_record(uint8_t kind, uint64_t generation) {
+    std::vector<uint8_t> head;
+    head.push_back(kind);
+    put_varint(head, generation);
+    put_varint(head, payload_.size());
+    if (std::fwrite(head.data(), 1, head.size(), file_) != head.size() ||
+        (!payload_.empty() &&
+         std::fwrite(payload_.data(), 1, payload_.size(), file_) != payload_.size()))
+        fail("cannot write", path_);
+    bytes_ += head.size() + payload_.size();
+    last_generation_ = generation;
+}
+
+Player::Player(const std::string& path)
+    : file_(new detail::MappedFile(path, "recording")),
+      path_(path),
+      grid_(header_grid(*file_, path)) {
+    const char* p = file_->data() + sizeof(Header);
+    const char* end = file_->data() + file_->size();
+    while (p < end) {
+        uint8_t kind = uint8_t(*p++);
+        uint64_t generation, size;
+        if (kind != kKeyframe && kind != kDelta) fail("corrupt record in", path);
+        if (!get_varint(p, end, generation) || !get_varint(p, end, size) ||
+            size > uint64_t(end - p))
+            break;  // cut short
+        // Going back in time starts the recording over; only the last
+        // stretch plays.
+        if (!records_.empty() && generation <= records_.back().generation) {
+            if (kind != kKeyframe) fail("corrupt record in", path);
+            records_.clear();
+            keyframes_.clear();
+        }
+        if (records_.empty() && kind != kKeyframe) fail("corrupt record in", path);
+        if (kind == kKeyframe) keyframes_.push_back(records_.size());
+        records_.push_back(Record{generation, size_t(p - file_->data()), size_t(size),
+                                  kind == kKeyframe});
+        p += size;
+    }
+    if (records_.empty()) fail("empty recording", path);
+    apply(records_[0]);
+    grid_.touch();
+    grid_.set_generation(size_t(records_[0].generation));
+}
+
+Player::~Player() = default;
+
+const Grid& Player::seek(uint64_t generation) {
+    if (generation < first_generation())
+        throw std::out_of_range("recording starts at generation " +
+                                std::to_string(first_generation()));
+    auto it = std::upper_bound(records_.begin(), records_.end(), generation,
+                               [](uint64_t g, const Record& r) { return g < r.generation; });
+    size_t target = size_t(it - records_.begin()) - 1;
+    size_t key = *(std::upper_bound(keyframes_.begin(), keyframes_.end(), target) - 1);
+    if (target == at_) return grid_;
+    size_t from = at_ < target && at_ >= key ? at_ + 1 : key;
+    for (size_t i = from; i <= target; ++i) apply(records_[i]);
+    at_ = target;
+    grid_.touch();
+    grid_.set_generation(size_t(records_[target].generation));
+    return grid_;
+}
+
+void Player::apply(const Record& record) {
+    uint64_t* words = grid_.mutable_data();
+    const size_t count = grid_.data_size();
+    if (record.keyframe) std::fill(words, words + count, 0);
+    const char* p = file_->data() + record.offset;
+    const char* end = p + record.size;
+    size_t next = 0;
+    while (p < end) {
+        uint64_t gap, run;
+        if (!get_varint(p, end, gap) || !get_varint(p, end, run) || gap > count - next ||
+            run > count - next - gap || run > uint64_t(end - p) / sizeof(uint64_t))
+            fail("corrupt record in", path_);
+        next += size_t(gap);
+        for (size_t i = 0; i < run; ++i, p += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            words[next + i] ^= word;
+        }
+        next += size_t(run);
+    }
+}
+
+} // namespace gol
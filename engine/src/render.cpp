@@ -0,0 +1,156 @@
+#include "gol/render.hpp"
+#include "gol/grid.hpp"
+#include "bits.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace gol {
+
+namespace {
+
+// UTF-8 for four characters at once, indexed by four top bits | four
+// bottom bits << 4. Entries are padded so they can be copied whole.
+struct Quad {
+    char bytes[16];
+    uint8_t size;
+};
+
+struct QuadTable {
+    Quad quads[256];
+    QuadTable() {
+        static const char* const glyphs[4] = {" ", "\xE2\x96\x80", "\xE2\x96\x84", "\xE2\x96\x88"};
+        for (unsigned i = 0; i < 256; ++i) {
+            Quad& q = quads[i];
+            q = Quad{};
+            for (unsigned k = 0; k < 4; ++k) {
+                const char* g = glyphs[(i >> k & 1) | (i >> (k + 4) & 1) << 1];
+                for (; *g; ++g) q.bytes[q.size++] = *g;
+            }
+        }
+    }
+};
+
+// 64 bits of a packed row from bit `begin` on; words at or past `words`
+// read as zero.
+uint64_t bits_from(const uint64_t* row, size_t begin, size_t words) {
+    size_t word = begin / 64, shift = begin % 64;
+    uint64_t v = row[word] >> shift;
+    if (shift && word + 1 < words) v |= row[word + 1] << (64 - shift);
+    return v;
+}
+
+// One bit per character for the blocks of rows [row, row + zoom) from
+// column x on: whole rows OR-ed together a word at a time, then either
+// shifted down to bit 0 (zoom 1) or reduced a block at a time.
+class Lit {
+public:
+    Lit(const Grid& grid, size_t x, size_t w, size_t zoom)
+        : grid_(grid), x_(x), zoom_(zoom), merged_(grid.words_per_row() + 1),
+          bits_((w + 63) / 64) {
+        // Columns [x, end) are on the board.
+        end_ = x >= grid.width() ? x
+               : w && zoom > (grid.width() - x) / w ? grid.width()
+                                                   : x + w * zoom;
+    }
+
+    const std::vector<uint64_t>& row(size_t y) {
+        std::fill(bits_.begin(), bits_.end(), 0);
+        if (y >= grid_.height() || x_ >= end_) return bits_;
+        const size_t stride = grid_.words_per_row();
+        const size_t first = x_ / 64, last = (end_ - 1) / 64;
+        const uint64_t* src = grid_.data() + y * stride;
+        if (zoom_ > 1) {
+            size_t rows = std::min(zoom_, grid_.height() - y);
+            std::copy(src + first, src + last + 1, merged_.begin() + first);
+            for (size_t r = 1; r < rows; ++r) {
+                const uint64_t* next = src + r * stride;
+                for (size_t i = first; i <= last; ++i) merged_[i] |= next[i];
+            }
+            if (zoom_ > 64) {
+                for (size_t c = 0, begin = x_; begin < end_; ++c, begin += zoom_)
+                    if (detail::any_bits(merged_.data(), begin, std::min(begin + zoom_, end_)))
+                        bits_[c / 64] |= uint64_t(1) << (c % 64);
+                return bits_;
+            }
+            // Smear each bit over the zoom - 1 bits below it, doubling the
+            // reach each pass, so bit p ends up the OR of cells [p, p + zoom)
+            // and each block is one bit test. Blocks stop at end_, so the
+            // spare zero word past `last` is all they read beyond it.
+            merged_[last + 1] = 0;
+            for (size_t reach = 1; reach < zoom_;) {
+                size_t k = std::min(reach, zoom_ - reach);
+                for (size_t i = first; i <= last; ++i)
+                    merged_[i] |= merged_[i] >> k | merged_[i + 1] << (64 - k);
+                reach += k;
+            }
+            const uint64_t* smeared = merged_.data();
+            uint64_t word = 0;
+            size_t c = 0;
+            for (size_t begin = x_; begin < end_; ++c, begin += zoom_) {
+                word |= (smeared[begin / 64] >> (begin % 64) & 1) << (c % 64);
+                if (c % 64 == 63) {
+                    bits_[c / 64] = word;
+                    word = 0;
+                }
+            }
+            if (c % 64) bits_[c / 64] = word;
+            return bits_;
+        }
+        const size_t n = end_ - x_;
+        for (size_t i = 0; i * 64 < n; ++i) {
+            uint64_t v = bits_from(src, x_ + i * 64, stride);
+            if (n - i * 64 < 64) v &= (uint64_t(1) << (n - i * 64)) - 1;
+            bits_[i] = v;
+        }
+        return bits_;
+    }
+
+private:
+    const Grid& grid_;
+    size_t x_, zoom_, end_;
+    std::vector<uint64_t> merged_;
+    std::vector<uint64_t> bits_;
+};
+
+} // namespace
+
+std::vector<std::string> render_halfblock(const Grid& grid, size_t x, size_t y, size_t w,
+                                          size_t h, size_t zoom) {
+    if (zoom == 0) throw std::invalid_argument("render_halfblock: zoom must be at least 1");
+    static const QuadTable table;
+    std::vector<std::string> lines(h);
+    Lit lit(grid, x, w, zoom);
+    std::vector<uint64_t> top;
+    for (size_t line = 0; line < h; ++line) {
+        // Rows past the bottom (or past size_t) render blank.
+        size_t step = 2 * zoom;
+        size_t row = line > (SIZE_MAX - y) / step ? SIZE_MAX : y + line * step;
+        top = lit.row(row);
+        const std::vector<uint64_t>& bottom = lit.row(row > SIZE_MAX - zoom ? SIZE_MAX : row + zoom);
+        // Written a quad at a time into room for the worst case; bits past
+        // w are zero, so a last partial quad only adds spaces to cut off.
+        std::string& out = lines[line];
+        out.resize(w * 3 + 16);
+        char* p = &out[0];
+        for (size_t i = 0; i < top.size(); ++i) {
+            size_t count = std::min<size_t>(64, w - i * 64);
+            uint64_t t = top[i], b = bottom[i];
+            if (!(t | b)) {
+                std::fill(p, p + count, ' ');
+                p += count;
+                continue;
+            }
+            for (size_t k = 0; k < count; k += 4) {
+                const Quad& q = table.quads[(t >> k & 0xF) | (b >> k & 0xF) << 4];
+                std::memcpy(p, q.bytes, sizeof(q.bytes));
+                p += k + 4 <= count ? q.size : q.size - (k + 4 - count);
+            }
+        }
+        out.resize(size_t(p - out.data()));
+    }
+    return lines;
+}
+
+} // namespace gol
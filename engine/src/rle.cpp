@@ -1,126 +1,754 @@
 #include "gol/rle.hpp"
 #include "gol/grid.hpp"
-#include <sstream>
-#include <cctype>
+#include "gol/mapped_grid.hpp"
+#include "gol/plane.hpp"
+#include "gol/rule.hpp"
+#include "bits.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GOL_RLE_POSIX 1
+#endif
 
 namespace gol {
 
-RLEPattern parse_rle(const std::string& rle) {
-    RLEPattern pattern;
-    std::istringstream stream(rle);
-    std::string line;
-    std::string body;
+RLEError::RLEError(const std::string& what, size_t line, size_t column)
+    : std::invalid_argument("RLE line " + std::to_string(line) + ", column " +
+                            std::to_string(column) + ": " + what),
+      line_(line), column_(column) {}
+
+namespace {
 
-    while (std::getline(stream, line)) {
-        // Remove \r if present
-        if (!line.empty() && line.back() == '\r')
-            line.pop_back();
+// Header and #N lines longer than this are rejected / truncated.
+constexpr size_t kMaxLineText = 4096;
+// Run counts are capped so cell coordinates cannot overflow.
+constexpr uint64_t kMaxRun = uint64_t(1) << 48;
+// Mapped files are decoded in slices, each released once decoded, so the
+// resident size stays flat however large the file is.
+constexpr size_t kMapSlice = size_t(16) << 20;
+constexpr size_t kReadChunk = size_t(1) << 20;
+// Bodies at least this large decode on the thread pool, in chunks of at
+// least kMinChunk bytes.
+constexpr size_t kParallelBody = size_t(1) << 20;
+constexpr size_t kMinChunk = size_t(256) << 10;
 
-        if (line.empty()) continue;
+// Receives what RLEDecoder reads.
+class RLESink {
+public:
+    virtual ~RLESink() = default;
+    // Called once, before the first run; alive_cells is left empty. May
+    // throw std::invalid_argument to refuse the rule, which the decoder
+    // reports as an RLEError where the rule is written.
+    virtual void header(const RLEPattern& info) { (void)info; }
+    // `length` live cells from (x, y) rightwards.
+    virtual void run(size_t x, size_t y, size_t length) = 0;
+};
 
-        // Comment lines
-        if (line[0] == '#') {
-            if (line.size() > 2 && line[1] == 'N') {
-                pattern.name = line.substr(3);
+// Push parser for RLE: feed() takes the text in pieces split anywhere and
+// finish() ends it. Runs go to the sink as they are decoded; only the
+// header or #N line being read is buffered.
+class RLEDecoder {
+public:
+    explicit RLEDecoder(RLESink& sink) : sink_(sink) {}
+    // Picks up a body right after one of its '$' tokens: row y, x = 0, at
+    // the given line and column of the text.
+    RLEDecoder(RLESink& sink, size_t line, size_t column, size_t y)
+        : sink_(sink), state_(Line::Body), line_(line), column_(column),
+          started_(true), y_(y) {}
+
+    // Returns how much of data was read: all of it, unless stop_at_body()
+    // is set and the body starts, which is left unread.
+    size_t feed(const char* data, size_t size) {
+        for (size_t i = 0; i < size && !done_; ++i) {
+            char c = data[i];
+            if (c == '\n') {
+                end_line();
+                ++line_;
+                column_ = 0;
+                continue;
+            }
+            ++column_;
+            switch (state_) {
+            case Line::Start:
+                if (c == ' ' || c == '\t' || c == '\r') break;
+                if (c == '#') {
+                    state_ = Line::Comment;
+                } else if (c == 'x' && !started_) {
+                    state_ = Line::Header;
+                    text_ = "x";
+                } else if (stop_at_body_) {
+                    --column_;
+                    return i;
+                } else {
+                    state_ = Line::Body;
+                    body(c);
+                }
+                break;
+            case Line::Comment:
+                if (column_ == 2 && c == 'N') state_ = Line::Name;
+                break;
+            case Line::Name:
+                if (column_ == 3) text_.clear();  // the separator after #N
+                else if (text_.size() < kMaxLineText) text_ += c;
+                break;
+            case Line::Header:
+                if (text_.size() >= kMaxLineText) fail("header line too long");
+                text_ += c;
+                break;
+            case Line::Body:
+                body(c);
+                break;
             }
-            continue;
         }
+        return size;
+    }
 
-        // Header line: x = ..., y = ...
-        if (line[0] == 'x') {
-            size_t xpos = line.find("x");
-            size_t ypos = line.find("y");
-            if (xpos != std::string::npos && ypos != std::string::npos) {
-                // Parse x value
-                size_t eq1 = line.find('=', xpos);
-                if (eq1 != std::string::npos) {
-                    pattern.width = std::stoul(line.substr(eq1 + 1));
-                }
-                // Parse y value
-                size_t eq2 = line.find('=', ypos);
-                if (eq2 != std::string::npos) {
-                    pattern.height = std::stoul(line.substr(eq2 + 1));
+    void finish() {
+        end_line();
+        begin_body();
+    }
+
+    void stop_at_body(bool stop) { stop_at_body_ = stop; }
+    // Hands the header to the sink, as the first body character would.
+    void start_body() { begin_body(); }
+
+    size_t line() const { return line_; }
+    size_t column() const { return column_; }
+
+private:
+    enum class Line { Start, Comment, Name, Header, Body };
+
+    [[noreturn]] void fail(const std::string& what) const { fail_at(what, column_); }
+    [[noreturn]] void fail_at(const std::string& what, size_t column) const {
+        throw RLEError(what, line_, column);
+    }
+
+    void end_line() {
+        if (state_ == Line::Header) {
+            parse_header();
+        } else if (state_ == Line::Name) {
+            if (!text_.empty() && text_.back() == '\r') text_.pop_back();
+            info_.name = text_;
+        }
+        state_ = Line::Start;
+    }
+
+    // "x = 3, y = 3, rule = B3/S23": fields in any order, unknown ones
+    // skipped, x and y required.
+    void parse_header() {
+        bool have_x = false, have_y = false;
+        size_t pos = 0;
+        while (pos < text_.size()) {
+            size_t end = std::min(text_.find(',', pos), text_.size());
+            size_t eq = text_.find('=', pos);
+            if (eq >= end) fail_at("expected 'key = value'", pos + 1);
+            std::string key = trim(text_.substr(pos, eq - pos));
+            size_t value_at = text_.find_first_not_of(" \t", eq + 1);
+            std::string value = trim(text_.substr(eq + 1, end - eq - 1));
+            size_t column = (value_at < end ? value_at : eq) + 1;
+            if (key == "x" || key == "y") {
+                if (value.empty() || value.size() > 15 ||
+                    value.find_first_not_of("0123456789") != std::string::npos)
+                    fail_at("expected a size, got '" + value + "'", column);
+                if (key == "x") {
+                    info_.width = std::stoull(value);
+                    have_x = true;
+                } else {
+                    info_.height = std::stoull(value);
+                    have_y = true;
                 }
+            } else if (key == "rule") {
+                // Kept as written; only a sink that applies it checks it.
+                info_.rule = value;
+                rule_line_ = line_;
+                rule_column_ = column;
             }
-            continue;
+            pos = end + 1;
+        }
+        if (!have_x || !have_y) fail_at("header needs both x and y", 1);
+    }
+
+    static std::string trim(const std::string& s) {
+        size_t begin = s.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) return std::string();
+        return s.substr(begin, s.find_last_not_of(" \t\r") - begin + 1);
+    }
+
+    void begin_body() {
+        if (started_) return;
+        started_ = true;
+        try {
+            sink_.header(info_);
+        } catch (const RLEError&) {
+            throw;
+        } catch (const std::invalid_argument&) {
+            throw RLEError("unsupported rule '" + info_.rule + "'", rule_line_, rule_column_);
         }
+    }
 
-        body += line;
+    void body(char c) {
+        begin_body();
+        if (c >= '0' && c <= '9') {
+            run_ = run_ * 10 + uint64_t(c - '0');
+            if (run_ > kMaxRun) fail("run count too large");
+            return;
+        }
+        if (c == ' ' || c == '\t' || c == '\r') return;
+        size_t n = run_ ? size_t(run_) : 1;
+        run_ = 0;
+        switch (c) {
+        case 'b': case '.':
+            x_ += n;
+            break;
+        case 'o': case 'A':
+            sink_.run(x_, y_, n);
+            x_ += n;
+            break;
+        case '$':
+            y_ += n;
+            x_ = 0;
+            break;
+        case '!':
+            done_ = true;
+            break;
+        default:
+            fail(std::string("unexpected character '") + c + "'");
+        }
     }
 
-    // Parse RLE body
-    size_t cx = 0, cy = 0;
-    size_t run = 0;
+    RLESink& sink_;
+    RLEPattern info_;
+    Line state_ = Line::Start;
+    std::string text_;  // header or #N line being read
+    size_t line_ = 1;
+    size_t column_ = 0;
+    size_t rule_line_ = 0;  // where the header's rule is written
+    size_t rule_column_ = 0;
+    bool started_ = false;  // header delivered to the sink
+    bool done_ = false;     // '!' seen; the rest is ignored
+    bool stop_at_body_ = false;
+    uint64_t run_ = 0;
+    size_t x_ = 0;
+    size_t y_ = 0;
+};
+
+void decode_string(const std::string& rle, RLESink& sink) {
+    RLEDecoder decoder(sink);
+    decoder.feed(rle.data(), rle.size());
+    decoder.finish();
+}
+
+// Where the RLE writer's buffer goes.
+class RLEOut {
+public:
+    virtual ~RLEOut() = default;
+    virtual void write(const char* data, size_t size) = 0;
+};
 
-    for (char ch : body) {
-        if (ch == '!') break;
+struct StringOut : RLEOut {
+    std::string text;
+    void write(const char* data, size_t size) override { text.append(data, size); }
+};
 
-        if (std::isdigit(ch)) {
-            run = run * 10 + (ch - '0');
+struct FileOut : RLEOut {
+    std::FILE* file;
+    explicit FileOut(std::FILE* f) : file(f) {}
+    void write(const char* data, size_t size) override {
+        if (std::fwrite(data, 1, size, file) != size)
+            throw std::runtime_error("RLE: write failed");
+    }
+};
+
+#ifdef GOL_RLE_POSIX
+struct FdOut : RLEOut {
+    int fd;
+    explicit FdOut(int f) : fd(f) {}
+    void write(const char* data, size_t size) override {
+        while (size > 0) {
+            ssize_t put = ::write(fd, data, size);
+            if (put < 0 && errno == EINTR) continue;
+            if (put <= 0) throw std::runtime_error("RLE: write failed");
+            data += put;
+            size -= size_t(put);
+        }
+    }
+};
+#endif
+
+// Buffers output and wraps lines at kLineWidth without splitting a
+// "<count><tag>" token.
+class LineWriter {
+public:
+    static constexpr size_t kLineWidth = 70;
+
+    explicit LineWriter(RLEOut& out) : out_(out) {}
+
+    void text(const std::string& s) {
+        for (char c : s) {
+            reserve(1);
+            buffer_[used_++] = c;
+        }
+        column_ = 0;
+    }
+
+    void token(size_t count, char tag) {
+        char digits[24];
+        size_t n = 0;
+        if (count > 1) {
+            for (; count > 0; count /= 10) digits[n++] = char('0' + count % 10);
+        }
+        reserve(n + 2);
+        if (column_ + n + 1 > kLineWidth) {
+            buffer_[used_++] = '\n';
+            column_ = 0;
+        }
+        column_ += n + 1;
+        while (n > 0) buffer_[used_++] = digits[--n];
+        buffer_[used_++] = tag;
+    }
+
+    void flush() {
+        out_.write(buffer_, used_);
+        used_ = 0;
+    }
+
+private:
+    void reserve(size_t n) {
+        if (used_ + n > sizeof(buffer_)) flush();
+    }
+
+    RLEOut& out_;
+    char buffer_[size_t(64) << 10];
+    size_t used_ = 0;
+    size_t column_ = 0;
+};
+
+// Length of the run of `alive` cells starting at x, found a word at a time
+// with count-trailing-zeros. Cells past the width are dead.
+size_t run_length(const uint64_t* row, size_t x, size_t width, bool alive) {
+    size_t start = x;
+    while (x < width) {
+        // Ones where the run goes on; the shift brings in zeros, so the
+        // run stops at the end of the word unless it fills it.
+        uint64_t bits = alive ? row[x / 64] : ~row[x / 64];
+        bits >>= x % 64;
+        size_t room = 64 - x % 64;
+        size_t n = ~bits ? size_t(__builtin_ctzll(~bits)) : 64;
+        x += n;
+        if (n < room) break;
+    }
+    return std::min(x, width) - start;
+}
+
+// Rows are written run by run, trailing dead cells dropped; the ends of
+// blank rows pile up into one "n$", and trailing blank rows are dropped.
+// Grid and MappedGrid both lay their rows out the same way.
+template <class Board>
+void encode_rle(const Board& grid, RLEOut& out) {
+    std::unique_ptr<LineWriter> writer(new LineWriter(out));  // 64 KiB: off the stack
+    writer->text("x = " + std::to_string(grid.width()) + ", y = " +
+                 std::to_string(grid.height()) + ", rule = " + grid.rule().to_string() + "\n");
+    const size_t width = grid.width();
+    const size_t row_words = (width + 63) / 64;
+    size_t row_ends = 0;
+    for (size_t y = 0; y < grid.height(); ++y) {
+        const uint64_t* row = grid.data() + y * grid.words_per_row();
+        if (std::all_of(row, row + row_words, [](uint64_t w) { return w == 0; })) {
+            ++row_ends;
             continue;
         }
+        if (row_ends) writer->token(row_ends, '$');
+        for (size_t x = 0; x < width;) {
+            bool alive = (row[x / 64] >> (x % 64)) & 1;
+            size_t n = run_length(row, x, width, alive);
+            if (!alive && x + n == width) break;
+            writer->token(n, alive ? 'o' : 'b');
+            x += n;
+        }
+        row_ends = 1;
+    }
+    writer->token(1, '!');
+    writer->flush();
+}
+
+class PatternSink : public RLESink {
+public:
+    explicit PatternSink(RLEPattern& pattern) : pattern_(pattern) {}
+    void header(const RLEPattern& info) override { pattern_ = info; }
+    void run(size_t x, size_t y, size_t length) override {
+        for (size_t i = 0; i < length; ++i)
+            pattern_.alive_cells.emplace_back(x + i, y);
+    }
 
-        size_t count = (run == 0) ? 1 : run;
-        run = 0;
+private:
+    RLEPattern& pattern_;
+};
 
-        if (ch == 'b') {
-            cx += count;
-        } else if (ch == 'o') {
-            for (size_t i = 0; i < count; ++i) {
-                pattern.alive_cells.emplace_back(cx, cy);
-                ++cx;
+// Runs become whole-word fills of the grid's rows. In bulk mode the fills
+// bypass the grid's tile bookkeeping, so runs in different rows can come
+// from different threads, and finish() touches the whole grid instead.
+class GridSink : public RLESink {
+public:
+    GridSink(Grid* grid, size_t offset_x, size_t offset_y)
+        : grid_(grid), offset_x_(offset_x), offset_y_(offset_y) {}
+    void header(const RLEPattern& info) override {
+        if (!info.rule.empty()) grid_->set_rule(Rule::parse(info.rule));
+    }
+    void run(size_t x, size_t y, size_t length) override {
+        x += offset_x_;
+        y += offset_y_;
+        if (!bulk_) {
+            grid_->set_span(x, y, length, true);
+        } else if (x < grid_->width() && y < grid_->height()) {
+            detail::fill_bits(grid_->mutable_data() + y * grid_->words_per_row(), x,
+                              x + std::min(length, grid_->width() - x), true);
+        }
+    }
+
+    void set_bulk() { bulk_ = true; }
+    void finish() {
+        if (bulk_ && grid_) grid_->touch();
+    }
+
+protected:
+    Grid* grid_;
+
+private:
+    size_t offset_x_;
+    size_t offset_y_;
+    bool bulk_ = false;
+};
+
+class PlaneSink : public RLESink {
+public:
+    PlaneSink(Plane& plane, int64_t offset_x, int64_t offset_y)
+        : plane_(plane), offset_x_(offset_x), offset_y_(offset_y) {}
+    void header(const RLEPattern& info) override {
+        if (!info.rule.empty()) plane_.set_rule(Rule::parse(info.rule));
+    }
+    void run(size_t x, size_t y, size_t length) override {
+        for (size_t i = 0; i < length; ++i)
+            plane_.set_cell(offset_x_ + int64_t(x + i), offset_y_ + int64_t(y), true);
+    }
+
+private:
+    Plane& plane_;
+    int64_t offset_x_;
+    int64_t offset_y_;
+};
+
+// A grid sized from the header, then filled like GridSink.
+class NewGridSink : public GridSink {
+public:
+    NewGridSink() : GridSink(nullptr, 0, 0) {}
+    void header(const RLEPattern& info) override {
+        if (info.width == 0 || info.height == 0)
+            throw RLEError("missing 'x = ..., y = ...' header", 1, 1);
+        owned_.reset(new Grid(info.width, info.height));
+        grid_ = owned_.get();
+        GridSink::header(info);
+    }
+    Grid take() { return std::move(*owned_); }
+
+private:
+    std::unique_ptr<Grid> owned_;
+};
+
+// What a body chunk does to the decoder state, from a cheap scan that
+// reads no cells. The chunk is assumed to start inside a body line; the
+// first_line fields let a caller redo the sums for a chunk that turns out
+// to start inside a comment line.
+struct ChunkScan {
+    size_t newlines = 0;
+    size_t tail = 0;              // bytes after the last newline
+    uint64_t rows = 0;            // rows the '$' tokens advance
+    uint64_t first_line_rows = 0;  // the part of rows before the first newline
+    bool bang = false;            // '!' after the first newline
+    bool first_line_bang = false;
+    bool ends_in_comment = false;
+    bool bad = false;  // a character or count the decoder will reject
+};
+
+ChunkScan scan_chunk(const char* data, size_t size) {
+    ChunkScan scan;
+    enum { kStart, kComment, kBody } state = kBody;
+    uint64_t run = 0;
+    for (size_t i = 0; i < size; ++i) {
+        char c = data[i];
+        if (c == '\n') {
+            if (scan.newlines++ == 0) scan.first_line_rows = scan.rows;
+            scan.tail = 0;
+            state = kStart;
+            continue;
+        }
+        ++scan.tail;
+        if (state == kComment) continue;
+        if (c == ' ' || c == '\t' || c == '\r') continue;
+        if (state == kStart && c == '#') {
+            state = kComment;
+            continue;
+        }
+        state = kBody;
+        if (c >= '0' && c <= '9') {
+            run = std::min(run * 10 + uint64_t(c - '0'), kMaxRun + 1);
+            scan.bad |= run > kMaxRun;
+        } else {
+            if (c == '$') scan.rows += run ? run : 1;
+            else if (c != 'b' && c != '.' && c != 'o' && c != 'A' && c != '!') scan.bad = true;
+            run = 0;
+            if (c == '!') {
+                if (scan.newlines) {
+                    scan.bang = true;
+                    return scan;
+                }
+                // Only ends the body if the chunk does start in one.
+                scan.first_line_bang = true;
+                state = kComment;
             }
-        } else if (ch == '$') {
-            cy += count;
-            cx = 0;
         }
     }
+    if (scan.newlines == 0) scan.first_line_rows = scan.rows;
+    scan.ends_in_comment = state == kComment;
+    return scan;
+}
 
-    return pattern;
+// Drops the whole pages inside [begin, begin + size) of a file mapping.
+void release_pages(const char* begin, size_t size) {
+#ifdef GOL_RLE_POSIX
+    uintptr_t page = uintptr_t(::sysconf(_SC_PAGESIZE));
+    uintptr_t from = (uintptr_t(begin) + page - 1) / page * page;
+    uintptr_t to = (uintptr_t(begin) + size) / page * page;
+    if (from < to) ::madvise(reinterpret_cast<void*>(from), to - from, MADV_DONTNEED);
+#else
+    (void)begin;
+    (void)size;
+#endif
 }
 
-std::string to_rle(const Grid& grid) {
-    std::ostringstream out;
-    out << "x = " << grid.width() << ", y = " << grid.height() << "\n";
+// The sequential path: mapped files go in kMapSlice slices, each released
+// once decoded.
+void decode_rest(RLEDecoder& decoder, const char* data, size_t size, bool release) {
+    decoder.stop_at_body(false);
+    for (size_t at = 0; at < size; at += kMapSlice) {
+        size_t len = std::min(kMapSlice, size - at);
+        decoder.feed(data + at, len);
+        if (release) release_pages(data + at, len);
+    }
+    decoder.finish();
+}
 
-    for (size_t y = 0; y < grid.height(); ++y) {
-        size_t run = 0;
-        char last = 0;
+// Decodes a whole RLE text held in memory into a grid. Large bodies are cut
+// right after '$' tokens, so every chunk starts a row at x = 0; scans of
+// the chunks give the row each one starts at, and then the chunks decode
+// concurrently into disjoint rows. Cells, errors and their positions come
+// out as from one sequential pass. `release` drops each chunk's pages of a
+// file mapping once it is decoded.
+void decode_grid(const char* data, size_t size, GridSink& sink, bool release = false) {
+    RLEDecoder decoder(sink);
+    decoder.stop_at_body(true);
+    size_t body = decoder.feed(data, size);
+    detail::ThreadPool& pool = detail::ThreadPool::instance();
+    size_t chunks = std::min(pool.size() * 4, (size - body) / kMinChunk);
+    if (size - body < kParallelBody || pool.size() < 2 || chunks < 2) {
+        decode_rest(decoder, data + body, size - body, release);
+        return;
+    }
+
+    std::vector<size_t> cuts{body};
+    for (size_t k = 1; k < chunks; ++k) {
+        size_t at = std::max(body + (size - body) * k / chunks, cuts.back());
+        const void* dollar = std::memchr(data + at, '$', size - at);
+        if (!dollar) break;
+        size_t cut = size_t(static_cast<const char*>(dollar) - data) + 1;
+        if (cut > cuts.back()) cuts.push_back(cut);
+    }
+    if (cuts.back() < size) cuts.push_back(size);
+    chunks = cuts.size() - 1;
+
+    std::vector<ChunkScan> scans(chunks);
+    pool.parallel_for(chunks, [&](size_t i, size_t) {
+        scans[i] = scan_chunk(data + cuts[i], cuts[i + 1] - cuts[i]);
+    });
+
+    // Where each chunk starts: row, line and column. A cut that lands in a
+    // comment line would also have to carry a pending run count, so such
+    // rare files take the sequential path.
+    struct Start {
+        size_t y, line, column;
+    };
+    std::vector<Start> starts(chunks);
+    starts[0] = {0, decoder.line(), decoder.column()};
+    for (size_t i = 0; i + 1 < chunks; ++i) {
+        const ChunkScan& scan = scans[i];
+        // Nothing past the first '!' or error is decoded.
+        if (scan.bang || scan.first_line_bang || scan.bad) {
+            chunks = i + 1;
+            break;
+        }
+        if (scan.ends_in_comment) {
+            decode_rest(decoder, data + body, size - body, release);
+            return;
+        }
+        starts[i + 1].y = size_t(std::min<uint64_t>(starts[i].y + scan.rows, kMaxRun));
+        starts[i + 1].line = starts[i].line + scan.newlines;
+        starts[i + 1].column =
+            scan.newlines ? scan.tail : starts[i].column + (cuts[i + 1] - cuts[i]);
+    }
 
-        for (size_t x = 0; x < grid.width(); ++x) {
-            char ch = grid.get_cell(x, y) ? 'o' : 'b';
-            if (ch == last) {
-                ++run;
+    decoder.stop_at_body(false);
+    decoder.start_body();
+    sink.set_bulk();
+    std::vector<std::exception_ptr> errors(chunks);
+    pool.parallel_for(chunks, [&](size_t i, size_t) {
+        const char* begin = data + cuts[i];
+        size_t len = cuts[i + 1] - cuts[i];
+        try {
+            if (i == 0) {
+                decoder.feed(begin, len);
             } else {
-                if (last != 0) {
-                    if (run > 1) out << run;
-                    out << last;
-                }
-                last = ch;
-                run = 1;
+                RLEDecoder part(sink, starts[i].line, starts[i].column, starts[i].y);
+                part.feed(begin, len);
             }
+        } catch (...) {
+            errors[i] = std::current_exception();
         }
+        if (release) release_pages(begin, len);
+    });
+    sink.finish();
+    for (const std::exception_ptr& error : errors)
+        if (error) std::rethrow_exception(error);
+}
 
-        // Write trailing alive cells (skip trailing dead)
-        if (last == 'o') {
-            if (run > 1) out << run;
-            out << last;
+// Regular files are mapped and decoded by decode_grid; other files (and
+// other platforms) are read in chunks.
+void decode_file(const std::string& path, GridSink& sink) {
+#ifdef GOL_RLE_POSIX
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("RLE: cannot open '" + path + "'");
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t size = size_t(st.st_size);
+        void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            ::close(fd);
+            struct Unmap {
+                void* map;
+                size_t size;
+                ~Unmap() { ::munmap(map, size); }
+            } unmap{map, size};
+            ::madvise(map, size, MADV_SEQUENTIAL);
+            decode_grid(static_cast<const char*>(map), size, sink, true);
+            return;
         }
-
-        if (y < grid.height() - 1) {
-            out << '$';
+    }
+    RLEDecoder decoder(sink);
+    std::vector<char> chunk(kReadChunk);
+    for (;;) {
+        ssize_t got = ::read(fd, chunk.data(), chunk.size());
+        if (got < 0) {
+            ::close(fd);
+            throw std::runtime_error("RLE: cannot read '" + path + "'");
+        }
+        if (got == 0) break;
+        try {
+            decoder.feed(chunk.data(), size_t(got));
+        } catch (...) {
+            ::close(fd);
+            throw;
         }
     }
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("RLE: cannot open '" + path + "'");
+    RLEDecoder decoder(sink);
+    std::vector<char> chunk(kReadChunk);
+    while (in) {
+        in.read(chunk.data(), std::streamsize(chunk.size()));
+        decoder.feed(chunk.data(), size_t(in.gcount()));
+    }
+#endif
+    decoder.finish();
+}
+
+template <class Board>
+void save_file(const Board& grid, const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) throw std::runtime_error("RLE: cannot create '" + path + "'");
+    FileOut out{file};
+    try {
+        encode_rle(grid, out);
+    } catch (...) {
+        std::fclose(file);
+        throw;
+    }
+    if (std::fclose(file) != 0)
+        throw std::runtime_error("RLE: cannot write '" + path + "'");
+}
+
+} // namespace
 
-    out << '!';
-    return out.str();
+RLEPattern parse_rle(const std::string& rle) {
+    RLEPattern pattern;
+    PatternSink sink(pattern);
+    decode_string(rle, sink);
+    return pattern;
 }
 
+std::string to_rle(const Grid& grid) {
+    StringOut out;
+    encode_rle(grid, out);
+    return std::move(out.text);
+}
+
+std::string to_rle(const MappedGrid& grid) {
+    StringOut out;
+    encode_rle(grid, out);
+    return std::move(out.text);
+}
+
+void save_rle_file(const Grid& grid, const std::string& path) { save_file(grid, path); }
+
+void save_rle_file(const MappedGrid& grid, const std::string& path) { save_file(grid, path); }
+
+#ifdef GOL_RLE_POSIX
+void write_rle(const Grid& grid, int fd) {
+    FdOut out{fd};
+    encode_rle(grid, out);
+}
+#endif
+
 void load_rle(Grid& grid, const std::string& rle, size_t offset_x, size_t offset_y) {
-    RLEPattern pattern = parse_rle(rle);
-    for (auto& [x, y] : pattern.alive_cells) {
-        grid.set_cell(offset_x + x, offset_y + y, true);
-    }
+    GridSink sink(&grid, offset_x, offset_y);
+    decode_grid(rle.data(), rle.size(), sink);
+}
+
+void load_rle(Plane& plane, const std::string& rle, int64_t offset_x, int64_t offset_y) {
+    PlaneSink sink(plane, offset_x, offset_y);
+    decode_string(rle, sink);
+}
+
+void load_rle_file(Grid& grid, const std::string& path, size_t offset_x, size_t offset_y) {
+    GridSink sink(&grid, offset_x, offset_y);
+    decode_file(path, sink);
+}
+
+Grid read_rle_file(const std::string& path) {
+    NewGridSink sink;
+    decode_file(path, sink);
+    return sink.take();
 }
 
 } // namespace gol
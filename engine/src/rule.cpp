@@ -0,0 +1,90 @@
+#include "gol/rule.hpp"
+#include <cctype>
+#include <stdexcept>
+
+namespace gol {
+
+namespace {
+
+struct NamedRule {
+    const char* name;
+    const char* rule;
+};
+
+constexpr NamedRule kNamedRules[] = {
+    {"life", "B3/S23"},
+    {"highlife", "B36/S23"},
+    {"seeds", "B2/S"},
+    {"dayandnight", "B3678/S34678"},
+};
+
+[[noreturn]] void bad_rule(const std::string& text) {
+    throw std::invalid_argument("invalid rule: '" + text + "'");
+}
+
+// Neighbor counts in text[begin, end) as a bit mask.
+uint16_t parse_counts(const std::string& text, size_t begin, size_t end,
+                      const std::string& whole) {
+    uint16_t mask = 0;
+    for (size_t i = begin; i < end; ++i) {
+        char c = text[i];
+        if (c < '0' || c > '8') bad_rule(whole);
+        mask |= uint16_t(1u << (c - '0'));
+    }
+    return mask;
+}
+
+} // namespace
+
+Rule Rule::parse(const std::string& text) {
+    std::string s;
+    for (char c : text.substr(0, text.find(':'))) {
+        if (!std::isspace(static_cast<unsigned char>(c)))
+            s += char(std::tolower(static_cast<unsigned char>(c)));
+    }
+    for (const NamedRule& named : kNamedRules) {
+        if (s == named.name) return parse(named.rule);
+    }
+
+    size_t slash = s.find('/');
+    if (s.empty() || slash == std::string::npos || s.find('/', slash + 1) != std::string::npos)
+        bad_rule(text);
+
+    Rule rule;
+    if (s.find_first_of("bs") == std::string::npos) {
+        rule.survive = parse_counts(s, 0, slash, text);
+        rule.birth = parse_counts(s, slash + 1, s.size(), text);
+        return rule;
+    }
+
+    // Each part is a letter followed by its counts.
+    bool seen_b = false, seen_s = false;
+    for (size_t begin : {size_t(0), slash + 1}) {
+        size_t end = begin == 0 ? slash : s.size();
+        if (begin == end) bad_rule(text);
+        char letter = s[begin];
+        uint16_t counts = parse_counts(s, begin + 1, end, text);
+        if (letter == 'b' && !seen_b) {
+            rule.birth = counts;
+            seen_b = true;
+        } else if (letter == 's' && !seen_s) {
+            rule.survive = counts;
+            seen_s = true;
+        } else {
+            bad_rule(text);
+        }
+    }
+    return rule;
+}
+
+std::string Rule::to_string() const {
+    std::string s = "B";
+    for (int n = 0; n <= 8; ++n)
+        if (birth >> n & 1) s += char('0' + n);
+    s += "/S";
+    for (int n = 0; n <= 8; ++n)
+        if (survive >> n & 1) s += char('0' + n);
+    return s;
+}
+
+} // namespace gol
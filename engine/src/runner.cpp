@@ -0,0 +1,272 @@
+#include "gol/runner.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace gol {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+// Generations per step_n call as fast as possible start at one and adapt
+// so each call takes about one publish interval.
+constexpr size_t kMaxChunk = size_t(1) << 20;
+
+} // namespace
+
+SimulationRunner::Snapshot::Snapshot(Snapshot&& other) noexcept
+    : runner_(other.runner_), grid_(other.grid_), readers_(other.readers_) {
+    other.runner_ = nullptr;
+    other.grid_ = nullptr;
+    other.readers_ = nullptr;
+}
+
+SimulationRunner::Snapshot& SimulationRunner::Snapshot::operator=(Snapshot&& other) noexcept {
+    if (this != &other) {
+        release();
+        std::swap(runner_, other.runner_);
+        std::swap(grid_, other.grid_);
+        std::swap(readers_, other.readers_);
+    }
+    return *this;
+}
+
+void SimulationRunner::Snapshot::release() {
+    if (readers_ && readers_->fetch_sub(1) == 1) runner_->slot_freed();
+    runner_ = nullptr;
+    grid_ = nullptr;
+    readers_ = nullptr;
+}
+
+SimulationRunner::SimulationRunner(Grid grid, double rate, bool paused)
+    : grid_(std::move(grid)),
+      published_generation_(grid_.generation()),
+      paused_(paused),
+      rate_(std::max(rate, 0.0)) {
+    for (auto& slot : slots_) slot.reset(new Slot(grid_));
+    thread_ = std::thread([this] { run(); });
+}
+
+SimulationRunner::~SimulationRunner() {
+    if (thread_.joinable()) stop();
+}
+
+void SimulationRunner::pause() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = true;
+    pending_ = 0;
+    wake_.notify_one();
+}
+
+void SimulationRunner::resume() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = false;
+    idle_ = false;
+    repace_ = true;
+    wake_.notify_one();
+}
+
+bool SimulationRunner::paused() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return paused_;
+}
+
+void SimulationRunner::step(size_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!paused_) return;
+    pending_ += n;
+    idle_ = false;
+    repace_ = true;
+    wake_.notify_one();
+}
+
+void SimulationRunner::set_rate(double rate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rate_ = std::max(rate, 0.0);
+    repace_ = true;
+    wake_.notify_one();
+}
+
+double SimulationRunner::rate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rate_;
+}
+
+// A slot is only written while it is neither the latest nor held. A reader
+// counts itself in before checking that its slot is still the latest, so
+// either the stepper sees the count or the reader sees the slot replaced
+// and backs off.
+SimulationRunner::Snapshot SimulationRunner::snapshot() const {
+    for (;;) {
+        int i = latest_.load();
+        Slot& slot = *slots_[i];
+        slot.readers.fetch_add(1);
+        if (latest_.load() == i) return Snapshot(this, &slot.grid, &slot.readers);
+        if (slot.readers.fetch_sub(1) == 1) slot_freed();
+    }
+}
+
+// A failed publish() leaves want_slot_ set, so either it sees the slot free
+// or the reader freeing it sees the flag.
+void SimulationRunner::slot_freed() const {
+    if (!want_slot_.exchange(false)) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_.notify_one();
+}
+
+bool SimulationRunner::publish() {
+    want_slot_.store(true);
+    const int latest = latest_.load();
+    for (int i = 0; i < 3; ++i) {
+        if (i == latest || slots_[i]->readers.load() != 0) continue;
+        want_slot_.store(false);
+        slots_[i]->grid.copy_state_from(grid_);
+        latest_.store(i);
+        published_generation_.store(grid_.generation());
+        std::lock_guard<std::mutex> lock(mutex_);
+        published_.notify_all();
+        return true;
+    }
+    return false;
+}
+
+SimulationRunner::Snapshot SimulationRunner::wait_for(uint64_t generation) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    published_.wait(lock, [&] {
+        return published_generation_.load() >= generation || idle_ || stopped_;
+    });
+    lock.unlock();
+    return snapshot();
+}
+
+void SimulationRunner::edit(const std::function<void(Grid&)>& fn) {
+    Edit edit{&fn, nullptr};
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) throw std::logic_error("SimulationRunner: edit after stop");
+    edits_.push_back(&edit);
+    wake_.notify_one();
+    published_.wait(lock, [&] { return edit.done; });
+    if (edit.error) std::rethrow_exception(edit.error);
+}
+
+Grid SimulationRunner::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        wake_.notify_one();
+    }
+    if (thread_.joinable()) thread_.join();
+    return std::move(grid_);
+}
+
+void SimulationRunner::run() {
+    const auto publish_interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1 / kPublishHz));
+    size_t chunk = 1;
+    Clock::time_point last_publish = Clock::now();
+    bool unpublished = false;
+    // Paced runs count generations from pace_start; the rate is measured
+    // over windows from window_start.
+    Clock::time_point pace_start, window_start = Clock::now();
+    uint64_t paced = 0, window = 0;
+    // A copy is waiting and a reader has since let a slot go.
+    auto slot_free = [&] { return unpublished && !want_slot_.load(); };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        while (!edits_.empty()) {
+            Edit* edit = edits_.front();
+            edits_.pop_front();
+            lock.unlock();
+            try {
+                (*edit->fn)(grid_);
+            } catch (...) {
+                edit->error = std::current_exception();
+            }
+            // The editor is waiting, so it is done even if the copy has to
+            // wait for a slot.
+            unpublished = !publish();
+            lock.lock();
+            edit->done = true;
+            published_.notify_all();
+        }
+        if (stopping_) break;
+
+        if (paused_ && pending_ == 0) {
+            gens_per_second_.store(0);
+            if (unpublished) {
+                lock.unlock();
+                unpublished = !publish();
+                lock.lock();
+            }
+            idle_ = true;
+            published_.notify_all();
+            wake_.wait(lock, [&] {
+                return stopping_ || !edits_.empty() || !paused_ || pending_ > 0 || slot_free();
+            });
+            idle_ = false;
+            window_start = Clock::now();
+            window = 0;
+            continue;
+        }
+
+        size_t n = paused_ ? std::min(chunk, pending_) : chunk;
+        if (repace_) {
+            pace_start = Clock::now();
+            paced = 0;
+            repace_ = false;
+        }
+        if (rate_ > 0) {
+            // Generations due by now; with none due, sleep until the next.
+            double due = seconds(Clock::now() - pace_start) * rate_ - double(paced);
+            if (due < 1) {
+                if (unpublished) {
+                    lock.unlock();
+                    unpublished = !publish();
+                    last_publish = Clock::now();
+                    lock.lock();
+                    if (!unpublished) continue;
+                }
+                auto wake_at = pace_start + std::chrono::duration_cast<Clock::duration>(
+                                                std::chrono::duration<double>((paced + 1) / rate_));
+                wake_.wait_until(lock, wake_at, [&] {
+                    return stopping_ || !edits_.empty() || repace_ || (paused_ && pending_ == 0) ||
+                           slot_free();
+                });
+                continue;
+            }
+            n = std::min(n, size_t(due));
+        }
+        lock.unlock();
+
+        Clock::time_point start = Clock::now();
+        grid_.step_n(n);
+        Clock::time_point end = Clock::now();
+        if (end - start < publish_interval / 2)
+            chunk = std::min(chunk * 2, kMaxChunk);
+        else if (end - start > publish_interval && chunk > 1)
+            chunk /= 2;
+        paced += n;
+        window += n;
+        unpublished = true;
+        if (end - window_start >= std::chrono::milliseconds(500)) {
+            gens_per_second_.store(double(window) / seconds(end - window_start));
+            window_start = end;
+            window = 0;
+        }
+        if (end - last_publish >= publish_interval) {
+            unpublished = !publish();
+            last_publish = end;
+        }
+
+        lock.lock();
+        if (paused_) pending_ -= std::min(pending_, n);
+    }
+    stopped_ = true;
+    published_.notify_all();
+}
+
+} // namespace gol
@@ -0,0 +1,221 @@
+#include "gol/snapshot.hpp"
+#include "gol/grid.hpp"
+#include "mapped_file.hpp"
+#include "snapshot_format.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace gol {
+
+namespace {
+
+using namespace detail::snapshot;
+
+size_t page_round(size_t n) { return (n + kPage - 1) / kPage * kPage; }
+
+[[noreturn]] void fail(const std::string& what, const std::string& path) {
+    throw std::runtime_error("snapshot: " + what + " '" + path + "'");
+}
+
+// Tiles run row-major over the grid, each kTileRows rows of kTileWords
+// words (fewer rows in the last tile row).
+struct Tiles {
+    size_t x, y, words_per_row, height;
+    size_t count() const { return x * y; }
+    size_t rows(size_t ty) const { return std::min(Grid::kTileRows, height - ty * Grid::kTileRows); }
+    size_t words(size_t tile) const { return rows(tile / x) * Grid::kTileWords; }
+    size_t first_word(size_t tile) const {
+        return (tile / x) * Grid::kTileRows * words_per_row + (tile % x) * Grid::kTileWords;
+    }
+};
+
+void write_all(std::FILE* file, const void* data, size_t size, const std::string& path) {
+    if (size && std::fwrite(data, 1, size, file) != size) fail("cannot write", path);
+}
+
+void pad_to(std::FILE* file, size_t& at, size_t to, const std::string& path) {
+    static const char zeros[kPage] = {};
+    while (at < to) {
+        size_t n = std::min(to - at, kPage);
+        write_all(file, zeros, n, path);
+        at += n;
+    }
+}
+
+} // namespace
+
+namespace detail {
+namespace snapshot {
+
+void check_header(const Header& header, size_t file_size, const std::string& path) {
+    if (file_size < kPage || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+        fail("not a snapshot:", path);
+    if (header.byte_order != kByteOrder || header.version != kVersion ||
+        (header.flags & ~kSparse) != 0)
+        fail("unsupported snapshot version in", path);
+    if (header.birth >> 9 || header.survive >> 9) fail("bad rule in", path);
+
+    if (header.words_per_row < (header.width + 63) / 64 ||
+        header.words_per_row % Grid::kTileWords != 0 || header.words_per_row > (uint64_t(1) << 40))
+        fail("bad row stride in", path);
+    // Checked before a grid is allocated, so a bad header cannot ask for
+    // more memory than the file could fill.
+    const size_t stride = size_t(header.words_per_row);
+    const size_t available = (file_size - kPage) / sizeof(uint64_t);
+    const size_t tiles_y = size_t((header.height + Grid::kTileRows - 1) / Grid::kTileRows);
+    const size_t mask_words = (stride / Grid::kTileWords * tiles_y + 63) / 64;
+    if (header.flags & kSparse ? available < mask_words
+                               : stride && available / stride < header.height)
+        fail("truncated", path);
+}
+
+} // namespace snapshot
+} // namespace detail
+
+void save_snapshot(const Grid& grid, const std::string& path, bool sparse) {
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrder;
+    header.width = grid.width();
+    header.height = grid.height();
+    header.generation = grid.generation();
+    header.words_per_row = grid.words_per_row();
+    header.birth = grid.rule().birth;
+    header.survive = grid.rule().survive;
+    header.flags = sparse ? kSparse : 0;
+
+    const uint64_t* words = grid.data();
+    Tiles tiles{grid.tiles_x(), grid.tiles_y(), grid.words_per_row(), grid.height()};
+    std::vector<uint64_t> present;
+    if (sparse) {
+        present.assign((tiles.count() + 63) / 64, 0);
+        for (size_t t = 0; t < tiles.count(); ++t) {
+            const uint64_t* w = words + tiles.first_word(t);
+            for (size_t r = 0; r < tiles.rows(t / tiles.x); ++r, w += tiles.words_per_row) {
+                if (std::any_of(w, w + Grid::kTileWords, [](uint64_t v) { return v != 0; })) {
+                    present[t / 64] |= uint64_t(1) << (t % 64);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::string temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (!file) fail("cannot create", temp);
+    try {
+        size_t at = 0;
+        write_all(file, &header, sizeof(header), temp);
+        at += sizeof(header);
+        pad_to(file, at, kPage, temp);
+        if (!sparse) {
+            write_all(file, words, grid.data_size() * sizeof(uint64_t), temp);
+        } else {
+            write_all(file, present.data(), present.size() * sizeof(uint64_t), temp);
+            at += present.size() * sizeof(uint64_t);
+            pad_to(file, at, page_round(at), temp);
+            for (size_t t = 0; t < tiles.count(); ++t) {
+                if (!(present[t / 64] >> (t % 64) & 1)) continue;
+                const uint64_t* w = words + tiles.first_word(t);
+                for (size_t r = 0; r < tiles.rows(t / tiles.x); ++r, w += tiles.words_per_row)
+                    write_all(file, w, Grid::kTileWords * sizeof(uint64_t), temp);
+            }
+        }
+        if (std::fflush(file) != 0) fail("cannot write", temp);
+#ifdef GOL_MAPPED_FILE_POSIX
+        ::fsync(::fileno(file));
+#endif
+    } catch (...) {
+        std::fclose(file);
+        std::remove(temp.c_str());
+        throw;
+    }
+    if (std::fclose(file) != 0 || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        fail("cannot write", path);
+    }
+}
+
+Grid load_snapshot(const std::string& path) {
+    detail::MappedFile file(path, "snapshot");
+    Header header;
+    if (file.size() < kPage) fail("not a snapshot:", path);
+    std::memcpy(&header, file.data(), sizeof(header));
+    check_header(header, file.size(), path);
+    const size_t stride = size_t(header.words_per_row);
+    const size_t available = (file.size() - kPage) / sizeof(uint64_t);
+    const size_t tiles_y = size_t((header.height + Grid::kTileRows - 1) / Grid::kTileRows);
+    const size_t mask_words = (stride / Grid::kTileWords * tiles_y + 63) / 64;
+
+    Grid grid(size_t(header.width), size_t(header.height));
+    Rule rule;
+    rule.birth = header.birth;
+    rule.survive = header.survive;
+    grid.set_rule(rule);
+    grid.set_generation(size_t(header.generation));
+
+    // Rows copy in at the grid's own stride; the stored stride may differ.
+    const size_t copy = std::min(stride, grid.words_per_row());
+    uint64_t* out = grid.mutable_data();
+    const char* payload = file.data() + kPage;
+    detail::ThreadPool& pool = detail::ThreadPool::instance();
+    // Whatever the file holds past the width is dropped, as the kernels
+    // need those bits clear.
+    const size_t row_words = (grid.width() + 63) / 64;
+    const uint64_t last_mask =
+        grid.width() % 64 ? (uint64_t(1) << (grid.width() % 64)) - 1 : ~uint64_t(0);
+    auto clean_rows = [&](size_t ty) {
+        size_t end = std::min(grid.height(), (ty + 1) * Grid::kTileRows);
+        for (size_t y = ty * Grid::kTileRows; y < end; ++y) {
+            uint64_t* row = out + y * grid.words_per_row();
+            if (row_words) row[row_words - 1] &= last_mask;
+            std::fill(row + row_words, row + grid.words_per_row(), 0);
+        }
+    };
+
+    if (!(header.flags & kSparse)) {
+        pool.parallel_for(grid.tiles_y(), [&](size_t ty, size_t) {
+            size_t end = std::min(grid.height(), (ty + 1) * Grid::kTileRows);
+            for (size_t y = ty * Grid::kTileRows; y < end; ++y)
+                std::memcpy(out + y * grid.words_per_row(), payload + y * stride * sizeof(uint64_t),
+                            copy * sizeof(uint64_t));
+            clean_rows(ty);
+        });
+    } else {
+        Tiles tiles{stride / Grid::kTileWords, grid.tiles_y(), stride, grid.height()};
+        std::vector<uint64_t> present(mask_words);
+        std::memcpy(present.data(), payload, mask_words * sizeof(uint64_t));
+        // Offsets of the stored tiles, in words from the first.
+        std::vector<size_t> offset(tiles.count() + 1, 0);
+        for (size_t t = 0; t < tiles.count(); ++t)
+            offset[t + 1] = offset[t] + (present[t / 64] >> (t % 64) & 1 ? tiles.words(t) : 0);
+        size_t first = page_round(kPage + mask_words * sizeof(uint64_t)) - kPage;
+        if (available - std::min(available, first / sizeof(uint64_t)) < offset.back())
+            fail("truncated", path);
+        const uint64_t* stored = reinterpret_cast<const uint64_t*>(payload + first);
+        pool.parallel_for(tiles.y, [&](size_t ty, size_t) {
+            for (size_t t = ty * tiles.x; t < (ty + 1) * tiles.x; ++t) {
+                if (offset[t] == offset[t + 1]) continue;
+                size_t tx = t % tiles.x;
+                if (tx * Grid::kTileWords >= copy) continue;
+                size_t words = std::min(Grid::kTileWords, copy - tx * Grid::kTileWords);
+                for (size_t r = 0; r < tiles.rows(ty); ++r) {
+                    size_t y = ty * Grid::kTileRows + r;
+                    std::memcpy(out + y * grid.words_per_row() + tx * Grid::kTileWords,
+                                stored + offset[t] + r * Grid::kTileWords,
+                                words * sizeof(uint64_t));
+                }
+            }
+            clean_rows(ty);
+        });
+    }
+    grid.touch();
+    return grid;
+}
+
+} // namespace gol
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gol {
+namespace detail {
+namespace snapshot {
+
+// The snapshot file layout, shared by snapshot.cpp and MappedGrid.
+constexpr char kMagic[8] = {'G', 'O', 'L', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrder = 0x01020304;  // reads back swapped on the other endianness
+constexpr uint32_t kSparse = 1;
+// Payloads start on a page boundary, so the mapped words are as aligned as
+// the grid's own.
+constexpr size_t kPage = 4096;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t width;
+    uint64_t height;
+    uint64_t generation;
+    uint64_t words_per_row;
+    uint16_t birth;
+    uint16_t survive;
+    uint32_t flags;
+    uint64_t reserved;
+};
+static_assert(sizeof(Header) == 64, "snapshot header layout");
+
+// Throws std::runtime_error naming `path` unless the header is one this
+// build reads and a file of `file_size` bytes holds all it describes.
+void check_header(const Header& header, size_t file_size, const std::string& path);
+
+} // namespace snapshot
+} // namespace detail
+} // namespace gol
@@ -0,0 +1,182 @@
+#include "thread_pool.hpp"
+#include <cstdlib>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace gol {
+namespace detail {
+
+namespace {
+
+// Spins before a worker sleeps, so back-to-back small steps skip the
+// wake-up latency.
+constexpr int kSpinRounds = 256;
+
+thread_local bool t_in_pool = false;
+
+uint64_t pack(uint64_t begin, uint64_t end) { return begin | end << 32; }
+size_t span_begin(uint64_t span) { return size_t(span & 0xFFFFFFFFu); }
+size_t span_end(uint64_t span) { return size_t(span >> 32); }
+
+size_t default_threads() {
+    if (const char* env = std::getenv("GOL_THREADS")) {
+        long n = std::strtol(env, nullptr, 10);
+        if (n > 0) return size_t(n);
+    }
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw ? hw : 1;
+}
+
+void pin_to(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+} // namespace
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() {
+    start(default_threads());
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::start(size_t threads) {
+    shares_.reset(new Share[threads]);
+    if (threads < 2) return;
+    stopping_ = false;
+    threads_.reserve(threads);
+    uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+    for (size_t id = 0; id < threads; ++id)
+        threads_.emplace_back(&ThreadPool::worker_main, this, id, epoch);
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_) t.join();
+    threads_.clear();
+}
+
+void ThreadPool::resize(size_t threads) {
+    std::lock_guard<std::mutex> guard(run_mutex_);
+    stop();
+    start(threads ? threads : default_threads());
+}
+
+void ThreadPool::set_affinity(const std::vector<int>& cpus) {
+    std::lock_guard<std::mutex> guard(run_mutex_);
+    size_t threads = size();
+    stop();
+    cpus_ = cpus;
+    start(threads);
+}
+
+std::vector<int> ThreadPool::affinity() const {
+    return cpus_;
+}
+
+void ThreadPool::worker_main(size_t id, uint64_t seen) {
+    t_in_pool = true;
+    if (!cpus_.empty())
+        pin_to(cpus_[id % cpus_.size()]);
+
+    for (;;) {
+        for (int spin = 0; spin < kSpinRounds && epoch_.load(std::memory_order_acquire) == seen;
+             ++spin)
+            std::this_thread::yield();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] {
+                return stopping_ || epoch_.load(std::memory_order_acquire) != seen;
+            });
+            if (stopping_) return;
+            seen = epoch_.load(std::memory_order_acquire);
+        }
+
+        size_t index;
+        while (take(id, index))
+            task_(ctx_, index, id);
+
+        if (running_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_.notify_one();
+        }
+    }
+}
+
+bool ThreadPool::take(size_t self, size_t& index) {
+    // Front of our own share.
+    std::atomic<uint64_t>& own = shares_[self].span;
+    uint64_t span = own.load(std::memory_order_acquire);
+    while (span_begin(span) < span_end(span)) {
+        if (own.compare_exchange_weak(span, pack(span_begin(span) + 1, span_end(span)),
+                                      std::memory_order_acq_rel)) {
+            index = span_begin(span);
+            return true;
+        }
+    }
+    // Back of someone else's.
+    size_t n = threads_.size();
+    for (size_t step = 1; step < n; ++step) {
+        std::atomic<uint64_t>& victim = shares_[(self + step) % n].span;
+        span = victim.load(std::memory_order_acquire);
+        while (span_begin(span) < span_end(span)) {
+            if (victim.compare_exchange_weak(span, pack(span_begin(span), span_end(span) - 1),
+                                             std::memory_order_acq_rel)) {
+                index = span_end(span) - 1;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t count, Task task, void* ctx) {
+    if (count == 0) return;
+    if (t_in_pool || count == 1) {
+        for (size_t i = 0; i < count; ++i) task(ctx, i, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(run_mutex_);
+    size_t n = threads_.size();
+    if (n == 0) {
+        for (size_t i = 0; i < count; ++i) task(ctx, i, 0);
+        return;
+    }
+    for (size_t w = 0; w < n; ++w)
+        shares_[w].span.store(pack(count * w / n, count * (w + 1) / n), std::memory_order_relaxed);
+    task_ = task;
+    ctx_ = ctx;
+    running_.store(n, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        epoch_.fetch_add(1, std::memory_order_release);
+    }
+    wake_.notify_all();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return running_.load(std::memory_order_acquire) == 0; });
+}
+
+} // namespace detail
+} // namespace gol
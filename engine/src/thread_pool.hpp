@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace gol {
+namespace detail {
+
+// Engine-wide pool of persistent worker threads.
+//
+// parallel_for(count, fn) hands worker w the contiguous share
+// [count * w / n, count * (w + 1) / n) of the indices. A worker takes its own
+// indices from the front of its share and, once that is empty, steals from
+// the back of the others'. With the same count, the same worker always
+// owns the same share, so buffers first written through parallel_for stay
+// on that worker's NUMA node.
+class ThreadPool {
+public:
+    static ThreadPool& instance();
+
+    ~ThreadPool();
+
+    // Number of workers: fn sees worker indices below this.
+    size_t size() const { return threads_.empty() ? 1 : threads_.size(); }
+
+    // 0 picks GOL_THREADS from the environment, else one per CPU. With one
+    // thread, work runs inline on the caller.
+    void resize(size_t threads);
+    // Pins worker i to cpus[i % cpus.size()]; an empty list unpins.
+    void set_affinity(const std::vector<int>& cpus);
+    std::vector<int> affinity() const;
+
+    // Calls fn(index, worker) for every index in [0, count) and returns when
+    // all calls are done. Calls from inside a task run inline as worker 0.
+    template <class Fn>
+    void parallel_for(size_t count, Fn&& fn) {
+        using F = std::remove_reference_t<Fn>;
+        run(count, [](void* ctx, size_t i, size_t worker) { (*static_cast<F*>(ctx))(i, worker); },
+            const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+private:
+    using Task = void (*)(void* ctx, size_t index, size_t worker);
+
+    // A share of indices packed as begin | end << 32, so owner and thieves
+    // can both update it with one compare-and-swap.
+    struct alignas(64) Share {
+        std::atomic<uint64_t> span{0};
+    };
+
+    ThreadPool();
+    void start(size_t threads);
+    void stop();
+    void worker_main(size_t id, uint64_t seen);
+    void run(size_t count, Task task, void* ctx);
+    bool take(size_t self, size_t& index);
+
+    std::vector<std::thread> threads_;
+    std::unique_ptr<Share[]> shares_;
+    std::vector<int> cpus_;
+
+    std::mutex run_mutex_;  // one parallel_for (or reconfiguration) at a time
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::atomic<uint64_t> epoch_{0};
+    std::atomic<size_t> running_{0};
+    bool stopping_ = false;
+    Task task_ = nullptr;
+    void* ctx_ = nullptr;
+};
+
+} // namespace detail
+} // namespace gol
@@ -15,8 +15,18 @@ except ImportError:
 class GameCLI:
     def __init__(self, use_json: bool = False):
         self.grid = None
+        self.recorder = None
+        self.runner = None
         self.use_json = use_json
 
+    # While a run is going, the grid belongs to the runner; reads see its
+    # latest published snapshot.
+    READS_WHILE_RUNNING = {"run", "stop", "state", "state_ascii", "state_region",
+                           "population", "kernel", "memory"}
+
+    def board(self):
+        return self.runner.snapshot() if self.runner else self.grid
+
     def respond(self, status: str, data=None, message: str = ""):
         if self.use_json:
             resp = {"status": status}
@@ -50,8 +60,39 @@ class GameCLI:
             self.error("gol_engine not available — build with pybind11")
             return True
 
+        if self.runner and cmd not in self.READS_WHILE_RUNNING:
+            self.error("running — use 'stop' first")
+            return True
+
         try:
-            if cmd == "new":
+            if cmd == "run":
+                # run [rate]: steps in the background, [rate] generations a
+                # second or as fast as it goes; "run" again changes the rate
+                if not self.grid and not self.runner:
+                    self.error("no grid")
+                    return True
+                # The runner steps a copy, which the recorder would not see
+                if self.recorder:
+                    self.error("recording — use 'record off' first")
+                    return True
+                rate = float(parts[1]) if len(parts) > 1 else 0.0
+                if self.runner:
+                    self.runner.rate = rate
+                else:
+                    self.runner = gol_engine.SimulationRunner(self.grid, rate)
+                    self.grid = None
+                self.respond("ok")
+
+            elif cmd == "stop":
+                if not self.runner:
+                    self.error("not running")
+                    return True
+                self.grid = self.runner.stop()
+                self.runner = None
+                msg = f"OK gen={self.grid.generation} pop={self.grid.population}"
+                self.respond("ok", {"gen": self.grid.generation, "pop": self.grid.population}, msg)
+
+            elif cmd == "new":
                 w = int(parts[1]) if len(parts) > 1 else 100
                 h = int(parts[2]) if len(parts) > 2 else 100
                 self.grid = gol_engine.Grid(w, h)
@@ -67,6 +108,85 @@ class GameCLI:
                 gol_engine.load_rle(self.grid, rle, x, y)
                 self.respond("ok")
 
+            elif cmd == "save":
+                # save <path> [sparse]: binary snapshot, generation and rule included
+                if not self.grid:
+                    self.error("no grid")
+                    return True
+                sparse = len(parts) > 2 and parts[2].lower() == "sparse"
+                gol_engine.save_snapshot(self.grid, parts[1], sparse)
+                self.respond("ok")
+
+            elif cmd == "load":
+                self.grid = gol_engine.load_snapshot(parts[1])
+                msg = f"OK gen={self.grid.generation} pop={self.grid.population}"
+                self.respond("ok", {"gen": self.grid.generation, "pop": self.grid.population}, msg)
+
+            elif cmd == "checkpoint":
+                # checkpoint <path> <every>: step saves a snapshot
+                # every <every> generations; "checkpoint off" stops it
+                if not self.grid:
+                    self.error("no grid")
+                    return True
+                if parts[1].lower() == "off":
+                    self.grid.set_checkpoint("", 0)
+                else:
+                    self.grid.set_checkpoint(parts[1], int(parts[2]))
+                self.respond("ok")
+
+            elif cmd == "record":
+                # record <path> [interval]: every step is appended to a
+                # recording, with a keyframe each <interval> generations;
+                # "record off" closes it
+                if not self.grid:
+                    self.error("no grid")
+                    return True
+                self.grid.set_recorder(None)
+                if self.recorder:
+                    self.recorder.close()
+                    self.recorder = None
+                if parts[1].lower() != "off":
+                    interval = int(parts[2]) if len(parts) > 2 else 1024
+                    self.recorder = gol_engine.Recorder(parts[1], self.grid, interval)
+                    self.grid.set_recorder(self.recorder)
+                self.respond("ok")
+
+            elif cmd == "play":
+                # play <path> <gen>: the recorded board at generation <gen>
+                player = gol_engine.Player(parts[1])
+                gen = int(parts[2]) if len(parts) > 2 else player.last_generation
+                self.grid = player.seek(gen)
+                msg = f"OK gen={self.grid.generation} pop={self.grid.population}"
+                self.respond("ok", {"gen": self.grid.generation, "pop": self.grid.population}, msg)
+
+            elif cmd == "load_mc":
+                # load_mc <path> [x] [y]: a Macrocell file, its top-left
+                # live cell at (x, y); without a grid, one fitted to it
+                with open(parts[1]) as f:
+                    mc = gol_engine.parse_macrocell(f.read())
+                # A plane rather than HashLife, which only takes Life trees
+                plane = gol_engine.Plane()
+                gol_engine.load_macrocell(plane, mc, 0, 0)
+                bx, by, bw, bh = plane.bounding_box()
+                pattern = plane.extract(bx, by, max(bw, 1), max(bh, 1))
+                if not self.grid:
+                    self.grid = pattern
+                else:
+                    x = int(parts[2]) if len(parts) > 2 else 0
+                    y = int(parts[3]) if len(parts) > 3 else 0
+                    self.grid.paste(pattern, x, y)
+                if mc.rule:
+                    self.grid.rule = mc.rule
+                self.respond("ok", {"pop": plane.population}, f"OK pop={plane.population}")
+
+            elif cmd == "save_mc":
+                if not self.grid:
+                    self.error("no grid")
+                    return True
+                with open(parts[1], "w") as f:
+                    f.write(gol_engine.to_macrocell(self.grid))
+                self.respond("ok")
+
             elif cmd == "step":
                 if not self.grid:
                     self.error("no grid")
@@ -76,28 +196,47 @@ class GameCLI:
                 msg = f"OK gen={self.grid.generation} pop={self.grid.population}"
                 self.respond("ok", {"gen": self.grid.generation, "pop": self.grid.population}, msg)
 
-            elif cmd == "state":
+            elif cmd == "stabilize":
                 if not self.grid:
                     self.error("no grid")
                     return True
-                packed = self.grid.to_numpy_packed()
+                max_gens = int(parts[1]) if len(parts) > 1 else 10000
+                max_period = int(parts[2]) if len(parts) > 2 else 1024
+                s = self.grid.run_until_stable(max_gens, max_period)
+                data = {"gen": self.grid.generation, "pop": self.grid.population,
+                        "settled": s.settled, "period": s.period, "start": s.start}
+                if s.settled:
+                    msg = (f"OK gen={self.grid.generation} pop={self.grid.population} "
+                           f"period={s.period} start={s.start}")
+                else:
+                    msg = f"OK gen={self.grid.generation} pop={self.grid.population} unsettled"
+                self.respond("ok", data, msg)
+
+            elif cmd == "state":
+                board = self.board()
+                if board is None:
+                    self.error("no grid")
+                    return True
+                packed = board.to_numpy_packed()
                 b64 = base64.b64encode(packed.tobytes()).decode()
                 self.respond("ok", b64, b64)
 
             elif cmd == "state_ascii":
-                if not self.grid:
+                board = self.board()
+                if board is None:
                     self.error("no grid")
                     return True
-                ascii_str = self.grid.to_ascii()
+                ascii_str = board.to_ascii()
                 self.respond("ok", ascii_str, ascii_str)
 
             elif cmd == "state_region":
-                if not self.grid:
+                board = self.board()
+                if board is None:
                     self.error("no grid")
                     return True
                 x, y = int(parts[1]), int(parts[2])
                 w, h = int(parts[3]), int(parts[4])
-                region = self.grid.to_ascii_region(x, y, w, h)
+                region = board.to_ascii_region(x, y, w, h)
                 self.respond("ok", region, region)
 
             elif cmd == "text":
@@ -113,20 +252,38 @@ class GameCLI:
                 self.respond("ok")
 
             elif cmd == "population":
-                if not self.grid:
+                board = self.board()
+                if board is None:
                     self.error("no grid")
                     return True
-                pop = self.grid.population
+                pop = board.population
                 self.respond("ok", pop, str(pop))
 
             elif cmd == "randomize":
                 if not self.grid:
                     self.error("no grid")
                     return True
+                # randomize [density] [C2|C4|D8]: optionally a symmetric soup
                 density = float(parts[1]) if len(parts) > 1 else 0.1
-                self.grid.randomize(density)
+                symmetry = gol_engine.Symmetry.NONE
+                if len(parts) > 2:
+                    symmetry = getattr(gol_engine.Symmetry, parts[2].upper())
+                self.grid.randomize(density, 0, symmetry)
                 self.respond("ok")
 
+            elif cmd == "kernel":
+                name = gol_engine.Grid.kernel_name()
+                self.respond("ok", name, name)
+
+            elif cmd == "memory":
+                # Grid storage: bytes mapped, pooled for reuse, on huge pages
+                s = gol_engine.arena_stats()
+                data = {"mapped": s.mapped, "pooled": s.pooled, "huge": s.huge,
+                        "heap": s.heap, "reused": s.reused}
+                mib = lambda n: f"{n / (1 << 20):.1f} MiB"
+                self.respond("ok", data, f"mapped {mib(s.mapped)} (pooled {mib(s.pooled)}, "
+                                         f"huge {mib(s.huge)}), heap {mib(s.heap)}")
+
             elif cmd == "reset":
                 if not self.grid:
                     self.error("no grid")
@@ -10,42 +10,66 @@ except ImportError:
 
 
 class ToolExecutor:
-    """Dispatches tool calls to Grid operations."""
+    """Dispatches tool calls to Grid operations, or through a SimulationRunner."""
 
-    def __init__(self, grid):
+    def __init__(self, grid, runner=None):
         self.grid = grid
+        self.runner = runner
         self._pattern_library = None
 
     def execute(self, name: str, args: dict) -> str:
+        if name == "fetch_pattern":
+            return self._fetch_pattern(args["name"])
+        if self.runner is None:
+            return self._execute(self.grid, name, args)
+        # With a runner stepping the grid, reads use its latest snapshot and
+        # everything else runs between its steps.
+        if name == "get_state":
+            with self.runner.snapshot() as snap:
+                return self._execute(snap, name, args)
+        if name == "new_grid":
+            self.runner.replace(gol_engine.Grid(args["width"], args["height"]))
+            return f"Created {args['width']}x{args['height']} grid"
+        result = []
+        self.runner.edit(lambda grid: result.append(self._execute(grid, name, args)))
+        return result[0]
+
+    def _execute(self, grid, name: str, args: dict) -> str:
         if name == "place_pattern":
-            gol_engine.load_rle(self.grid, args["rle"], args["x"], args["y"])
+            gol_engine.load_rle(grid, args["rle"], args["x"], args["y"])
             return f"Placed pattern at ({args['x']}, {args['y']})"
 
         elif name == "step":
             n = args.get("n", 1)
-            self.grid.step_n(n)
-            return f"Advanced {n} steps. Gen={self.grid.generation}, Pop={self.grid.population}"
+            grid.step_n(n)
+            return f"Advanced {n} steps. Gen={grid.generation}, Pop={grid.population}"
+
+        elif name == "run_until_stable":
+            max_gens = args.get("max_generations", 10000)
+            s = grid.run_until_stable(max_gens)
+            if s.settled:
+                return (f"Settled into period {s.period} from generation {s.start}. "
+                        f"Gen={grid.generation}, Pop={grid.population}")
+            return (f"Still changing after {max_gens} steps. "
+                    f"Gen={grid.generation}, Pop={grid.population}")
 
         elif name == "get_state":
-            w = min(self.grid.width, 80)
-            h = min(self.grid.height, 40)
-            return self.grid.to_ascii_region(0, 0, w, h)
+            w = min(grid.width, 80)
+            h = min(grid.height, 40)
+            return grid.to_ascii_region(0, 0, w, h)
 
         elif name == "place_text":
             pattern = gol_engine.text_to_pattern(args["text"])
-            self.grid.paste(pattern, args["x"], args["y"])
+            grid.paste(pattern, args["x"], args["y"])
             return f"Placed text '{args['text']}' at ({args['x']}, {args['y']})"
 
-        elif name == "fetch_pattern":
-            return self._fetch_pattern(args["name"])
-
         elif name == "new_grid":
             self.grid = gol_engine.Grid(args["width"], args["height"])
             return f"Created {args['width']}x{args['height']} grid"
 
         elif name == "randomize":
             density = args.get("density", 0.1)
-            self.grid.randomize(density)
+            grid.randomize(density)
             return f"Randomized with density {density}"
 
         return f"Unknown tool: {name}"
@@ -78,9 +102,9 @@ Help the user discover, create, and explore patterns. Be concise."""
 class LLMClient:
     """LLM client with tool use for controlling the Game of Life."""
 
-    def __init__(self, grid):
+    def __init__(self, grid, runner=None):
         self.grid = grid
-        self.executor = ToolExecutor(grid)
+        self.executor = ToolExecutor(grid, runner)
         self.config = get_config()
         self.provider = None
         self.available = False
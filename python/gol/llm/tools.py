@@ -24,6 +24,17 @@ TOOLS = [
             },
         },
     },
+    {
+        "name": "run_until_stable",
+        "description": "Advance the simulation until it dies, becomes static or starts repeating, "
+                       "up to a generation limit. Reports the period and where the cycle starts.",
+        "input_schema": {
+            "type": "object",
+            "properties": {
+                "max_generations": {"type": "integer", "description": "Generation limit (default 10000)", "default": 10000},
+            },
+        },
+    },
     {
         "name": "get_state",
         "description": "Get the current grid state as ASCII art (. for dead, # for alive).",
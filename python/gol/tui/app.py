@@ -36,6 +36,8 @@ class GameOfLifeApp(App):
         Binding("minus", "speed_down", "-Speed"),
         Binding("r", "reset", "Reset"),
         Binding("n", "new_grid", "New Grid"),
+        Binding("left_square_bracket", "zoom_in", "Zoom In"),
+        Binding("right_square_bracket", "zoom_out", "Zoom Out"),
         Binding("q", "quit", "Quit"),
         Binding("left", "scroll_left", "Scroll Left", show=False),
         Binding("right", "scroll_right", "Scroll Right", show=False),
@@ -50,7 +52,8 @@ class GameOfLifeApp(App):
         self._paused = False
         self._speed = 10.0  # steps per second
         self._timer = None
-        self._grid = None
+        self._runner = None
+        self._snapshot = None
         self._llm_client = None
 
     def compose(self) -> ComposeResult:
@@ -64,11 +67,11 @@ class GameOfLifeApp(App):
             self.notify("gol_engine not available — install with pip install -e .", severity="error")
             return
 
-        self._grid = gol_engine.Grid(self._grid_width, self._grid_height)
-        self._grid.randomize(0.1)
-
-        grid_widget = self.query_one("#grid-widget", GridWidget)
-        grid_widget.set_grid(self._grid)
+        grid = gol_engine.Grid(self._grid_width, self._grid_height)
+        grid.randomize(0.1)
+        self._runner = gol_engine.SimulationRunner(grid, self._speed)
+        self._snapshot = self._runner.snapshot()
+        self.query_one("#grid-widget", GridWidget).set_grid(self._snapshot)
 
         controls = self.query_one("#controls", ControlsBar)
         controls.grid_size = f"{self._grid_width}x{self._grid_height}"
@@ -89,74 +92,101 @@ class GameOfLifeApp(App):
     def _init_llm(self):
         try:
             from ..llm.client import LLMClient
-            self._llm_client = LLMClient(self._grid)
+            self._llm_client = LLMClient(None, self._runner)
             if self._llm_client.available:
                 chat_log = self.query_one("#chat-log", ChatLog)
                 chat_log.write(f"[green]AI connected: {self._llm_client.provider}[/green]")
         except Exception:
             pass
 
+    # The runner steps on its own thread at self._speed; the timer only
+    # picks up its latest snapshot and repaints what changed.
+    FRAME_RATE = 30
+
     def _start_timer(self):
         if self._timer:
             self._timer.stop()
-        interval = 1.0 / self._speed if self._speed > 0 else 1.0
-        self._timer = self.set_interval(interval, self._tick)
+        self._timer = self.set_interval(1.0 / self.FRAME_RATE, self._tick)
 
     def _tick(self):
-        if self._paused or self._grid is None:
+        if self._runner is None:
             return
-        self._grid.step()
-        self.query_one("#grid-widget", GridWidget).refresh()
+        self._snapshot = self._runner.snapshot()
+        widget = self.query_one("#grid-widget", GridWidget)
+        widget.show(self._snapshot)
+        widget.refresh_changed()
         self._update_controls()
 
     def _update_controls(self):
-        if self._grid is None:
+        if self._snapshot is None:
             return
         controls = self.query_one("#controls", ControlsBar)
-        controls.generation = self._grid.generation
-        controls.population = self._grid.population
+        controls.generation = self._snapshot.generation
+        controls.population = self._snapshot.population
         controls.paused = self._paused
 
     def action_toggle_pause(self):
+        if self._runner is None:
+            return
         self._paused = not self._paused
+        if self._paused:
+            self._runner.pause()
+        else:
+            self._runner.resume()
         self._update_controls()
 
     def action_single_step(self):
-        if self._grid is None:
+        if self._runner is None:
             return
         self._paused = True
-        self._grid.step()
-        self.query_one("#grid-widget", GridWidget).refresh()
-        self._update_controls()
+        self._runner.pause()
+        self._runner.step()
+        self._tick()
+
+    def _set_speed(self, speed: float):
+        self._speed = speed
+        self.query_one("#controls", ControlsBar).speed = speed
+        if self._runner is not None:
+            self._runner.rate = speed
 
     def action_speed_up(self):
-        self._speed = min(60.0, self._speed + 2)
-        controls = self.query_one("#controls", ControlsBar)
-        controls.speed = self._speed
-        self._start_timer()
+        self._set_speed(min(60.0, self._speed + 2))
 
     def action_speed_down(self):
-        self._speed = max(1.0, self._speed - 2)
-        controls = self.query_one("#controls", ControlsBar)
-        controls.speed = self._speed
-        self._start_timer()
+        self._set_speed(max(1.0, self._speed - 2))
 
     def action_reset(self):
-        if self._grid is None:
+        if self._runner is None:
             return
-        self._grid.clear()
-        self._grid.randomize(0.1)
-        self.query_one("#grid-widget", GridWidget).refresh()
+        self._runner.edit(lambda grid: (grid.clear(), grid.randomize(0.1)))
+        self._snapshot = self._runner.snapshot()
+        widget = self.query_one("#grid-widget", GridWidget)
+        widget.show(self._snapshot)
+        widget.refresh()
         self._update_controls()
 
     def action_new_grid(self):
-        if gol_engine is None:
+        if self._runner is None:
             return
-        self._grid = gol_engine.Grid(self._grid_width, self._grid_height)
-        self._grid.randomize(0.1)
-        self.query_one("#grid-widget", GridWidget).set_grid(self._grid)
+        grid = gol_engine.Grid(self._grid_width, self._grid_height)
+        grid.randomize(0.1)
+        self._runner.replace(grid)
+        self._snapshot = self._runner.snapshot()
+        self.query_one("#grid-widget", GridWidget).set_grid(self._snapshot)
         self._update_controls()
 
+    def on_unmount(self):
+        if self._runner is not None:
+            self._runner.stop()
+
+    def action_zoom_in(self):
+        widget = self.query_one("#grid-widget", GridWidget)
+        widget.set_zoom(widget.zoom // 2)
+
+    def action_zoom_out(self):
+        widget = self.query_one("#grid-widget", GridWidget)
+        widget.set_zoom(widget.zoom * 2)
+
     def action_scroll_left(self):
         self.query_one("#grid-widget", GridWidget).scroll_viewport(-5, 0)
 
@@ -192,9 +222,8 @@ class GameOfLifeApp(App):
         try:
             response = self._llm_client.chat(message)
             self.call_from_thread(chat_log.write, f"[bold green]AI:[/bold green] {response}")
-            # Refresh grid in case the AI modified it
+            # Tools went through the runner; the next tick shows their effect
             self.call_from_thread(self.query_one("#grid-widget", GridWidget).refresh)
-            self.call_from_thread(self._update_controls)
         except Exception as e:
             self.call_from_thread(chat_log.write, f"[red]Error: {e}[/red]")
 
@@ -1,5 +1,6 @@
 """Grid widget — renders Game of Life using unicode half-block characters."""
 
+from textual.geometry import Region
 from textual.widget import Widget
 from textual.reactive import reactive
 from textual.strip import Strip
@@ -19,6 +20,8 @@ class GridWidget(Widget):
     """Renders the GoL grid using half-block unicode chars.
 
     Each terminal row displays two grid rows, doubling vertical resolution.
+    Zoomed out, each character shows two zoom x zoom blocks instead, lit if
+    any cell in them is alive.
     """
 
     DEFAULT_CSS = """
@@ -31,45 +34,42 @@ class GridWidget(Widget):
 
     viewport_x: reactive[int] = reactive(0)
     viewport_y: reactive[int] = reactive(0)
+    zoom: reactive[int] = reactive(1)
 
     def __init__(self, grid=None, **kwargs):
         super().__init__(**kwargs)
         self.grid = grid
+        self._seen = grid.change_count if grid is not None else 0
 
     def set_grid(self, grid):
         self.grid = grid
+        self._seen = grid.change_count if grid is not None else 0
         self.viewport_x = 0
         self.viewport_y = 0
+        self.zoom = 1
+
+    def show(self, snapshot):
+        """Draw from a newer runner snapshot, releasing the last.
+
+        A board swapped in by SimulationRunner.replace, seen as a change
+        count gone back or a new size, is repainted in full.
+        """
+        previous, self.grid = self.grid, snapshot
+        replaced = previous is not None and (
+            snapshot.change_count < self._seen
+            or (snapshot.width, snapshot.height) != (previous.width, previous.height))
+        if previous is not None and previous is not snapshot and hasattr(previous, "release"):
+            previous.release()
+        if replaced:
+            self._seen = snapshot.change_count
+            self.scroll_viewport(0, 0)  # back inside the board, and a full refresh
 
     def _build_line(self, y: int) -> str:
-        """Build a string for terminal line y (representing 2 grid rows)."""
+        """Build a string for terminal line y (representing 2 * zoom grid rows)."""
         if self.grid is None:
             return ""
-
-        term_width = self.size.width
-        grid_y_top = self.viewport_y + y * 2
-        grid_y_bot = grid_y_top + 1
-
-        chars = []
-        for tx in range(term_width):
-            gx = self.viewport_x + tx
-            if gx >= self.grid.width:
-                chars.append(" ")
-                continue
-
-            top = self.grid.get_cell(gx, grid_y_top) if grid_y_top < self.grid.height else False
-            bot = self.grid.get_cell(gx, grid_y_bot) if grid_y_bot < self.grid.height else False
-
-            if top and bot:
-                chars.append("\u2588")  # █
-            elif top:
-                chars.append("\u2580")  # ▀
-            elif bot:
-                chars.append("\u2584")  # ▄
-            else:
-                chars.append(" ")
-
-        return "".join(chars)
+        top = self.viewport_y + y * 2 * self.zoom
+        return self.grid.render_halfblock(self.viewport_x, top, self.size.width, 1, self.zoom)[0]
 
     def render_line(self, y: int) -> Strip:
         """Called by Textual to render each line."""
@@ -79,9 +79,38 @@ class GridWidget(Widget):
         line_text = self._build_line(y)
         return Strip([Segment(line_text, ALIVE_STYLE)])
 
+    def refresh_changed(self):
+        """Repaint only the lines and columns over cells changed since the last call."""
+        if self.grid is None:
+            return
+        rects = self.grid.changed_since(self._seen)
+        self._seen = self.grid.change_count
+        z = self.zoom
+        width, height = self.size.width, self.size.height
+        regions = []
+        for x, y, w, h in rects:
+            left = max(0, (x - self.viewport_x) // z)
+            right = min(width, -(-(x + w - self.viewport_x) // z))
+            top = max(0, (y - self.viewport_y) // (2 * z))
+            bottom = min(height, -(-(y + h - self.viewport_y) // (2 * z)))
+            if left < right and top < bottom:
+                regions.append(Region(left, top, right - left, bottom - top))
+        if regions:
+            self.refresh(*regions)
+
     def scroll_viewport(self, dx: int, dy: int):
         if self.grid is None:
             return
-        self.viewport_x = max(0, min(self.viewport_x + dx, max(0, self.grid.width - self.size.width)))
-        self.viewport_y = max(0, min(self.viewport_y + dy, max(0, self.grid.height - self.size.height * 2)))
+        z = self.zoom
+        self.viewport_x = max(0, min(self.viewport_x + dx * z,
+                                     max(0, self.grid.width - self.size.width * z)))
+        self.viewport_y = max(0, min(self.viewport_y + dy * z,
+                                     max(0, self.grid.height - self.size.height * 2 * z)))
         self.refresh()
+
+    def set_zoom(self, zoom: int):
+        """Cells per character side, 1 to 64; the viewport stays in bounds."""
+        if self.grid is None:
+            return
+        self.zoom = max(1, min(64, zoom))
+        self.scroll_viewport(0, 0)
@@ -0,0 +1,87 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/arena.hpp"
+#include "gol/grid.hpp"
+#include <cstdint>
+#include <cstring>
+
+using namespace gol;
+
+TEST_CASE("Arena aligns blocks and reuses freed ones", "[arena]") {
+    Arena& arena = Arena::instance();
+    const HugePages mode = arena.huge_pages();
+    arena.set_huge_pages(HugePages::kAdvise);
+    const Arena::Stats before = arena.stats();
+
+    const size_t big = 3 * Arena::kHugePage + 100;
+    void* p = arena.allocate(big, 64);
+    REQUIRE(reinterpret_cast<uintptr_t>(p) % Arena::kHugePage == 0);
+    std::memset(p, 0xAB, big);
+    Arena::Stats in_use = arena.stats();
+    REQUIRE(in_use.mapped == before.mapped + 4 * Arena::kHugePage);
+    REQUIRE(in_use.huge <= in_use.mapped);
+
+    arena.deallocate(p, big, 64);
+    REQUIRE(arena.stats().pooled == before.pooled + 4 * Arena::kHugePage);
+
+    void* q = arena.allocate(big - 50, 64);
+    REQUIRE(q == p);
+    REQUIRE(arena.stats().reused == before.reused + 1);
+    arena.deallocate(q, big - 50, 64);
+
+    // Far smaller requests leave the big block alone.
+    void* r = arena.allocate(Arena::kMapMin, 64);
+    REQUIRE(r != p);
+    REQUIRE(reinterpret_cast<uintptr_t>(r) % 64 == 0);
+    arena.deallocate(r, Arena::kMapMin, 64);
+
+    void* s = arena.allocate(100, 64);
+    REQUIRE(reinterpret_cast<uintptr_t>(s) % 64 == 0);
+    REQUIRE(arena.stats().heap == before.heap + 100);
+    arena.deallocate(s, 100, 64);
+
+    arena.trim();
+    REQUIRE(arena.stats().pooled == 0);
+    REQUIRE(arena.stats().mapped == before.mapped - before.pooled);
+    arena.set_huge_pages(mode);
+}
+
+TEST_CASE("Arena pool limit unmaps what does not fit", "[arena]") {
+    Arena& arena = Arena::instance();
+    const size_t limit = arena.pool_limit();
+    arena.trim();
+    const Arena::Stats before = arena.stats();
+
+    arena.set_pool_limit(0);
+    void* p = arena.allocate(Arena::kMapMin, 64);
+    arena.deallocate(p, Arena::kMapMin, 64);
+    REQUIRE(arena.stats().pooled == 0);
+    REQUIRE(arena.stats().mapped == before.mapped);
+
+    arena.set_pool_limit(limit);
+}
+
+TEST_CASE("Grids recreated at one size reuse their storage", "[arena]") {
+    Arena& arena = Arena::instance();
+    const HugePages mode = arena.huge_pages();
+
+    auto run = [](HugePages pages) {
+        Arena::instance().set_huge_pages(pages);
+        Grid g(4096, 2048);
+        g.randomize(0.3, 5);
+        g.step_n(20);
+        return g;
+    };
+    Grid plain = run(HugePages::kOff);
+    const size_t reused = arena.stats().reused;
+    {
+        Grid advised = run(HugePages::kAdvise);
+        REQUIRE(advised.population() == plain.population());
+        for (size_t i = 0; i < plain.data_size(); ++i)
+            REQUIRE(advised.data()[i] == plain.data()[i]);
+    }
+    Grid again = run(HugePages::kAdvise);
+    REQUIRE(arena.stats().reused > reused);
+    REQUIRE(again.population() == plain.population());
+
+    arena.set_huge_pages(mode);
+}
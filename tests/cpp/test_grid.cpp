@@ -1,5 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include "gol/grid.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 using namespace gol;
 
@@ -112,6 +118,71 @@ TEST_CASE("Paste and extract", "[grid]") {
     REQUIRE(sub.get_cell(2, 0) == true);
 }
 
+TEST_CASE("Paste modes and extract match per-cell copies with wrap", "[grid]") {
+    const BlitMode modes[] = {BlitMode::kOr, BlitMode::kAnd, BlitMode::kXor, BlitMode::kCopy};
+    // Offsets and sizes cross word, tile and board edges; the last pattern
+    // is wider and taller than the board.
+    struct Case { size_t pw, ph, x, y; };
+    const Case cases[] = {{1, 1, 0, 0},     {3, 2, 299, 139}, {64, 5, 63, 10},
+                          {130, 70, 200, 100}, {700, 20, 17, 3},  {301, 141, 1, 1},
+                          {650, 300, 250, 135}};
+    uint64_t seed = 1;
+    for (const Case& c : cases) {
+        for (BlitMode mode : modes) {
+            Grid g(301, 141);
+            g.randomize(0.4, seed++);
+            Grid pattern(c.pw, c.ph);
+            pattern.randomize(0.4, seed++);
+            std::vector<uint8_t> expected(g.width() * g.height());
+            for (size_t y = 0; y < g.height(); ++y)
+                for (size_t x = 0; x < g.width(); ++x)
+                    expected[y * g.width() + x] = g.get_cell(x, y);
+            for (size_t py = 0; py < c.ph; ++py) {
+                for (size_t px = 0; px < c.pw; ++px) {
+                    uint8_t& cell = expected[((c.y + py) % g.height()) * g.width() +
+                                             (c.x + px) % g.width()];
+                    uint8_t p = pattern.get_cell(px, py);
+                    switch (mode) {
+                    case BlitMode::kOr: cell |= p; break;
+                    case BlitMode::kAnd: cell &= p; break;
+                    case BlitMode::kXor: cell ^= p; break;
+                    case BlitMode::kCopy: cell = p; break;
+                    }
+                }
+            }
+            Grid before = g;
+            uint64_t seen = g.change_count();
+            g.paste(pattern, c.x, c.y, mode);
+            size_t population = 0;
+            bool changed = false;
+            for (size_t y = 0; y < g.height(); ++y) {
+                for (size_t x = 0; x < g.width(); ++x) {
+                    REQUIRE(g.get_cell(x, y) == (expected[y * g.width() + x] != 0));
+                    population += expected[y * g.width() + x];
+                    changed |= g.get_cell(x, y) != before.get_cell(x, y);
+                }
+            }
+            REQUIRE(g.population() == population);
+            REQUIRE(g.changed_since(seen).empty() == !changed);
+
+            Grid sub = g.extract(c.x, c.y, c.pw, c.ph);
+            for (size_t y = 0; y < c.ph; ++y)
+                for (size_t x = 0; x < c.pw; ++x)
+                    REQUIRE(sub.get_cell(x, y) ==
+                            g.get_cell((c.x + x) % g.width(), (c.y + y) % g.height()));
+        }
+    }
+
+    // Pasting a grid into itself works from a copy.
+    Grid g(100, 70);
+    g.randomize(0.5, 3);
+    Grid before = g;
+    g.paste(g, 10, 5, BlitMode::kCopy);
+    for (size_t y = 0; y < 70; ++y)
+        for (size_t x = 0; x < 100; ++x)
+            REQUIRE(g.get_cell((x + 10) % 100, (y + 5) % 70) == before.get_cell(x, y));
+}
+
 TEST_CASE("to_flat_bool", "[grid]") {
     Grid g(4, 4);
     g.set_cell(0, 0, true);
@@ -124,6 +195,41 @@ TEST_CASE("to_flat_bool", "[grid]") {
     REQUIRE(buf[1] == 0);
 }
 
+TEST_CASE("pack and unpack match get_cell on every kernel", "[grid][kernel]") {
+    std::string original = Grid::kernel_name();
+    for (const auto& name : Grid::available_kernels()) {
+        REQUIRE(Grid::set_kernel(name));
+        for (size_t width : {1, 63, 64, 65, 200, 513}) {
+            Grid g(width, 70);
+            g.randomize(0.4, width);
+            const size_t stride = width + 5;
+            std::vector<uint8_t> cells(stride * 70, 7);
+            g.unpack(cells.data(), stride);
+            for (size_t y = 0; y < 70; ++y) {
+                for (size_t x = 0; x < width; ++x)
+                    REQUIRE(cells[y * stride + x] == (g.get_cell(x, y) ? 1 : 0));
+                REQUIRE(cells[y * stride + width] == 7);  // padding untouched
+            }
+
+            // Any nonzero byte is alive; bytes past the width are not read.
+            for (size_t i = 0; i < cells.size(); ++i) cells[i] *= uint8_t(0x80 + i % 100);
+            Grid back(width, 70);
+            back.pack(cells.data(), stride);
+            REQUIRE(back.population() == g.population());
+            REQUIRE(back.state_hash() == g.state_hash());
+            g.step();
+            back.step();
+            REQUIRE(back.state_hash() == g.state_hash());
+
+            std::vector<uint8_t> flat(width * 3 + 2);
+            g.to_flat_bool(flat.data(), flat.size());
+            for (size_t i = 0; i < flat.size(); ++i)
+                REQUIRE(flat[i] == (g.get_cell(i % width, i / width) ? 1 : 0));
+        }
+    }
+    REQUIRE(Grid::set_kernel(original));
+}
+
 TEST_CASE("Toroidal wrapping", "[grid]") {
     Grid g(5, 5);
     // Blinker at top edge should wrap
@@ -150,3 +256,562 @@ TEST_CASE("Randomize with seed is deterministic", "[grid]") {
         }
     }
 }
+
+TEST_CASE("Randomize fills words at the density, alike on any thread count", "[grid]") {
+    for (double density : {0.0, 0.1, 0.25, 0.5, 0.7, 1.0}) {
+        Grid g(1000, 1000);
+        g.randomize(density, 9);
+        double measured = double(g.population()) / 1e6;
+        REQUIRE(measured >= density - 0.005);
+        REQUIRE(measured <= density + 0.005);
+    }
+    Grid full(70, 3);
+    full.randomize(1.0, 1);
+    REQUIRE(full.population() == 210);
+
+    Grid::set_num_threads(1);
+    Grid one(777, 333);
+    one.randomize(0.3, 77);
+    Grid::set_num_threads(4);
+    Grid four(777, 333);
+    four.randomize(0.3, 77);
+    Grid::set_num_threads(0);
+    REQUIRE(one.state_hash() == four.state_hash());
+    for (size_t i = 0; i < one.data_size(); ++i) REQUIRE(one.data()[i] == four.data()[i]);
+}
+
+TEST_CASE("Symmetric soups are invariant under their symmetry", "[grid]") {
+    for (auto size : {std::pair<size_t, size_t>{130, 71}, {64, 64}, {1, 1}, {200, 3}}) {
+        size_t w = size.first, h = size.second;
+        Grid g(w, h);
+        g.randomize(0.5, 4, Symmetry::kC2);
+        for (size_t y = 0; y < h; ++y)
+            for (size_t x = 0; x < w; ++x)
+                REQUIRE(g.get_cell(x, y) == g.get_cell(w - 1 - x, h - 1 - y));
+    }
+    for (size_t n : {1, 2, 5, 63, 64, 65, 130, 200}) {
+        Grid c4(n, n), d8(n, n);
+        c4.randomize(0.5, n, Symmetry::kC4);
+        d8.randomize(0.5, n, Symmetry::kD8);
+        for (size_t y = 0; y < n; ++y) {
+            for (size_t x = 0; x < n; ++x) {
+                REQUIRE(c4.get_cell(x, y) == c4.get_cell(n - 1 - y, x));
+                REQUIRE(d8.get_cell(x, y) == d8.get_cell(n - 1 - y, x));
+                REQUIRE(d8.get_cell(x, y) == d8.get_cell(y, x));
+            }
+        }
+        // A quarter of the board is still random, not all alike.
+        if (n >= 63) {
+            REQUIRE(c4.population() > n * n / 4);
+            REQUIRE(c4.population() < n * n * 3 / 4);
+            REQUIRE(d8.population() > n * n / 4);
+            REQUIRE(d8.population() < n * n * 3 / 4);
+        }
+    }
+    Grid wide(10, 9);
+    REQUIRE_THROWS_AS(wide.randomize(0.5, 1, Symmetry::kC4), std::invalid_argument);
+    REQUIRE_THROWS_AS(wide.randomize(0.5, 1, Symmetry::kD8), std::invalid_argument);
+}
+
+namespace {
+
+// Per-cell reference for a rule on a torus, used to check the packed kernels.
+std::vector<uint8_t> reference_step(const std::vector<uint8_t>& cells, size_t w, size_t h,
+                                    const Rule& rule = Rule()) {
+    std::vector<uint8_t> next(w * h, 0);
+    for (size_t y = 0; y < h; ++y) {
+        for (size_t x = 0; x < w; ++x) {
+            int n = 0;
+            for (size_t dy = h - 1; dy <= h + 1; ++dy) {
+                for (size_t dx = w - 1; dx <= w + 1; ++dx) {
+                    if (dy == h && dx == w) continue;
+                    n += cells[((y + dy) % h) * w + (x + dx) % w];
+                }
+            }
+            bool alive = cells[y * w + x] != 0;
+            next[y * w + x] = ((alive ? rule.survive : rule.birth) >> n) & 1;
+        }
+    }
+    return next;
+}
+
+} // namespace
+
+TEST_CASE("Packed step matches per-cell reference across word edges", "[grid]") {
+    const size_t sizes[][2] = {{1, 1}, {3, 2}, {63, 5}, {64, 7}, {65, 9}, {130, 4}, {200, 33}};
+    for (auto& size : sizes) {
+        size_t w = size[0], h = size[1];
+        Grid g(w, h);
+        g.randomize(0.4, 7 + w * h);
+
+        std::vector<uint8_t> ref(w * h);
+        for (size_t y = 0; y < h; ++y)
+            for (size_t x = 0; x < w; ++x)
+                ref[y * w + x] = g.get_cell(x, y) ? 1 : 0;
+
+        for (int gen = 0; gen < 8; ++gen) {
+            g.step();
+            ref = reference_step(ref, w, h);
+        }
+
+        size_t pop = 0;
+        for (size_t y = 0; y < h; ++y) {
+            for (size_t x = 0; x < w; ++x) {
+                REQUIRE(g.get_cell(x, y) == (ref[y * w + x] != 0));
+                pop += ref[y * w + x];
+            }
+        }
+        REQUIRE(g.population() == pop);
+    }
+}
+
+TEST_CASE("Every supported kernel steps identically", "[grid][kernel]") {
+    std::string original = Grid::kernel_name();
+    auto kernels = Grid::available_kernels();
+    REQUIRE(!kernels.empty());
+    REQUIRE(kernels.front() == "scalar");
+    // The best kernel is picked unless GOL_KERNEL forces one.
+    if (!std::getenv("GOL_KERNEL")) REQUIRE(kernels.back() == original);
+
+    const size_t sizes[][2] = {{64, 3}, {65, 6}, {300, 20}, {1000, 9}};
+    for (auto& size : sizes) {
+        Grid base(size[0], size[1]);
+        base.randomize(0.35, 99);
+        REQUIRE(Grid::set_kernel("scalar"));
+        Grid expected = base;
+        expected.step_n(10);
+
+        for (const auto& name : kernels) {
+            REQUIRE(Grid::set_kernel(name));
+            REQUIRE(Grid::kernel_name() == name);
+            Grid g = base;
+            g.step_n(10);
+            for (size_t y = 0; y < g.height(); ++y)
+                for (size_t x = 0; x < g.width(); ++x)
+                    REQUIRE(g.get_cell(x, y) == expected.get_cell(x, y));
+        }
+    }
+
+    REQUIRE_FALSE(Grid::set_kernel("no-such-kernel"));
+    REQUIRE(Grid::set_kernel(original));
+}
+
+TEST_CASE("Rules parse and print in B/S form", "[grid][rule]") {
+    REQUIRE(Rule() == Rule::parse("B3/S23"));
+    REQUIRE(Rule::parse("b36/s23").to_string() == "B36/S23");
+    REQUIRE(Rule::parse("S23/B36") == Rule::parse("B36/S23"));
+    REQUIRE(Rule::parse("23/36") == Rule::parse("B36/S23"));
+    REQUIRE(Rule::parse("B2/S").survive == 0);
+    REQUIRE(Rule::parse("Seeds") == Rule::parse("B2/S"));
+    REQUIRE(Rule::parse("DayAndNight").to_string() == "B3678/S34678");
+    REQUIRE(Rule::parse("B3/S23:T100,100") == Rule());
+    for (const char* bad : {"", "B3", "B9/S23", "B3/S2/3", "B3/B2", "X3/S23", "Foo"})
+        REQUIRE_THROWS_AS(Rule::parse(bad), std::invalid_argument);
+}
+
+TEST_CASE("Every kernel steps every rule like the reference", "[grid][rule]") {
+    std::string original = Grid::kernel_name();
+    const char* rules[] = {"B3/S23", "B36/S23", "B2/S", "B3678/S34678",
+                           "B36/S125", "B0/S8", "B1357/S02468"};
+    const size_t sizes[][2] = {{63, 5}, {65, 9}, {300, 70}};
+    for (const auto& name : Grid::available_kernels()) {
+        REQUIRE(Grid::set_kernel(name));
+        for (const char* text : rules) {
+            Rule rule = Rule::parse(text);
+            for (auto& size : sizes) {
+                size_t w = size[0], h = size[1];
+                Grid g(w, h);
+                g.set_rule(rule);
+                g.randomize(0.3, w + h);
+                std::vector<uint8_t> ref(w * h);
+                for (size_t y = 0; y < h; ++y)
+                    for (size_t x = 0; x < w; ++x)
+                        ref[y * w + x] = g.get_cell(x, y) ? 1 : 0;
+
+                g.step_n(2);
+                g.set_temporal_depth(3);
+                g.step_n(3);
+                for (int gen = 0; gen < 5; ++gen)
+                    ref = reference_step(ref, w, h, rule);
+
+                for (size_t y = 0; y < h; ++y)
+                    for (size_t x = 0; x < w; ++x)
+                        REQUIRE(g.get_cell(x, y) == (ref[y * w + x] != 0));
+            }
+        }
+    }
+    REQUIRE(Grid::set_kernel(original));
+}
+
+TEST_CASE("Changed regions cover exactly what steps and edits touch", "[grid][tiles]") {
+    Grid g(1500, 200);
+    for (size_t x = 1000; x < 1003; ++x)  // a blinker
+        g.set_cell(x, 150, true);
+    for (size_t y = 10; y < 12; ++y)      // a block
+        for (size_t x = 10; x < 12; ++x)
+            g.set_cell(x, y, true);
+    g.step_n(2);
+
+    uint64_t seen = g.change_count();
+    REQUIRE(g.changed_since(seen).empty());
+    Grid before = g;
+    g.step();
+    auto rects = g.changed_since(seen);
+    REQUIRE(rects.size() == 1);
+    REQUIRE(rects[0].x == 512);
+    REQUIRE(rects[0].width == 512);
+    REQUIRE(rects[0].y == 149);
+    REQUIRE(rects[0].height == 3);
+    for (size_t y = 0; y < g.height(); ++y)
+        for (size_t x = 0; x < g.width(); ++x)
+            if (g.get_cell(x, y) != before.get_cell(x, y)) {
+                bool covered = false;
+                for (auto& r : rects)
+                    covered |= x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height;
+                REQUIRE(covered);
+            }
+
+    // Edits count too, and each observer keeps its own place.
+    uint64_t other = g.change_count();
+    g.set_span(1400, 199, 200, true);
+    rects = g.changed_since(other);
+    REQUIRE(rects.size() == 1);
+    REQUIRE(rects[0].x == 1024);
+    REQUIRE(rects[0].width == 476);
+    REQUIRE(rects[0].y == 199);
+    REQUIRE(rects[0].height == 1);
+    REQUIRE(g.changed_since(seen).size() == 2);
+    g.clear();
+    REQUIRE(g.changed_since(other).size() == 4);  // one full-width rect per tile row
+}
+
+TEST_CASE("Replacing a grid carries its change count on", "[grid][tiles]") {
+    Grid g(300, 100);
+    g.randomize(0.3, 2);
+    g.step_n(40);
+    g.set_checkpoint("test_replace.golsnap", 2);
+    uint64_t seen = g.change_count();
+
+    Grid fresh(200, 150);
+    fresh.set_cell(5, 5, true);
+    REQUIRE(fresh.change_count() < seen);
+    g.replace(fresh);
+    REQUIRE(g.width() == 200);
+    REQUIRE(g.height() == 150);
+    REQUIRE(g.population() == 1);
+    REQUIRE(g.generation() == 0);
+    REQUIRE(g.change_count() > seen);
+    auto rects = g.changed_since(seen);
+    size_t area = 0;
+    for (auto& r : rects) area += r.width * r.height;
+    REQUIRE(area == 200 * 150);
+
+    // The checkpoint stays the replaced grid's.
+    g.step_n(3);
+    REQUIRE(g.population() == 0);
+    REQUIRE(std::remove("test_replace.golsnap") == 0);
+}
+
+TEST_CASE("State copies read and step like the original", "[grid][tiles]") {
+    for (bool low_memory : {false, true}) {
+        Grid g(700, 150);
+        g.set_low_memory(low_memory);
+        g.set_rule(Rule::parse("B36/S23"));
+        Grid corner(90, 70);
+        corner.randomize(0.4, 12);
+        g.paste(corner, 600, 70);  // most tiles stay still
+        g.step_n(9);
+        uint64_t seen = g.change_count();
+        g.step();
+
+        Grid copy(2000, 10);  // storage of another size is reused or regrown
+        copy.copy_state_from(g);
+        REQUIRE(copy.width() == 700);
+        REQUIRE(copy.generation() == g.generation());
+        REQUIRE(copy.rule() == g.rule());
+        REQUIRE(copy.low_memory() == low_memory);
+        REQUIRE(copy.population() == g.population());
+        REQUIRE(copy.state_hash() == g.state_hash());
+        REQUIRE(copy.change_count() == g.change_count());
+        REQUIRE(copy.changed_since(seen).size() == g.changed_since(seen).size());
+
+        // Stepping rebuilds the scratch the copy left out.
+        Grid again = copy;
+        for (int gen = 0; gen < 6; ++gen) {
+            copy.step();
+            again.step_n(1);
+            g.step();
+            for (size_t i = 0; i < g.data_size(); ++i) {
+                REQUIRE(copy.data()[i] == g.data()[i]);
+                REQUIRE(again.data()[i] == g.data()[i]);
+            }
+        }
+        Grid blocked(1, 1);
+        blocked.copy_state_from(g);
+        blocked.set_temporal_depth(3);
+        blocked.step_n(3);
+        g.step_n(3);
+        REQUIRE(blocked.state_hash() == g.state_hash());
+        REQUIRE(blocked.generation() == g.generation());
+    }
+}
+
+TEST_CASE("Changing the rule restarts tile skipping", "[grid][rule]") {
+    // A block is still under Life, so its tile goes idle; under Seeds it
+    // must come back to life.
+    Grid g(128, 128);
+    for (size_t y = 10; y < 12; ++y)
+        for (size_t x = 10; x < 12; ++x)
+            g.set_cell(x, y, true);
+    g.step_n(3);
+    REQUIRE(g.changed_tiles() == 0);
+    g.set_rule(Rule::parse("B2/S"));
+    g.step();
+    REQUIRE(g.population() == 8);
+    REQUIRE_FALSE(g.get_cell(10, 10));
+    REQUIRE(g.get_cell(10, 9));
+}
+
+TEST_CASE("State hash follows the cells", "[grid][cycle]") {
+    Grid a(200, 130);
+    a.randomize(0.3, 11);
+    Grid b(200, 130);
+    b.paste(a, 0, 0);
+    REQUIRE(a.state_hash() == b.state_hash());
+    REQUIRE(Grid(200, 130).state_hash() == 0);
+
+    b.set_cell(199, 129, !b.get_cell(199, 129));
+    REQUIRE(a.state_hash() != b.state_hash());
+
+    // Hashes kept up by step() match ones computed from scratch.
+    a.run_until_stable(20, 0);
+    Grid c(200, 130);
+    c.paste(a, 0, 0);
+    REQUIRE(a.state_hash() == c.state_hash());
+}
+
+TEST_CASE("run_until_stable finds the first repeat", "[grid][cycle]") {
+    SECTION("still life") {
+        Grid g(20, 20);
+        for (size_t y = 5; y < 7; ++y)
+            for (size_t x = 5; x < 7; ++x)
+                g.set_cell(x, y, true);
+        Grid::Stability s = g.run_until_stable(100);
+        REQUIRE(s.settled);
+        REQUIRE(s.period == 1);
+        REQUIRE(s.start == 0);
+    }
+    SECTION("dying pattern") {
+        Grid g(20, 20);
+        g.set_cell(3, 3, true);
+        g.set_cell(4, 3, true);
+        Grid::Stability s = g.run_until_stable(100);
+        REQUIRE(s.settled);
+        REQUIRE(s.period == 1);
+        REQUIRE(s.start == 1);
+        REQUIRE(g.population() == 0);
+    }
+    SECTION("glider on a torus") {
+        Grid g(16, 16);
+        g.set_cell(1, 0, true);
+        g.set_cell(2, 1, true);
+        g.set_cell(0, 2, true);
+        g.set_cell(1, 2, true);
+        g.set_cell(2, 2, true);
+        REQUIRE_FALSE(g.run_until_stable(100, 32).settled);
+        REQUIRE(g.generation() == 100);
+        Grid::Stability s = g.run_until_stable(100);
+        REQUIRE(s.settled);
+        REQUIRE(s.period == 64);
+        REQUIRE(s.start == 100);
+        REQUIRE(g.generation() == 228);
+    }
+    SECTION("random soup against a full history") {
+        Grid g(24, 24);
+        g.randomize(0.35, 3);
+        std::vector<std::vector<uint8_t>> states;
+        Grid ref = g;
+        size_t period = 0, start = 0;
+        while (period == 0 && states.size() < 3000) {
+            std::vector<uint8_t> cells(24 * 24);
+            ref.to_flat_bool(cells.data(), cells.size());
+            for (size_t i = 0; i < states.size(); ++i) {
+                if (states[i] == cells) {
+                    period = states.size() - i;
+                    start = i;
+                }
+            }
+            states.push_back(cells);
+            ref.step();
+        }
+        REQUIRE(period != 0);
+        Grid::Stability s = g.run_until_stable(3000);
+        REQUIRE(s.settled);
+        REQUIRE(s.period == period);
+        REQUIRE(s.start == start);
+    }
+}
+
+TEST_CASE("Rows are padded to cache-line aligned strides", "[grid][kernel]") {
+    Grid g(65, 3);
+    REQUIRE(g.words_per_row() % 8 == 0);
+    REQUIRE(g.data_size() == g.words_per_row() * 3);
+    REQUIRE(reinterpret_cast<uintptr_t>(g.data()) % 64 == 0);
+}
+
+TEST_CASE("Still tiles are skipped without changing the result", "[grid][tiles]") {
+    Grid g(1500, 200);
+    REQUIRE(g.tiles_x() == 3);
+    REQUIRE(g.tiles_y() == 4);
+
+    // A block far from a blinker: after settling, only the blinker's tile
+    // keeps changing.
+    for (auto xy : {std::pair<size_t, size_t>{10, 10}, {11, 10}, {10, 11}, {11, 11}})
+        g.set_cell(xy.first, xy.second, true);
+    for (size_t x = 1000; x < 1003; ++x)
+        g.set_cell(x, 150, true);
+    g.step_n(3);
+    REQUIRE(g.changed_tiles() == 1);
+    REQUIRE(g.population() == 7);
+    REQUIRE(g.get_cell(1001, 149));
+    REQUIRE(g.get_cell(1001, 151));
+    REQUIRE(g.get_cell(10, 10));
+
+    // Sparse soup spanning tile and torus edges against the reference.
+    size_t w = 1100, h = 150;
+    Grid s(w, h);
+    std::vector<uint8_t> ref(w * h);
+    uint64_t state = 12345;
+    for (int i = 0; i < 1500; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        size_t x = (state >> 33) % w, y = (state >> 13) % h;
+        s.set_cell(x, y, true);
+        ref[y * w + x] = 1;
+    }
+    for (int gen = 0; gen < 30; ++gen) {
+        s.step();
+        ref = reference_step(ref, w, h);
+    }
+    size_t pop = 0;
+    for (size_t y = 0; y < h; ++y) {
+        for (size_t x = 0; x < w; ++x) {
+            REQUIRE(s.get_cell(x, y) == (ref[y * w + x] != 0));
+            pop += ref[y * w + x];
+        }
+    }
+    REQUIRE(s.population() == pop);
+}
+
+TEST_CASE("Temporal blocking matches single steps", "[grid][temporal]") {
+    // Depths past the height make the halos wrap the board several times.
+    const size_t sizes[][2] = {{64, 3}, {200, 37}, {700, 300}};
+    for (auto& size : sizes) {
+        Grid base(size[0], size[1]);
+        base.randomize(0.4, 3 + size[0]);
+        Grid expected = base;
+        for (int i = 0; i < 23; ++i)
+            expected.step();
+
+        for (size_t depth : {2, 5, 8, 40}) {
+            Grid g = base;
+            g.set_temporal_depth(depth);
+            g.step_n(23);
+            REQUIRE(g.generation() == 23);
+            REQUIRE(g.population() == expected.population());
+            for (size_t y = 0; y < g.height(); ++y)
+                for (size_t x = 0; x < g.width(); ++x)
+                    REQUIRE(g.get_cell(x, y) == expected.get_cell(x, y));
+            // Tile skipping picks up correctly after a blocked pass.
+            g.step();
+            Grid next = expected;
+            next.step();
+            REQUIRE(g.population() == next.population());
+        }
+    }
+}
+
+TEST_CASE("Low-memory stepping matches double buffering", "[grid][tiles]") {
+    const size_t sizes[][2] = {{5, 1}, {64, 3}, {200, 37}, {700, 300}, {1100, 200}};
+    for (size_t threads : {1, 3}) {
+        Grid::set_num_threads(threads);
+        for (auto& size : sizes) {
+            for (const char* rule : {"B3/S23", "B25/S4"}) {
+                Grid expected(size[0], size[1]);
+                expected.set_rule(Rule::parse(rule));
+                // The large board is one glider and a soup corner, so most
+                // tile rows sit still.
+                if (size[1] == 200) {
+                    Grid corner(100, 80);
+                    corner.randomize(0.4, 5);
+                    expected.paste(corner, 1050, 170);
+                    for (auto xy : {std::pair<size_t, size_t>{501, 60}, {502, 61}, {500, 62},
+                                    {501, 62}, {502, 62}})
+                        expected.set_cell(xy.first, xy.second, true);
+                } else {
+                    expected.randomize(0.4, size[0]);
+                }
+                Grid g = expected;
+                g.set_low_memory(true);
+                REQUIRE(g.low_memory());
+                for (int gen = 0; gen < 40; ++gen) {
+                    uint64_t seen = g.change_count();
+                    Grid before = g;
+                    g.step();
+                    expected.step();
+                    for (size_t i = 0; i < g.data_size(); ++i)
+                        REQUIRE(g.data()[i] == expected.data()[i]);
+                    size_t covered = 0;
+                    for (const Grid::Rect& r : g.changed_since(seen)) covered += r.width * r.height;
+                    REQUIRE((covered != 0) == (before.state_hash() != g.state_hash()));
+                }
+                g.step_n(7);
+                expected.step_n(7);
+                REQUIRE(g.state_hash() == expected.state_hash());
+                REQUIRE(g.population() == expected.population());
+                // Back to two boards, tile skipping carries on correctly.
+                g.set_low_memory(false);
+                g.step_n(5);
+                expected.step_n(5);
+                for (size_t i = 0; i < g.data_size(); ++i)
+                    REQUIRE(g.data()[i] == expected.data()[i]);
+            }
+        }
+    }
+    Grid::set_num_threads(0);
+
+    Grid square(130, 130), low(130, 130);
+    low.set_low_memory(true);
+    square.randomize(0.5, 8, Symmetry::kD8);
+    low.randomize(0.5, 8, Symmetry::kD8);
+    REQUIRE(square.state_hash() == low.state_hash());
+}
+
+TEST_CASE("Worker pool size and affinity leave results unchanged", "[grid][threads]") {
+    size_t original = Grid::num_threads();
+    REQUIRE(original >= 1);
+
+    // Activity only in the top rows, so most workers finish at once and
+    // have to steal.
+    Grid base(600, 700);
+    Grid soup(600, 100);
+    soup.randomize(0.4, 21);
+    base.paste(soup, 0, 0);
+    Grid expected = base;
+    Grid::set_num_threads(1);
+    REQUIRE(Grid::num_threads() == 1);
+    expected.step_n(12);
+
+    for (size_t threads : {2, 3, 8}) {
+        Grid::set_num_threads(threads);
+        REQUIRE(Grid::num_threads() == threads);
+        Grid::set_cpu_affinity({0});
+        Grid g = base;
+        g.step_n(12);
+        REQUIRE(g.population() == expected.population());
+        for (size_t y = 0; y < g.height(); ++y)
+            for (size_t x = 0; x < g.width(); ++x)
+                REQUIRE(g.get_cell(x, y) == expected.get_cell(x, y));
+        Grid::set_cpu_affinity({});
+    }
+    Grid::set_num_threads(original);
+}
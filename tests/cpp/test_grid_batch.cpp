@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/grid_batch.hpp"
+#include "gol/grid.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace gol;
+
+namespace {
+
+std::vector<uint64_t> seeds_for(size_t count, uint64_t base) {
+    std::vector<uint64_t> seeds(count);
+    for (size_t i = 0; i < count; ++i) seeds[i] = base + i;
+    return seeds;
+}
+
+bool same_cells(const GridBatch& batch, size_t index, const Grid& grid) {
+    for (size_t y = 0; y < grid.height(); ++y)
+        for (size_t x = 0; x < grid.width(); ++x)
+            if (batch.get_cell(index, x, y) != grid.get_cell(x, y)) return false;
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Batch randomize matches Grid::randomize per seed", "[batch]") {
+    GridBatch batch(11, 40, 9);
+    batch.randomize(0.3, seeds_for(11, 100));
+    auto pops = batch.populations();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Grid g(40, 9);
+        g.randomize(0.3, 100 + i);
+        REQUIRE(same_cells(batch, i, g));
+        REQUIRE(pops[i] == g.population());
+    }
+    REQUIRE_THROWS_AS(batch.randomize(0.3, seeds_for(3, 1)), std::invalid_argument);
+}
+
+TEST_CASE("Every kernel steps a batch like separate grids", "[batch]") {
+    std::string original = Grid::kernel_name();
+    const size_t sizes[][2] = {{1, 1}, {32, 32}, {64, 64}, {65, 7}, {100, 3}, {130, 5}};
+    const char* rules[] = {"B3/S23", "B36/S23", "B36/S125"};
+    for (const auto& name : Grid::available_kernels()) {
+        REQUIRE(Grid::set_kernel(name));
+        for (auto& size : sizes) {
+            for (const char* text : rules) {
+                size_t w = size[0], h = size[1];
+                GridBatch batch(19, w, h);
+                batch.set_rule(Rule::parse(text));
+                batch.randomize(0.35, seeds_for(19, w * h));
+                std::vector<Grid> grids;
+                for (size_t i = 0; i < batch.size(); ++i) grids.push_back(batch.grid(i));
+
+                batch.step();
+                batch.step_n(6);
+                REQUIRE(batch.generation() == 7);
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    grids[i].step_n(7);
+                    REQUIRE(same_cells(batch, i, grids[i]));
+                }
+            }
+        }
+    }
+    REQUIRE(Grid::set_kernel(original));
+}
+
+TEST_CASE("Batch marks still lifes and blinkers stable", "[batch]") {
+    GridBatch batch(4, 16, 16);
+    // 0: block, 1: blinker, 2: glider, 3: empty
+    for (size_t y = 2; y < 4; ++y)
+        for (size_t x = 2; x < 4; ++x)
+            batch.set_cell(0, x, y, true);
+    for (size_t x = 5; x < 8; ++x)
+        batch.set_cell(1, x, 5, true);
+    batch.set_cell(2, 1, 0, true);
+    batch.set_cell(2, 2, 1, true);
+    batch.set_cell(2, 0, 2, true);
+    batch.set_cell(2, 1, 2, true);
+    batch.set_cell(2, 2, 2, true);
+    REQUIRE(batch.stable() == std::vector<uint8_t>{0, 0, 0, 0});
+
+    batch.step_n(5);
+    REQUIRE(batch.stable() == std::vector<uint8_t>{1, 1, 0, 1});
+    REQUIRE(batch.populations() == std::vector<size_t>{4, 3, 5, 0});
+
+    // A lone cell dies in one step; only the step after that repeats.
+    batch.set_cell(0, 10, 10, true);
+    REQUIRE(batch.stable()[0] == 0);
+    batch.step();
+    REQUIRE(batch.stable()[0] == 0);
+    batch.step();
+    REQUIRE(batch.stable()[0] == 1);
+}
+
+TEST_CASE("Batch grids copy in and out", "[batch]") {
+    GridBatch batch(3, 20, 10);
+    Grid g(30, 30);
+    g.set_cell(19, 9, true);
+    g.set_cell(25, 5, true);
+    batch.set_grid(1, g);
+    REQUIRE(batch.get_cell(1, 19, 9));
+    REQUIRE(batch.populations() == std::vector<size_t>{0, 1, 0});
+
+    Grid out = batch.grid(1);
+    REQUIRE(out.width() == 20);
+    REQUIRE(out.population() == 1);
+    REQUIRE_THROWS_AS(batch.grid(3), std::out_of_range);
+    REQUIRE_THROWS_AS(batch.set_grid(3, g), std::out_of_range);
+    batch.set_cell(5, 0, 0, true);  // ignored
+    REQUIRE_FALSE(batch.get_cell(5, 0, 0));
+
+    REQUIRE(batch.stride() % 8 == 0);
+    REQUIRE(batch.data()[(9 * batch.words_per_row()) * batch.stride() + 1] == uint64_t(1) << 19);
+}
+
+TEST_CASE("Batch word copies match the cells across word edges", "[batch]") {
+    GridBatch batch(5, 150, 40);
+    batch.randomize(0.4, seeds_for(5, 60));
+    std::vector<uint8_t> cells(5 * 40 * 150);
+    batch.unpack(cells.data());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Grid out = batch.grid(i);
+        REQUIRE(same_cells(batch, i, out));
+        REQUIRE(out.population() == batch.populations()[i]);
+        for (size_t y = 0; y < 40; ++y)
+            for (size_t x = 0; x < 150; ++x)
+                REQUIRE(cells[(i * 40 + y) * 150 + x] == batch.get_cell(i, x, y));
+    }
+
+    // A smaller grid clears the rest; a larger one is cut at the edges.
+    Grid small(70, 20);
+    small.randomize(0.5, 4);
+    batch.set_grid(2, small);
+    for (size_t y = 0; y < 40; ++y)
+        for (size_t x = 0; x < 150; ++x)
+            REQUIRE(batch.get_cell(2, x, y) == (x < 70 && y < 20 && small.get_cell(x, y)));
+    Grid large(300, 50);
+    large.randomize(0.5, 5);
+    batch.set_grid(3, large);
+    REQUIRE(same_cells(batch, 3, large.extract(0, 0, 150, 40)));
+    REQUIRE(batch.grid(3).population() == large.extract(0, 0, 150, 40).population());
+}
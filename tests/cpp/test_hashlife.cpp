@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/hashlife.hpp"
+#include "gol/grid.hpp"
+#include "gol/rle.hpp"
+#include <stdexcept>
+
+using namespace gol;
+
+TEST_CASE("HashLife cells and bounding box", "[hashlife]") {
+    HashLife life;
+    REQUIRE(life.population() == 0);
+    life.set_cell(-5, 3, true);
+    life.set_cell(1000, -70, true);
+    REQUIRE(life.get_cell(-5, 3));
+    REQUIRE(life.get_cell(1000, -70));
+    REQUIRE_FALSE(life.get_cell(0, 0));
+    REQUIRE(life.population() == 2);
+
+    auto box = life.bounding_box();
+    REQUIRE(box.x == -5);
+    REQUIRE(box.y == -70);
+    REQUIRE(box.width == 1006);
+    REQUIRE(box.height == 74);
+
+    life.set_cell(1000, -70, false);
+    REQUIRE(life.population() == 1);
+}
+
+TEST_CASE("HashLife matches Grid away from the torus edges", "[hashlife]") {
+    Grid grid(256, 256);
+    Grid soup(48, 48);
+    soup.randomize(0.4, 17);
+    grid.paste(soup, 104, 104);
+
+    HashLife life;
+    life.load(grid);
+    REQUIRE(life.population() == grid.population());
+
+    // 100 generations cannot carry anything from the soup to the edges.
+    for (uint64_t n : {1u, 2u, 3u, 30u, 64u}) {
+        life.step(n);
+        grid.step_n(n);
+        REQUIRE(life.generation() == grid.generation());
+        REQUIRE(life.population() == grid.population());
+        Grid back = life.to_grid(0, 0, 256, 256);
+        for (size_t y = 0; y < 256; ++y)
+            for (size_t x = 0; x < 256; ++x)
+                REQUIRE(back.get_cell(x, y) == grid.get_cell(x, y));
+    }
+}
+
+TEST_CASE("HashLife jumps a glider 2^40 generations", "[hashlife]") {
+    HashLife life;
+    life.load(parse_rle("x = 3, y = 3\nbo$2bo$3o!"));
+    life.step(uint64_t(1) << 40);
+    REQUIRE(life.generation() == uint64_t(1) << 40);
+    REQUIRE(life.population() == 5);
+
+    // A glider moves (1, 1) every 4 generations.
+    auto box = life.bounding_box();
+    REQUIRE(box.x == int64_t(1) << 38);
+    REQUIRE(box.y == int64_t(1) << 38);
+    RLEPattern shape = life.to_pattern();
+    REQUIRE(shape.width == 3);
+    REQUIRE(shape.height == 3);
+    REQUIRE(shape.alive_cells == parse_rle("x = 3, y = 3\nbo$2bo$3o!").alive_cells);
+}
+
+TEST_CASE("HashLife superspeed and garbage collection", "[hashlife]") {
+    // Gosper glider gun: one new glider every 30 generations.
+    const char* gun =
+        "x = 36, y = 9\n"
+        "24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4b"
+        "obo$10bo5bo7bo$11bo3bo$12b2o!";
+    HashLife life(8 << 20);
+    life.load(parse_rle(gun));
+    uint64_t done = 0;
+    while (done < 30000)
+        done += life.step_superspeed();
+    REQUIRE(life.generation() == done);
+    REQUIRE(life.population() > 5 * (done / 30));
+    REQUIRE(life.memory_usage() <= 16 << 20);
+
+    HashLife exact;
+    exact.load(parse_rle(gun));
+    exact.step(done);
+    REQUIRE(exact.population() == life.population());
+
+    size_t before = life.node_count();
+    life.collect_garbage();
+    REQUIRE(life.node_count() <= before);
+    REQUIRE(life.population() == exact.population());
+
+    // A cap far below what the R-pentomino needs forces collections in the
+    // middle of a step.
+    HashLife capped(256 << 10), free_run(0);
+    capped.load(parse_rle("x = 3, y = 3\nb2o$2o$bo!"));
+    free_run.load(parse_rle("x = 3, y = 3\nb2o$2o$bo!"));
+    capped.step(2000);
+    free_run.step(2000);
+    REQUIRE(capped.node_count() < free_run.node_count());
+    REQUIRE(capped.population() == free_run.population());
+    REQUIRE(capped.population() == 116);
+}
+
+TEST_CASE("HashLife collects garbage on an empty universe", "[hashlife]") {
+    HashLife life;
+    life.collect_garbage();
+    life.load(parse_rle("x = 3, y = 1\n3o!"));
+    REQUIRE(life.population() == 3);
+    life.step(1);
+    REQUIRE(life.population() == 3);
+
+    life.clear();
+    life.collect_garbage();
+    life.set_cell(0, 0, true);
+    life.set_cell(1, 0, true);
+    life.set_cell(0, 1, true);
+    life.set_cell(1, 1, true);
+    REQUIRE(life.population() == 4);
+    life.step(5);
+    REQUIRE(life.population() == 4);
+    REQUIRE(life.get_cell(1, 1));
+}
+
+TEST_CASE("HashLife refuses grids with other rules", "[hashlife]") {
+    Grid grid(16, 16);
+    grid.set_cell(3, 3, true);
+    HashLife life;
+    for (const char* rule : {"B36/S23", "B2/S", "B3678/S34678"}) {
+        grid.set_rule(Rule::parse(rule));
+        REQUIRE_THROWS_AS(life.load(grid), std::invalid_argument);
+    }
+    REQUIRE(life.population() == 0);
+    grid.set_rule(Rule());
+    life.load(grid);
+    REQUIRE(life.population() == 1);
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/macrocell.hpp"
+#include "gol/grid.hpp"
+#include "gol/hashlife.hpp"
+#include "gol/plane.hpp"
+#include <stdexcept>
+
+using namespace gol;
+
+namespace {
+
+// A glider in the south-east leaf of a 16x16 root, as Golly writes it.
+const char* kGlider =
+    "[M2] (golly 4.2)\n"
+    "#R B3/S23\n"
+    "#G 7\n"
+    ".*$..*$***$\n"
+    "4 0 0 0 1\n";
+
+} // namespace
+
+TEST_CASE("Macrocell files load around the origin", "[macrocell]") {
+    Macrocell mc = parse_macrocell(kGlider);
+    REQUIRE(mc.rule == "B3/S23");
+    REQUIRE(mc.generation == 7);
+    REQUIRE(mc.nodes.size() == 2);
+    REQUIRE(mc.level() == 4);
+
+    HashLife life;
+    life.load(mc);
+    REQUIRE(life.population() == 5);
+    for (auto [x, y] : {std::pair<int, int>{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}})
+        REQUIRE(life.get_cell(x, y));
+
+    Plane plane(32, 32);
+    load_macrocell(plane, mc, 10, 10);
+    REQUIRE(plane.population() == 5);
+    REQUIRE(plane.get_cell(11, 10));
+    REQUIRE(plane.get_cell(12, 12));
+
+    life.step(4);
+    Macrocell out = life.to_macrocell();
+    REQUIRE(out.generation == 4);
+    HashLife copy;
+    copy.load(parse_macrocell(to_macrocell(out)));
+    REQUIRE(copy.population() == 5);
+    for (auto [x, y] : {std::pair<int, int>{2, 1}, {3, 2}, {1, 3}, {2, 3}, {3, 3}})
+        REQUIRE(copy.get_cell(x, y));
+}
+
+TEST_CASE("Macrocell output shares repeated subtrees", "[macrocell]") {
+    // 4096 blocks over 4096 x 4096 cells: a handful of distinct nodes.
+    HashLife life;
+    for (int64_t y = 0; y < 64; ++y)
+        for (int64_t x = 0; x < 64; ++x)
+            for (int c = 0; c < 4; ++c)
+                life.set_cell(x * 64 + c % 2, y * 64 + c / 2, true);
+    Macrocell mc = life.to_macrocell();
+    REQUIRE(mc.nodes.size() < 40);
+    std::string text = to_macrocell(mc);
+    REQUIRE(text.size() < 1000);
+
+    HashLife copy;
+    copy.load(parse_macrocell(text));
+    REQUIRE(copy.population() == life.population());
+    REQUIRE(copy.get_cell(4032, 4033));
+    REQUIRE_FALSE(copy.get_cell(4034, 4033));
+    copy.step(100);
+    life.step(100);
+    REQUIRE(copy.population() == life.population());
+
+    // Loading ORs into what is there, growing the tree as needed.
+    HashLife small;
+    small.set_cell(-3, -3, true);
+    small.load(mc);
+    REQUIRE(small.population() == life.population() + 1);
+
+    Grid grid(256, 256);
+    grid.set_cell(3, 4, true);
+    HashLife from_grid;
+    from_grid.load(grid);
+    REQUIRE(to_macrocell(from_grid.to_macrocell()).find("#R B3/S23") != std::string::npos);
+}
+
+TEST_CASE("Macrocell errors carry the line", "[macrocell]") {
+    auto line_of = [](const std::string& text) {
+        try {
+            parse_macrocell(text);
+        } catch (const MacrocellError& e) {
+            return e.line();
+        }
+        return size_t(0);
+    };
+    REQUIRE(line_of("x = 3, y = 3\n") == 1);
+    REQUIRE(line_of("") == 1);
+    REQUIRE(line_of("[M2]\n#C fine\n.*$\n4 0 0 0 2\n") == 4);
+    REQUIRE(line_of("[M2]\n.*$\n5 0 0 0 1\n") == 3);
+    REQUIRE(line_of("[M2]\n.*.x$\n") == 2);
+    REQUIRE(line_of("[M2]\n.........*$\n") == 2);
+    REQUIRE(line_of("[M2]\n1 0 0 0 1\n") == 2);
+    REQUIRE(line_of("[M2]\n#R Foo\n") == 2);
+    REQUIRE(line_of("[M2] (golly)\r\n#R B3/S23\r\n.*$\r\n4 1 1 1 1\r\n") == 0);
+    REQUIRE(parse_macrocell("[M2]\n").nodes.empty());
+
+    // The tree runs Life only, so other rules are refused rather than run.
+    HashLife life;
+    REQUIRE_THROWS_AS(life.load(parse_macrocell("[M2]\n#R B36/S23\n.*$\n")),
+                      std::invalid_argument);
+    REQUIRE(life.population() == 0);
+}
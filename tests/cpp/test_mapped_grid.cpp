@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/mapped_grid.hpp"
+#include "gol/grid.hpp"
+#include "gol/rle.hpp"
+#include "gol/snapshot.hpp"
+#include <cstdio>
+#include <stdexcept>
+
+using namespace gol;
+
+namespace {
+
+bool same_cells(const MappedGrid& a, const Grid& b) {
+    if (a.width() != b.width() || a.height() != b.height()) return false;
+    for (size_t y = 0; y < b.height(); ++y)
+        for (size_t w = 0; w < (b.width() + 63) / 64; ++w)
+            if (a.data()[y * a.words_per_row() + w] != b.data()[y * b.words_per_row() + w])
+                return false;
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Mapped grids step like grids, in bands of any size", "[mapped_grid]") {
+    std::string path = "test_mapped_grid.golsnap";
+    struct Size {
+        size_t width, height;
+    };
+    for (Size size : {Size{1000, 700}, Size{70, 40}, Size{64, 129}, Size{513, 64}}) {
+        // One tile row per band, then every tile row in one band.
+        for (size_t limit : {size_t(1), MappedGrid::kDefaultResidentLimit}) {
+            Grid grid(size.width, size.height);
+            grid.randomize(0.35, 13);
+            MappedGrid mapped(path, size.width, size.height);
+            mapped.set_resident_limit(limit);
+            mapped.randomize(0.35, 13);
+            REQUIRE(same_cells(mapped, grid));
+            REQUIRE(mapped.population() == grid.population());
+
+            for (int round = 0; round < 4; ++round) {
+                grid.step_n(15);
+                mapped.step_n(15);
+                REQUIRE(same_cells(mapped, grid));
+                REQUIRE(mapped.population() == grid.population());
+            }
+            REQUIRE(mapped.generation() == 60);
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Mapped grids open snapshots and stay loadable", "[mapped_grid]") {
+    std::string path = "test_mapped_open.golsnap";
+    Grid grid(900, 300);
+    grid.randomize(0.3, 4);
+    grid.set_rule(Rule::parse("B36/S23"));
+    grid.step_n(5);
+    save_snapshot(grid, path);
+    {
+        MappedGrid mapped(path);
+        REQUIRE(mapped.generation() == 5);
+        REQUIRE(mapped.rule() == grid.rule());
+        REQUIRE(mapped.population() == grid.population());
+        mapped.step_n(20);
+        mapped.sync();
+    }
+    grid.step_n(20);
+    Grid loaded = load_snapshot(path);
+    REQUIRE(loaded.generation() == 25);
+    REQUIRE(loaded.state_hash() == grid.state_hash());
+
+    save_snapshot(grid, path, true);
+    REQUIRE_THROWS_AS(MappedGrid(path), std::runtime_error);
+    REQUIRE_THROWS_AS(MappedGrid("no_such_dir/x.golsnap", 10, 10), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Mapped grids edit, extract and export like grids", "[mapped_grid]") {
+    std::string path = "test_mapped_edit.golsnap";
+    Grid grid(300, 200);
+    MappedGrid mapped(path, 300, 200);
+    REQUIRE(mapped.population() == 0);
+
+    Grid glider(3, 3);
+    load_rle(glider, "x = 3, y = 3\nbob$2bo$3o!");
+    for (BlitMode mode : {BlitMode::kOr, BlitMode::kXor, BlitMode::kCopy}) {
+        grid.paste(glider, 298, 199, mode);
+        mapped.paste(glider, 298, 199, mode);
+    }
+    grid.set_cell(150, 100, true);
+    mapped.set_cell(150, 100, true);
+    grid.set_cell(151, 100, true);
+    mapped.set_cell(151, 100, true);
+    grid.set_cell(152, 100, true);
+    mapped.set_cell(152, 100, true);
+    REQUIRE(same_cells(mapped, grid));
+    REQUIRE(mapped.get_cell(151, 100));
+    REQUIRE(mapped.population() == grid.population());
+
+    grid.step_n(37);
+    mapped.step_n(37);
+    REQUIRE(same_cells(mapped, grid));
+    REQUIRE(to_rle(mapped) == to_rle(grid));
+    Grid corner = mapped.extract(290, 190, 30, 30);
+    Grid expected = grid.extract(290, 190, 30, 30);
+    REQUIRE(corner.population() == expected.population());
+    REQUIRE(corner.state_hash() == expected.state_hash());
+
+    mapped.clear();
+    REQUIRE(mapped.population() == 0);
+    REQUIRE(mapped.generation() == 0);
+    REQUIRE(!mapped.get_cell(151, 100));
+    mapped.step();
+    REQUIRE(mapped.population() == 0);
+    mapped.sync();
+    REQUIRE(load_snapshot(path).generation() == 1);
+
+    mapped.randomize(0.2, 3);
+    REQUIRE(mapped.generation() == 0);
+    std::remove(path.c_str());
+}
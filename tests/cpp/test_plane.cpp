@@ -0,0 +1,99 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/plane.hpp"
+#include "gol/grid.hpp"
+#include "gol/rle.hpp"
+#include <stdexcept>
+
+using namespace gol;
+
+TEST_CASE("Plane cells across tile edges", "[plane]") {
+    Plane p;
+    p.set_cell(-1, -1, true);
+    p.set_cell(63, 64, true);
+    REQUIRE(p.get_cell(-1, -1));
+    REQUIRE(p.get_cell(63, 64));
+    REQUIRE_FALSE(p.get_cell(0, 0));
+    REQUIRE(p.population() == 2);
+    REQUIRE(p.tile_count() == 2);
+
+    p.set_cell(-1, -1, false);
+    REQUIRE(p.population() == 1);
+    REQUIRE(p.tile_count() == 1);
+}
+
+TEST_CASE("Plane matches Grid away from the torus edges", "[plane]") {
+    Grid grid(300, 300);
+    Plane plane(300, 300);
+    grid.randomize(0.35, 5);
+    plane.randomize(0.35, 5);
+    REQUIRE(plane.population() == grid.population());
+
+    // Clear a 60-cell margin so nothing reaches the torus seam in 40 steps.
+    Grid inner = grid.extract(60, 60, 180, 180);
+    grid.clear();
+    grid.paste(inner, 60, 60);
+    plane.clear();
+    plane.paste(inner, 60, 60);
+
+    grid.step_n(40);
+    plane.step_n(40);
+    REQUIRE(plane.generation() == 40);
+    REQUIRE(plane.population() == grid.population());
+    for (size_t y = 0; y < 300; ++y)
+        for (size_t x = 0; x < 300; ++x)
+            REQUIRE(plane.get_cell(int64_t(x), int64_t(y)) == grid.get_cell(x, y));
+}
+
+TEST_CASE("Plane runs other rules like Grid", "[plane][rule]") {
+    Grid soup(100, 100);
+    soup.randomize(0.4, 9);
+    for (const char* name : {"HighLife", "Seeds", "DayAndNight", "B36/S125"}) {
+        Grid grid(260, 260);
+        grid.set_rule(Rule::parse(name));
+        grid.paste(soup, 80, 80);
+        Plane plane;
+        plane.set_rule(Rule::parse(name));
+        plane.paste(soup, 80, 80);
+
+        grid.step_n(30);
+        plane.step_n(30);
+        REQUIRE(plane.population() == grid.population());
+        for (size_t y = 0; y < 260; ++y)
+            for (size_t x = 0; x < 260; ++x)
+                REQUIRE(plane.get_cell(int64_t(x), int64_t(y)) == grid.get_cell(x, y));
+    }
+
+    Plane plane;
+    load_rle(plane, "x = 3, y = 1, rule = HighLife\n3o!");
+    REQUIRE(plane.rule() == Rule::parse("B36/S23"));
+    REQUIRE_THROWS_AS(plane.set_rule(Rule::parse("B0/S8")), std::invalid_argument);
+    REQUIRE_THROWS_AS(load_rle(plane, "x = 1, y = 1, rule = B0/S8\no!"), RLEError);
+    REQUIRE(plane.rule() == Rule::parse("B36/S23"));
+}
+
+TEST_CASE("Plane lets a glider fly without wrapping", "[plane]") {
+    Plane p(16, 16);
+    // Glider heading north-west.
+    p.set_cell(0, 0, true);
+    p.set_cell(1, 0, true);
+    p.set_cell(2, 0, true);
+    p.set_cell(0, 1, true);
+    p.set_cell(1, 2, true);
+
+    p.step_n(4000);
+    REQUIRE(p.population() == 5);
+    REQUIRE(p.tile_count() <= 4);
+    auto box = p.bounding_box();
+    REQUIRE(box.x == -1000);
+    REQUIRE(box.y == -1000);
+    REQUIRE(box.width == 3);
+    REQUIRE(box.height == 3);
+
+    // A lone cell dies and its tile goes with it.
+    p.clear();
+    p.set_cell(5, 5, true);
+    p.step();
+    REQUIRE(p.population() == 0);
+    REQUIRE(p.tile_count() == 0);
+    REQUIRE(p.memory_usage() < 4096);
+}
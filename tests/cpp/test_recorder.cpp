@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/recorder.hpp"
+#include "gol/grid.hpp"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace gol;
+
+namespace {
+
+bool same_cells(const Grid& a, const Grid& b) {
+    if (a.width() != b.width() || a.height() != b.height()) return false;
+    for (size_t i = 0; i < a.data_size(); ++i)
+        if (a.data()[i] != b.data()[i]) return false;
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Recordings seek to any generation", "[recorder]") {
+    std::string path = "test_run.golrec";
+    Grid grid(300, 130);
+    grid.randomize(0.3, 11);
+    std::vector<Grid> history{grid};
+    {
+        Recorder recorder(path, grid, 16);
+        grid.set_recorder(&recorder);
+        for (int i = 0; i < 40; ++i) {
+            grid.step();
+            history.push_back(grid);
+        }
+        grid.step_n(5);  // stepped one generation at a time while recording
+        grid.set_cell(7, 7, true);
+        grid.step();
+        history.push_back(grid);  // generation 46, edit included
+        grid.set_recorder(nullptr);
+    }
+
+    Player player(path);
+    REQUIRE(player.first_generation() == 0);
+    REQUIRE(player.last_generation() == 46);
+    REQUIRE(player.keyframes() == 3);
+    for (size_t g : {25, 3, 4, 33, 0, 40, 17, 16}) {
+        const Grid& seen = player.seek(g);
+        REQUIRE(seen.generation() == g);
+        REQUIRE(same_cells(seen, history[g]));
+    }
+    REQUIRE(same_cells(player.seek(46), history[41]));
+    REQUIRE(same_cells(player.seek(1000), history[41]));
+    // The played board steps on like the original.
+    Grid next = player.grid();
+    Grid expect = history[41];
+    next.step();
+    expect.step();
+    REQUIRE(same_cells(next, expect));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Recordings grow with activity, not board size", "[recorder]") {
+    std::string path = "test_quiet.golrec";
+    Grid grid(4096, 4096);
+    grid.set_cell(101, 100, true);  // a blinker
+    grid.set_cell(101, 101, true);
+    grid.set_cell(101, 102, true);
+    Recorder recorder(path, grid, 1000);
+    grid.set_recorder(&recorder);
+    size_t start = recorder.bytes_written();
+    grid.step_n(100);
+    REQUIRE(recorder.bytes_written() - start < 100 * 64);  // the board is 2 MiB
+    recorder.close();
+
+    Player player(path);
+    REQUIRE(player.seek(99).population() == 3);
+    REQUIRE(player.grid().get_cell(100, 101));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Copies of a recorded grid are not recorded", "[recorder]") {
+    std::string path = "test_copy.golrec";
+    Grid grid(100, 80);
+    grid.randomize(0.35, 9);
+    Grid after(1, 1);
+    {
+        Recorder recorder(path, grid, 64);
+        grid.set_recorder(&recorder);
+        grid.step_n(3);
+        Grid copy = grid;
+        size_t bytes = recorder.bytes_written();
+        copy.step_n(4);
+        REQUIRE(recorder.bytes_written() == bytes);
+        grid = copy;  // detaches the recorder
+        grid.step();
+        REQUIRE(recorder.bytes_written() == bytes);
+
+        // Handed another grid, the recorder follows it from a keyframe.
+        copy.set_recorder(&recorder);
+        recorder.record(copy);
+        copy.step_n(2);
+        after = copy;
+        REQUIRE_THROWS_AS(recorder.record(Grid(50, 80)), std::invalid_argument);
+    }
+    Player player(path);
+    REQUIRE(player.last_generation() == 9);
+    REQUIRE(same_cells(player.seek(9), after));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Truncated and restarted recordings still play", "[recorder]") {
+    std::string path = "test_cut.golrec";
+    Grid grid(200, 100);
+    grid.randomize(0.4, 3);
+    Grid at_ten(1, 1);
+    {
+        Recorder recorder(path, grid, 8);
+        grid.set_recorder(&recorder);
+        grid.step_n(30);
+        // Going back in time starts the recording over.
+        grid.clear();
+        grid.randomize(0.4, 5);
+        recorder.record(grid);
+        grid.step_n(10);
+        at_ten = grid;
+        grid.step_n(10);
+    }
+    {
+        std::string bytes;
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), {});
+        bytes.resize(bytes.size() - 10);
+        std::ofstream(path, std::ios::binary) << bytes;
+    }
+    Player player(path);
+    REQUIRE(player.first_generation() == 0);
+    REQUIRE(player.last_generation() == 19);
+    REQUIRE(same_cells(player.seek(10), at_ten));
+
+    REQUIRE_THROWS_AS(Player("no/such/file"), std::runtime_error);
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "x = 3, y = 3\n3o!\n";
+    }
+    REQUIRE_THROWS_AS(Player(path), std::runtime_error);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,60 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/render.hpp"
+#include "gol/grid.hpp"
+#include <stdexcept>
+#include <string>
+
+using namespace gol;
+
+namespace {
+
+// Per-cell reference for render_halfblock.
+std::string reference_line(const Grid& g, size_t x, size_t y, size_t w, size_t zoom) {
+    auto lit = [&](size_t cx, size_t cy) {
+        for (size_t dy = 0; dy < zoom; ++dy)
+            for (size_t dx = 0; dx < zoom; ++dx)
+                if (cx + dx < g.width() && cy + dy < g.height() && g.get_cell(cx + dx, cy + dy))
+                    return true;
+        return false;
+    };
+    static const char* glyphs[4] = {" ", "▀", "▄", "█"};
+    std::string out;
+    for (size_t c = 0; c < w; ++c) {
+        size_t cx = x + c * zoom;
+        out += glyphs[lit(cx, y) | lit(cx, y + zoom) << 1];
+    }
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("Half-block lines match the cells", "[render]") {
+    Grid g(300, 90);
+    g.randomize(0.2, 5);
+    for (size_t zoom : {1, 2, 3, 8, 70}) {
+        for (size_t x : {0, 1, 63, 64, 250}) {
+            for (size_t y : {0, 3, 80}) {
+                auto lines = render_halfblock(g, x, y, 90, 12, zoom);
+                REQUIRE(lines.size() == 12);
+                for (size_t i = 0; i < lines.size(); ++i)
+                    REQUIRE(lines[i] == reference_line(g, x, y + 2 * i * zoom, 90, zoom));
+            }
+        }
+    }
+}
+
+TEST_CASE("Half-block edges and blank regions", "[render]") {
+    Grid g(10, 3);
+    g.set_cell(0, 0, true);
+    g.set_cell(9, 1, true);
+    g.set_cell(4, 2, true);
+    auto lines = render_halfblock(g, 0, 0, 12, 3);
+    REQUIRE(lines[0] == "▀        ▄  ");
+    REQUIRE(lines[1] == "    ▀       ");
+    REQUIRE(lines[2] == std::string(12, ' '));
+    // Far outside the board, and huge zooms, stay blank without overflow.
+    REQUIRE(render_halfblock(g, SIZE_MAX - 5, SIZE_MAX - 5, 4, 2, 1000)[1] == "    ");
+    REQUIRE(render_halfblock(g, 0, 0, 3, 1, SIZE_MAX)[0] == "▀  ");  // all in the top block
+    REQUIRE(render_halfblock(g, 0, 0, 0, 2).at(1).empty());
+    REQUIRE_THROWS_AS(render_halfblock(g, 0, 0, 5, 5, 0), std::invalid_argument);
+}
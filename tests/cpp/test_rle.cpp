@@ -1,6 +1,12 @@
 #include <catch2/catch_test_macros.hpp>
 #include "gol/rle.hpp"
 #include "gol/grid.hpp"
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <stdexcept>
 
 using namespace gol;
 
@@ -58,3 +64,184 @@ TEST_CASE("Parse blinker RLE", "[rle]") {
     REQUIRE(pattern.height == 1);
     REQUIRE(pattern.alive_cells.size() == 3);
 }
+
+TEST_CASE("RLE rule header is parsed and applied", "[rle]") {
+    std::string rle = "x = 3, y = 1, rule = B36/S23\n3o!";
+    RLEPattern p = parse_rle(rle);
+    REQUIRE(p.rule == "B36/S23");
+    REQUIRE(p.width == 3);
+    REQUIRE(parse_rle("x = 3, y = 1\n3o!").rule.empty());
+
+    Grid g(10, 10);
+    load_rle(g, rle, 2, 2);
+    REQUIRE(g.rule() == Rule::parse("B36/S23"));
+    REQUIRE(to_rle(g).find("rule = B36/S23") != std::string::npos);
+
+    Grid plain(10, 10);
+    load_rle(plain, "x = 3, y = 1\n3o!");
+    REQUIRE(plain.rule() == Rule());
+    REQUIRE_THROWS_AS(load_rle(plain, "x = 1, y = 1, rule = B9/S\no!"), std::invalid_argument);
+}
+
+TEST_CASE("RLE errors carry line and column", "[rle]") {
+    auto where = [](const std::string& rle) {
+        try {
+            parse_rle(rle);
+        } catch (const RLEError& e) {
+            return std::make_pair(e.line(), e.column());
+        }
+        return std::make_pair(size_t(0), size_t(0));
+    };
+    REQUIRE(where("x = 3, y = 3\nbo$2bz!") == std::make_pair(size_t(2), size_t(6)));
+    REQUIRE(where("#C ok\nx = a, y = 3\no!") == std::make_pair(size_t(2), size_t(5)));
+    REQUIRE(where("x = 3\no!") == std::make_pair(size_t(1), size_t(1)));
+    // Only loading into a grid needs the rule to be one the engine runs.
+    REQUIRE(parse_rle("x = 1, y = 1, rule = LifeHistory\no!").rule == "LifeHistory");
+    Grid g(5, 5);
+    try {
+        load_rle(g, "#C x\nx = 1, y = 1, rule = B2-a/S12\no!");
+        FAIL("load_rle took an unsupported rule");
+    } catch (const RLEError& e) {
+        REQUIRE(std::make_pair(e.line(), e.column()) == std::make_pair(size_t(2), size_t(22)));
+    }
+    REQUIRE(g.population() == 0);
+    REQUIRE(where("x = 1, y = 1\n99999999999999999o!").first == 2);
+    // Anything after '!' is ignored.
+    REQUIRE(where("x = 1, y = 1\no!zz") == std::make_pair(size_t(0), size_t(0)));
+}
+
+TEST_CASE("RLE files stream straight into grid words", "[rle]") {
+    // Large enough to cross the loader's 16 MiB mapping slices.
+    Grid source(4800, 4800);
+    source.randomize(0.5, 3);
+    source.set_rule(Rule::parse("B36/S23"));
+    std::string rle = to_rle(source);
+    REQUIRE(rle.size() > (size_t(16) << 20));
+
+    std::string path = "test_rle_stream.rle";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "#N random\n" << rle;
+    }
+
+    Grid loaded = read_rle_file(path);
+    REQUIRE(loaded.width() == 4800);
+    REQUIRE(loaded.rule() == source.rule());
+    REQUIRE(loaded.population() == source.population());
+    for (size_t y = 0; y < 4800; ++y)
+        for (size_t w = 0; w < loaded.words_per_row(); ++w)
+            REQUIRE(loaded.data()[y * loaded.words_per_row() + w] ==
+                    source.data()[y * source.words_per_row() + w]);
+
+    Grid offset(100, 100);
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "x = 70, y = 2\r\n70o$3b2o!\r\n";
+    }
+    load_rle_file(offset, path, 50, 98);
+    REQUIRE(offset.population() == 52);  // clipped at the right edge
+    REQUIRE(offset.get_cell(99, 98));
+    REQUIRE(offset.get_cell(53, 99));
+    REQUIRE_FALSE(offset.get_cell(52, 99));
+    std::remove(path.c_str());
+
+    REQUIRE_THROWS_AS(read_rle_file("no/such/file.rle"), std::runtime_error);
+}
+
+TEST_CASE("Chunked RLE decode matches one sequential pass", "[rle][threads]") {
+    Grid source(2000, 2000);
+    source.randomize(0.3, 5);
+    std::string rle = to_rle(source);
+    size_t body = rle.find('\n') + 1;
+    std::string one_line = rle.substr(0, body);
+    for (size_t i = body; i < rle.size(); ++i)
+        if (rle[i] != '\n') one_line += rle[i];
+    std::string commented = rle;
+    commented.insert(commented.size() / 2, "\n#C mid-body $ comment\n");
+    std::string stopped = rle;
+    stopped.insert(stopped.rfind('$', stopped.size() / 3), "!zzz\n");
+    std::string broken = rle;
+    broken[broken.size() - broken.size() / 5] = 'z';
+
+    // Loads with n threads; the result is the grid or the error position.
+    auto load = [](const std::string& text, size_t threads) {
+        Grid::set_num_threads(threads);
+        Grid grid(2000, 2000);
+        std::pair<size_t, size_t> error{0, 0};
+        try {
+            load_rle(grid, text, 0, 0);
+        } catch (const RLEError& e) {
+            error = {e.line(), e.column()};
+        }
+        return std::make_pair(grid, error);
+    };
+    size_t original = Grid::num_threads();
+    for (const std::string* text : {&rle, &one_line, &commented, &stopped, &broken}) {
+        auto expected = load(*text, 1);
+        auto chunked = load(*text, 4);
+        REQUIRE(chunked.second == expected.second);
+        REQUIRE(chunked.first.population() == expected.first.population());
+        REQUIRE(chunked.first.state_hash() == expected.first.state_hash());
+        for (size_t y = 0; y < 2000; ++y)
+            for (size_t w = 0; w < source.words_per_row(); ++w)
+                REQUIRE(chunked.first.data()[y * source.words_per_row() + w] ==
+                        expected.first.data()[y * source.words_per_row() + w]);
+        if (text == &rle || text == &one_line) {
+            REQUIRE(chunked.first.state_hash() == source.state_hash());
+            Grid a = chunked.first, b = source;
+            a.step_n(3);
+            b.step_n(3);
+            REQUIRE(a.state_hash() == b.state_hash());
+        }
+    }
+    REQUIRE(load(broken, 1).second.first > 0);
+    Grid::set_num_threads(original);
+}
+
+TEST_CASE("RLE writer merges blank rows and wraps lines", "[rle]") {
+    Grid g(200, 10);
+    g.set_cell(0, 0, true);
+    g.set_cell(130, 4, true);
+    g.set_span(60, 4, 10, true);
+    REQUIRE(to_rle(g) == "x = 200, y = 10, rule = B3/S23\no4$60b10o60bo!");
+    REQUIRE(to_rle(Grid(5, 5)) == "x = 5, y = 5, rule = B3/S23\n!");
+
+    Grid soup(300, 200);
+    soup.randomize(0.4, 9);
+    std::string rle = to_rle(soup);
+    std::istringstream lines(rle);
+    std::string line;
+    while (std::getline(lines, line))
+        REQUIRE(line.size() <= 70);
+    Grid back(300, 200);
+    load_rle(back, rle);
+    for (size_t y = 0; y < 200; ++y)
+        for (size_t x = 0; x < 300; ++x)
+            REQUIRE(back.get_cell(x, y) == soup.get_cell(x, y));
+}
+
+TEST_CASE("RLE writer streams to files and descriptors", "[rle]") {
+    Grid soup(1000, 700);
+    soup.randomize(0.3, 4);
+    std::string expected = to_rle(soup);
+    REQUIRE(expected.size() > (size_t(64) << 10));  // several buffer flushes
+
+    std::string path = "test_rle_writer.rle";
+    save_rle_file(soup, path);
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        REQUIRE(text.str() == expected);
+    }
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_TRUNC);
+    REQUIRE(fd >= 0);
+    write_rle(soup, fd);
+    ::close(fd);
+    Grid back = read_rle_file(path);
+    REQUIRE(back.population() == soup.population());
+    std::remove(path.c_str());
+
+    REQUIRE_THROWS_AS(save_rle_file(soup, "no/such/dir/x.rle"), std::runtime_error);
+}
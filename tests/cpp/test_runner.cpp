@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/runner.hpp"
+#include "gol/grid.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace gol;
+
+namespace {
+
+bool same_cells(const Grid& a, const Grid& b) {
+    if (a.width() != b.width() || a.height() != b.height()) return false;
+    for (size_t i = 0; i < a.data_size(); ++i)
+        if (a.data()[i] != b.data()[i]) return false;
+    return true;
+}
+
+Grid soup() {
+    Grid g(300, 200);
+    g.randomize(0.3, 21);
+    return g;
+}
+
+} // namespace
+
+TEST_CASE("A paused runner steps on request", "[runner]") {
+    SimulationRunner runner(soup(), 0, true);
+    REQUIRE(runner.paused());
+    runner.step(40);
+    runner.step(60);
+    auto snap = runner.wait_for(100);
+    REQUIRE(snap->generation() == 100);
+    Grid reference = soup();
+    reference.step_n(100);
+    REQUIRE(same_cells(snap.grid(), reference));
+    REQUIRE(runner.generation() == 100);
+    REQUIRE(runner.generations_per_second() == 0);
+
+    // Edits run between steps and are published at once.
+    runner.edit([](Grid& g) { g.clear(); g.set_cell(5, 5, true); });
+    REQUIRE(runner.snapshot()->population() == 1);
+    REQUIRE_THROWS_AS(runner.edit([](Grid&) { throw std::runtime_error("no"); }),
+                      std::runtime_error);
+    Grid last = runner.stop();
+    REQUIRE(last.population() == 1);
+    REQUIRE_THROWS_AS(runner.edit([](Grid&) {}), std::logic_error);
+    REQUIRE(runner.snapshot()->population() == 1);
+}
+
+TEST_CASE("A running runner publishes while readers hold copies", "[runner]") {
+    SimulationRunner runner(soup());
+    auto first = runner.wait_for(20);
+    uint64_t held_hash = first->state_hash();
+    uint64_t held_generation = first->generation();
+    auto second = runner.wait_for(held_generation + 5);
+    REQUIRE(second->generation() > held_generation);
+    // With two slots held the third keeps going round.
+    auto later = runner.wait_for(second->generation() + 5);
+    REQUIRE(later->generation() > second->generation());
+    later.release();
+    REQUIRE(first->state_hash() == held_hash);
+    REQUIRE(first->generation() == held_generation);
+
+    runner.pause();
+    auto paused = runner.wait_for(~uint64_t(0));
+    Grid reference = soup();
+    reference.step_n(paused->generation());
+    REQUIRE(same_cells(paused.grid(), reference));
+    first.release();
+    second.release();
+    paused.release();
+
+    runner.resume();
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    REQUIRE(runner.generations_per_second() > 0);
+    Grid last = runner.stop();
+    REQUIRE(last.generation() >= runner.generation());
+}
+
+TEST_CASE("A paced runner keeps to its rate", "[runner]") {
+    SimulationRunner runner(soup(), 100);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    runner.pause();
+    uint64_t generation = runner.wait_for(~uint64_t(0))->generation();
+    REQUIRE(generation >= 30);
+    REQUIRE(generation <= 70);
+    REQUIRE(runner.rate() == 100);
+}
@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gol/snapshot.hpp"
+#include "gol/grid.hpp"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+using namespace gol;
+
+namespace {
+
+size_t file_size(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return size_t(in.tellg());
+}
+
+bool same_cells(const Grid& a, const Grid& b) {
+    if (a.width() != b.width() || a.height() != b.height()) return false;
+    for (size_t i = 0; i < a.data_size(); ++i)
+        if (a.data()[i] != b.data()[i]) return false;
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Snapshots restore cells, generation and rule", "[snapshot]") {
+    std::string path = "test_snapshot.golsnap";
+    for (bool sparse : {false, true}) {
+        Grid grid(700, 333);
+        grid.randomize(0.3, 9);
+        grid.set_rule(Rule::parse("B36/S23"));
+        grid.step_n(17);
+        save_snapshot(grid, path, sparse);
+
+        Grid loaded = load_snapshot(path);
+        REQUIRE(same_cells(loaded, grid));
+        REQUIRE(loaded.generation() == 17);
+        REQUIRE(loaded.rule() == grid.rule());
+        REQUIRE(loaded.population() == grid.population());
+        REQUIRE(loaded.state_hash() == grid.state_hash());
+        grid.step_n(9);
+        loaded.step_n(9);
+        REQUIRE(same_cells(loaded, grid));
+    }
+
+    // Sparse files hold only the tiles with live cells.
+    Grid empty(4096, 4096);
+    empty.set_cell(4000, 10, true);
+    save_snapshot(empty, path, false);
+    REQUIRE(file_size(path) == 4096 + empty.data_size() * 8);
+    save_snapshot(empty, path, true);
+    REQUIRE(file_size(path) <= 3 * 4096 + 64 * 64);
+    Grid back = load_snapshot(path);
+    REQUIRE(back.population() == 1);
+    REQUIRE(back.get_cell(4000, 10));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Checkpoints let a run resume where it stopped", "[snapshot]") {
+    std::string path = "test_checkpoint.golsnap";
+    Grid grid(300, 200);
+    grid.randomize(0.35, 4);
+    Grid reference = grid;
+    grid.set_checkpoint(path, 64);
+    grid.step_n(150);
+    grid.step_n(30);  // crosses 128 on the way to 180
+
+    Grid resumed = load_snapshot(path);
+    REQUIRE(resumed.generation() == 128);
+    resumed.step_n(52);
+    reference.step_n(180);
+    REQUIRE(same_cells(resumed, reference));
+    REQUIRE(same_cells(grid, reference));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Bad snapshots are rejected", "[snapshot]") {
+    std::string path = "test_bad.golsnap";
+    REQUIRE_THROWS_AS(load_snapshot("no/such/file"), std::runtime_error);
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "x = 3, y = 3\n3o!\n";
+    }
+    REQUIRE_THROWS_AS(load_snapshot(path), std::runtime_error);
+
+    Grid grid(200, 200);
+    grid.randomize(0.5, 1);
+    save_snapshot(grid, path);
+    {
+        std::string bytes;
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), {});
+        bytes.resize(bytes.size() / 2);
+        std::ofstream(path, std::ios::binary) << bytes;
+    }
+    REQUIRE_THROWS_AS(load_snapshot(path), std::runtime_error);
+    std::remove(path.c_str());
+}
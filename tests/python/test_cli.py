@@ -1,5 +1,6 @@
 """Tests for the CLI protocol."""
 
+import json
 import sys
 import os
 
@@ -48,6 +49,51 @@ def test_reset():
     assert cli.grid.population == 0
 
 
+def test_run_and_stop(capsys):
+    cli = GameCLI(use_json=True)
+    cli.handle("new 50 50")
+    cli.handle("randomize 0.3")
+    cli.handle("run")
+    assert cli.grid is None
+    cli.handle("step 5")  # refused while running
+    cli.runner.wait_for(5)
+    # Paused, with the board published by an empty edit, reads see the
+    # runner's latest snapshot.
+    cli.runner.pause()
+    cli.runner.edit(lambda grid: None)
+    capsys.readouterr()
+    cli.handle("population")
+    resp = json.loads(capsys.readouterr().out)
+    with cli.runner.snapshot() as snap:
+        assert resp["data"] == snap.population
+    cli.handle("stop")
+    assert cli.runner is None
+    assert cli.grid.generation > 0
+
+
+def test_run_refused_while_recording(tmp_path):
+    cli = GameCLI(use_json=True)
+    cli.handle("new 50 50")
+    cli.handle("randomize 0.3")
+    cli.handle(f"record {tmp_path / 'run.golrec'} 16")
+    cli.handle("run")
+    assert cli.runner is None
+    cli.handle("step 3")
+    cli.handle("record off")
+    cli.handle("run")
+    assert cli.runner is not None
+    cli.handle("stop")
+
+
+def test_memory():
+    cli = GameCLI(use_json=True)
+    cli.handle("new 4096 4096")
+    cli.handle("memory")
+    cli.handle("run")
+    assert cli.handle("memory") == True
+    cli.handle("stop")
+
+
 def test_quit():
     cli = GameCLI()
     assert cli.handle("quit") == False
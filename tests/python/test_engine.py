@@ -49,6 +49,57 @@ def test_numpy_packed():
     assert packed.dtype.name == "uint64"
 
 
+def test_numpy_round_trip():
+    np = pytest.importorskip("numpy")
+    cells = np.random.default_rng(3).random((70, 130)) < 0.4
+    g = gol_engine.Grid.from_numpy(cells)
+    assert (g.width, g.height) == (130, 70)
+    assert (g.to_numpy() == cells).all()
+    assert g.population == cells.sum()
+    # Other dtypes and strided views count nonzero as alive.
+    assert (gol_engine.Grid.from_numpy(cells.T * 2.5).to_numpy() == cells.T).all()
+    assert (gol_engine.Grid.from_numpy(cells[::-1, ::2].astype(np.uint8)).to_numpy()
+            == cells[::-1, ::2]).all()
+
+    # Packed words are copies; load_packed writes them back, also after a
+    # step has moved the cells to the other buffer.
+    g.step()
+    words = g.to_numpy_packed().reshape(70, g.words_per_row)
+    words[:] = 0
+    assert g.population > 0
+    words[5, 0] = 0b111
+    words[6, 2] = ~np.uint64(3)  # cells past the width are dropped
+    words[6, 3] = 1
+    g.load_packed(words)
+    assert g.population == 3
+    g.step()
+    assert g.to_numpy()[4:7, 1].all()
+    words[:] = 0
+    assert g.population == 3
+
+
+def test_render_halfblock():
+    g = gol_engine.Grid(10, 3)
+    g.set_cell(0, 0, True)
+    g.set_cell(9, 1, True)
+    g.set_cell(4, 2, True)
+    assert g.render_halfblock(0, 0, 12, 2) == ["\u2580        \u2584  ", "    \u2580       "]
+    assert g.render_halfblock(0, 0, 3, 1, zoom=4) == ["\u2580\u2580\u2580"]
+    with pytest.raises(ValueError):
+        g.render_halfblock(0, 0, 1, 1, zoom=0)
+
+
+def test_changed_since():
+    g = gol_engine.Grid(1500, 200)
+    for x in range(1000, 1003):
+        g.set_cell(x, 150, True)
+    g.step()
+    seen = g.change_count
+    assert g.changed_since(seen) == []
+    g.step()
+    assert g.changed_since(seen) == [(512, 149, 512, 3)]
+
+
 def test_rle():
     g = gol_engine.Grid(20, 20)
     gol_engine.load_rle(g, "x = 3, y = 1\n3o!", 5, 5)
@@ -72,6 +123,19 @@ def test_to_rle():
     assert "!" in rle
 
 
+def test_save_rle_file(tmp_path):
+    g = gol_engine.Grid(100, 100)
+    g.randomize(0.3, 5)
+    path = tmp_path / "soup.rle"
+    gol_engine.save_rle_file(g, str(path))
+    text = path.read_text()
+    assert text == gol_engine.to_rle(g)
+    assert max(len(line) for line in text.splitlines()) <= 70
+    with open(path, "w") as f:
+        gol_engine.write_rle(g, f.fileno())
+    assert gol_engine.read_rle_file(str(path)).population == g.population
+
+
 def test_ascii():
     g = gol_engine.Grid(3, 3)
     g.set_cell(1, 1, True)
@@ -81,5 +145,255 @@ def test_ascii():
     assert lines[1] == ".#."
 
 
+def test_kernel_name():
+    name = gol_engine.Grid.kernel_name()
+    assert name in gol_engine.Grid.available_kernels()
+    assert gol_engine.Grid.set_kernel("scalar")
+    assert gol_engine.Grid.kernel_name() == "scalar"
+    assert gol_engine.Grid.set_kernel(name)
+
+
+def test_num_threads():
+    original = gol_engine.Grid.num_threads()
+    gol_engine.Grid.set_num_threads(2)
+    assert gol_engine.Grid.num_threads() == 2
+    g = gol_engine.Grid(200, 200)
+    g.randomize(0.3, 1)
+    g.step_n(5)
+    gol_engine.Grid.set_num_threads(original)
+
+
+def test_hashlife():
+    life = gol_engine.HashLife()
+    life.load_pattern(gol_engine.parse_rle("x = 3, y = 3\nbo$2bo$3o!"))
+    life.step(2 ** 30)
+    assert life.generation == 2 ** 30
+    assert life.population == 5
+    x, y, w, h = life.bounding_box()
+    assert (x, y, w, h) == (2 ** 28, 2 ** 28, 3, 3)
+    g = life.to_grid()
+    assert g.population == 5
+
+
+def test_plane():
+    p = gol_engine.Plane(20, 20)
+    gol_engine.load_rle(p, "x = 3, y = 3\nbo$2bo$3o!", 0, 0)
+    p.step_n(400)
+    assert p.population == 5
+    assert p.bounding_box() == (100, 100, 3, 3)
+    assert p.tile_count <= 4
+    assert p.to_ascii().count("#") == 0
+    gol_engine.load_rle(p, "x = 3, y = 1, rule = HighLife\n3o!", 0, 0)
+    assert p.rule == "B36/S23"
+
+
+def test_rule():
+    g = gol_engine.Grid(10, 10)
+    assert g.rule == "B3/S23"
+    g.rule = "b2/s"
+    assert g.rule == "B2/S"
+    with pytest.raises(ValueError):
+        g.rule = "B9/S"
+    gol_engine.load_rle(g, "x = 3, y = 1, rule = HighLife\n3o!", 0, 0)
+    assert g.rule == "B36/S23"
+    assert gol_engine.parse_rle("x = 1, y = 1, rule = B2/S\no!").rule == "B2/S"
+
+
+def test_grid_batch():
+    batch = gol_engine.GridBatch(50, 32, 32)
+    assert len(batch) == 50
+    batch.randomize(0.35, list(range(1, 51)))
+    g = gol_engine.Grid(32, 32)
+    g.randomize(0.35, 7)
+    assert (batch.to_numpy()[6] == g.to_numpy()).all()
+
+    batch.step_n(30)
+    g.step_n(30)
+    assert batch.populations()[6] == g.population
+    assert batch.populations().shape == (50,)
+    assert batch.stable().dtype == bool
+    packed = batch.to_numpy_packed()
+    assert packed.shape[:2] == (32, 1)
+    before = packed.copy()
+    batch.step()
+    assert (packed == before).all()
+    g.step()
+    assert (batch.to_numpy_packed()[:, 0, 6] == g.to_numpy_packed().reshape(32, -1)[:, 0]).all()
+
+
+def test_run_until_stable():
+    g = gol_engine.Grid(20, 20)
+    for x in range(5, 8):
+        g.set_cell(x, 5, True)
+    h = g.state_hash()
+    s = g.run_until_stable(100)
+    assert s.settled
+    assert (s.period, s.start) == (2, 0)
+    assert g.generation == 4
+    assert g.state_hash() == h
+
+
+def test_rle_file(tmp_path):
+    path = tmp_path / "glider.rle"
+    path.write_text("#N Glider\nx = 3, y = 3, rule = B3/S23\nbo$2bo$3o!\n")
+    g = gol_engine.read_rle_file(str(path))
+    assert (g.width, g.height, g.population) == (3, 3, 5)
+    big = gol_engine.Grid(10, 10)
+    gol_engine.load_rle_file(big, str(path), 4, 4)
+    assert big.get_cell(5, 4)
+    with pytest.raises(gol_engine.RLEError, match="line 2, column 3"):
+        gol_engine.parse_rle("x = 3, y = 3\nbo?!")
+    with pytest.raises(ValueError):
+        gol_engine.parse_rle("x = 3, y = 3\nbo?!")
+
+
+def test_macrocell():
+    mc = gol_engine.parse_macrocell("[M2] (golly 4.2)\n#R B3/S23\n.*$..*$***$\n4 0 0 0 1\n")
+    assert (mc.rule, mc.level, len(mc)) == ("B3/S23", 4, 2)
+    life = gol_engine.HashLife()
+    life.load_macrocell(mc)
+    assert life.bounding_box() == (0, 0, 3, 3)
+    p = gol_engine.Plane(20, 20)
+    gol_engine.load_macrocell(p, mc, 5, 5)
+    assert p.population == 5
+    g = gol_engine.Grid(64, 64)
+    g.set_cell(1, 2, True)
+    text = gol_engine.to_macrocell(g)
+    assert text.startswith("[M2]")
+    assert gol_engine.to_macrocell(life).startswith("[M2]")
+    with pytest.raises(gol_engine.MacrocellError, match="line 2"):
+        gol_engine.parse_macrocell("[M2]\n9 1 2 3 4\n")
+
+
+def test_snapshot(tmp_path):
+    g = gol_engine.Grid(300, 200)
+    g.randomize(0.3, 2)
+    g.rule = "B36/S23"
+    g.step_n(7)
+    path = str(tmp_path / "run.golsnap")
+    gol_engine.save_snapshot(g, path, sparse=True)
+    back = gol_engine.load_snapshot(path)
+    assert (back.generation, back.rule, back.state_hash()) == (7, "B36/S23", g.state_hash())
+    g.set_checkpoint(path, 10)
+    g.step_n(25)
+    assert gol_engine.load_snapshot(path).generation == 30
+    with pytest.raises(RuntimeError):
+        gol_engine.load_snapshot(str(tmp_path / "missing"))
+
+
+def test_recording(tmp_path):
+    g = gol_engine.Grid(200, 100)
+    g.randomize(0.3, 6)
+    path = str(tmp_path / "run.golrec")
+    rec = gol_engine.Recorder(path, g, 8)
+    g.set_recorder(rec)
+    hashes = [g.state_hash()]
+    for _ in range(20):
+        g.step()
+        hashes.append(g.state_hash())
+    g.set_recorder(None)
+    rec.close()
+    player = gol_engine.Player(path)
+    assert (player.first_generation, player.last_generation, player.keyframes) == (0, 20, 3)
+    for gen in (13, 2, 20, 9):
+        assert player.seek(gen).state_hash() == hashes[gen]
+    with pytest.raises(RuntimeError):
+        gol_engine.Player(str(tmp_path / "missing"))
+
+
+def test_low_memory():
+    g = gol_engine.Grid(300, 200)
+    g.randomize(0.4, 2)
+    low = gol_engine.Grid(300, 200)
+    low.low_memory = True
+    low.randomize(0.4, 2)
+    g.step_n(20)
+    low.step_n(20)
+    assert low.low_memory
+    assert low.state_hash() == g.state_hash()
+
+
+def test_symmetric_randomize():
+    g = gol_engine.Grid(64, 64)
+    g.randomize(0.5, 3, gol_engine.Symmetry.D8)
+    cells = g.to_numpy()
+    assert (cells == cells.T).all()
+    assert (cells == cells[::-1, ::-1]).all()
+
+
+def test_paste_modes():
+    g = gol_engine.Grid(100, 100)
+    p = gol_engine.Grid(3, 1)
+    p.set_cell(0, 0, True)
+    g.paste(p, 98, 0)
+    assert g.get_cell(98, 0) and not g.get_cell(0, 0)
+    g.paste(p, 98, 0, gol_engine.BlitMode.XOR)
+    assert g.population == 0
+    g.paste(p, 98, 0, gol_engine.BlitMode.COPY)
+    assert g.extract(98, 0, 3, 1).population == 1
+
+
+def test_simulation_runner():
+    g = gol_engine.Grid(100, 100)
+    g.randomize(0.3, 8)
+    runner = gol_engine.SimulationRunner(g, paused=True)
+    runner.step(30)
+    with runner.wait_for(30) as snap:
+        assert snap.generation == 30
+        g.step_n(30)
+        assert snap.state_hash() == g.state_hash()
+    runner.edit(lambda grid: grid.clear())
+    assert runner.snapshot().population == 0
+    runner.resume()
+    assert runner.wait_for(50).generation >= 50
+    assert runner.stop().generation >= 50
+
+
+def test_simulation_runner_replace():
+    g = gol_engine.Grid(100, 100)
+    g.randomize(0.3, 8)
+    runner = gol_engine.SimulationRunner(g, paused=True)
+    runner.step(20)
+    with runner.wait_for(20) as snap:
+        seen = snap.change_count
+    runner.replace(gol_engine.Grid(40, 30))
+    with runner.snapshot() as snap:
+        assert (snap.width, snap.height) == (40, 30)
+        assert snap.population == 0 and snap.generation == 0
+        assert snap.change_count > seen
+        assert sum(w * h for _, _, w, h in snap.changed_since(seen)) == 40 * 30
+    runner.stop()
+
+
+def test_arena():
+    gol_engine.trim_arena()
+    for _ in range(2):
+        g = gol_engine.Grid(4096, 2048)
+        g.randomize(0.3, 4)
+        stats = gol_engine.arena_stats()
+        assert stats.mapped >= 2 * 4096 * 2048 // 8
+        assert stats.huge <= stats.mapped
+        del g
+    assert gol_engine.arena_stats().reused > 0
+    gol_engine.trim_arena()
+    assert gol_engine.arena_stats().pooled == 0
+
+
+def test_mapped_grid(tmp_path):
+    path = str(tmp_path / "big.golsnap")
+    g = gol_engine.Grid(500, 300)
+    g.randomize(0.3, 6)
+    mapped = gol_engine.MappedGrid(path, 500, 300)
+    mapped.resident_limit = 1
+    mapped.randomize(0.3, 6)
+    g.step_n(12)
+    mapped.step_n(12)
+    assert mapped.population == g.population
+    assert gol_engine.to_rle(mapped) == gol_engine.to_rle(g)
+    assert mapped.extract(0, 0, 500, 300).state_hash() == g.state_hash()
+    mapped.sync()
+    assert gol_engine.load_snapshot(path).state_hash() == g.state_hash()
+
+
 if __name__ == "__main__":
     pytest.main([__file__, "-v"])